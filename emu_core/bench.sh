@@ -0,0 +1,5 @@
+./build/bench/ScalerBench
+./build/bench/ApuBench
+./build/bench/ResamplerBench
+./build/bench/MapperBench
+./build/bench/SaveStateBench
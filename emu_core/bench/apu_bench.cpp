@@ -0,0 +1,93 @@
+#include <iostream>
+#include <chrono>
+#include <ctime>
+#include <format>
+#include "audio/apu.hpp"
+
+/**
+ * Emulated seconds of audio per real second, with all four channels playing.
+ * Samples are synthesized and thrown away, this only times the APU itself. The null sink is timed too, that's
+ * what headless runs use. Threaded mode counts the emulation thread's CPU time only, that's what is left on it
+ * (the audio thread does the rest and is timed by the mixing line).
+ */
+static constexpr int EMULATED_SECONDS = 20;
+static constexpr int M_CYCLES_PER_SECOND = 1048576;
+static constexpr int M_CYCLES_PER_DIV_APU = 2048; // DIV bit 4 falls at 512 Hz
+
+// Wants every sample, unlike NullAudioSink which makes the APU skip mixing
+class DiscardSink : public AudioSink {
+    public:
+        void play_samples(const int16_t*, int) override {}
+};
+
+void start_all_channels(APU& apu) {
+    apu.apu_io_write(0xFF26, 0x80); // NR52 on
+    apu.apu_io_write(0xFF24, 0x77);
+    apu.apu_io_write(0xFF25, 0xFF);
+
+    apu.apu_io_write(0xFF10, 0x16); // sweep
+    apu.apu_io_write(0xFF11, 0x80);
+    apu.apu_io_write(0xFF12, 0xF3);
+    apu.apu_io_write(0xFF13, 0x73);
+    apu.apu_io_write(0xFF14, 0x86);
+
+    apu.apu_io_write(0xFF16, 0x40);
+    apu.apu_io_write(0xFF17, 0xF0);
+    apu.apu_io_write(0xFF18, 0xD6);
+    apu.apu_io_write(0xFF19, 0x87);
+
+    for (uint16_t addr = 0xFF30; addr <= 0xFF3F; addr++) apu.apu_io_write(addr, (addr & 1) ? 0x01 : 0xEF);
+    apu.apu_io_write(0xFF1A, 0x80);
+    apu.apu_io_write(0xFF1C, 0x20);
+    apu.apu_io_write(0xFF1D, 0x06);
+    apu.apu_io_write(0xFF1E, 0x87);
+
+    apu.apu_io_write(0xFF21, 0xF0);
+    apu.apu_io_write(0xFF22, 0x21);
+    apu.apu_io_write(0xFF23, 0x80);
+}
+
+// CPU time of the calling thread
+double thread_seconds() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+double emulated_seconds_per_second(AudioSink& sink, bool threaded = false) {
+    APU apu(sink);
+    apu.set_threaded(threaded);
+    apu.init();
+    start_all_channels(apu);
+
+    // CPU instructions take 1 to 6 M cycles, cycle through a typical mix
+    static constexpr int INSTRUCTION_CYCLES[8] = {1, 2, 1, 3, 2, 4, 1, 2};
+
+    auto start = std::chrono::steady_clock::now();
+    double start_cpu = thread_seconds();
+    long long total = static_cast<long long>(EMULATED_SECONDS) * M_CYCLES_PER_SECOND;
+    int div_counter = 0;
+    for (long long cycles = 0, i = 0; cycles < total; i++) {
+        int m_cycles = INSTRUCTION_CYCLES[i & 7];
+        div_counter += m_cycles;
+        bool div_tick = div_counter >= M_CYCLES_PER_DIV_APU;
+        if (div_tick) div_counter -= M_CYCLES_PER_DIV_APU;
+        apu.tick(m_cycles, div_tick);
+        cycles += m_cycles;
+    }
+    double elapsed = threaded ? thread_seconds() - start_cpu
+                              : std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    apu.close();
+    return EMULATED_SECONDS / elapsed;
+}
+
+int main() {
+    std::cout << "----------------Running APU Benchmarks----------------" << std::endl;
+    DiscardSink discard;
+    NullAudioSink null_sink;
+    std::cout << std::format("mixing:    {:.1f}x real time\n", emulated_seconds_per_second(discard));
+    std::cout << std::format("null sink: {:.1f}x real time\n", emulated_seconds_per_second(null_sink));
+    std::cout << std::format("threaded:  {:.1f}x real time (emulation thread)\n",
+                             emulated_seconds_per_second(discard, true));
+    return 0;
+}
@@ -0,0 +1,49 @@
+#include <iostream>
+#include <chrono>
+#include <format>
+#include <vector>
+#include "core/mapper.hpp"
+
+/**
+ * Cart reads the way games do them, with a bank switch every few reads (music drivers and
+ * streaming code flip banks constantly). Should be the same speed whatever the ROM size.
+ */
+static constexpr int ITERATIONS = 20000000;
+static constexpr int READS_PER_SWITCH = 8;
+
+double ns_per_access(uint8_t cart_type, size_t rom_banks) {
+    std::vector<uint8_t> rom(rom_banks * Mapper::ROM_BANK_SIZE);
+    for (size_t i = 0; i < rom.size(); i++) rom[i] = static_cast<uint8_t>(i * 31 + (i >> 14));
+    std::vector<uint8_t> ram(4 * Mapper::RAM_BANK_SIZE, 0);
+    auto mapper = make_mapper(cart_type, rom, ram);
+    mapper->write_register(0x0000, 0x0A);
+
+    uint32_t sum = 0;
+    uint16_t addr = 0x4000;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        if (i % READS_PER_SWITCH == 0) {
+            mapper->write_register(0x2000, static_cast<uint8_t>(i >> 3));
+            mapper->write_register(0x4000, static_cast<uint8_t>(i >> 5) & 0x03);
+        }
+        addr = 0x4000 | ((addr + 0x0123) & 0x3FFF);
+        sum += mapper->read_rom(addr) + mapper->read_rom(addr & 0x3FFF);
+        mapper->write_ram(0xA000 | (addr & 0x1FFF), static_cast<uint8_t>(sum));
+        sum += mapper->read_ram(0xA000 | (addr & 0x1FFF));
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (sum == 0x12345678) std::cout << "";
+    // The register writes count as accesses too
+    long long accesses = ITERATIONS * 4LL + ITERATIONS / READS_PER_SWITCH * 2;
+    return elapsed * 1e9 / accesses;
+}
+
+int main() {
+    std::cout << "----------------Running Mapper Benchmarks----------------" << std::endl;
+    std::cout << std::format("MBC1  64 KB: {:.2f} ns/access\n", ns_per_access(0x03, 4));
+    std::cout << std::format("MBC1   2 MB: {:.2f} ns/access\n", ns_per_access(0x03, 128));
+    std::cout << std::format("MBC3   2 MB: {:.2f} ns/access\n", ns_per_access(0x13, 128));
+    std::cout << std::format("MBC5  32 KB: {:.2f} ns/access\n", ns_per_access(0x1B, 2));
+    std::cout << std::format("MBC5   8 MB: {:.2f} ns/access\n", ns_per_access(0x1B, 512));
+    return 0;
+}
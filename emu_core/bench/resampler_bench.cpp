@@ -0,0 +1,61 @@
+#include <iostream>
+#include <chrono>
+#include <format>
+#include <random>
+#include <vector>
+#include "audio/apu.hpp"
+#include "audio/resampler.hpp"
+
+/**
+ * Resampler throughput for every quality preset and instruction set this CPU supports, converting the APU's
+ * internal rate to the usual device rates. Input arrives in the same 128 frame blocks the APU hands over.
+ */
+static constexpr int EMULATED_SECONDS = 20;
+static constexpr int BLOCK_FRAMES = 128;
+
+std::vector<int16_t> make_block() {
+    // Square waves plus noise, about what the channels sound like
+    std::mt19937 rng(42);
+    std::vector<int16_t> block(BLOCK_FRAMES * 2);
+    for (int i = 0; i < BLOCK_FRAMES; i++) {
+        int noise = static_cast<int>(rng() % 2001) - 1000;
+        block[i * 2] = static_cast<int16_t>(((i / 16) % 2 ? 6000 : -6000) + noise);
+        block[i * 2 + 1] = static_cast<int16_t>(((i / 5) % 2 ? 4000 : -4000) - noise);
+    }
+    return block;
+}
+
+// Emulated seconds of audio resampled per real second
+double bench(ResamplerQuality quality, ResamplerIsa isa, double output_rate, const std::vector<int16_t>& block) {
+    Resampler resampler(APU::INTERNAL_RATE, output_rate, quality, isa);
+    std::vector<int16_t> out;
+    long long blocks = static_cast<long long>(EMULATED_SECONDS * APU::INTERNAL_RATE) / BLOCK_FRAMES;
+    long long produced = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (long long i = 0; i < blocks; i++) {
+        produced += resampler.process(block.data(), BLOCK_FRAMES, out);
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (produced == 0) return 0;
+    return EMULATED_SECONDS / elapsed;
+}
+
+int main() {
+    std::vector<int16_t> block = make_block();
+
+    std::cout << "----------------Running Resampler Benchmarks----------------" << std::endl;
+    std::cout << std::format("{:<8} {:>5} {:<7} {:>12} {:>12} {:>12}\n", "quality", "taps", "isa",
+                             "44.1 kHz", "48 kHz", "96 kHz");
+
+    for (ResamplerQuality quality : {ResamplerQuality::FAST, ResamplerQuality::MEDIUM, ResamplerQuality::HIGH}) {
+        for (ResamplerIsa isa : Resampler::supported_isas()) {
+            int taps = Resampler(APU::INTERNAL_RATE, 48000, quality, isa).taps();
+            std::cout << std::format("{:<8} {:>5} {:<7} {:>11.0f}x {:>11.0f}x {:>11.0f}x\n",
+                                     Resampler::quality_name(quality), taps, Resampler::isa_name(isa),
+                                     bench(quality, isa, 44100, block), bench(quality, isa, 48000, block),
+                                     bench(quality, isa, 96000, block));
+        }
+    }
+    return 0;
+}
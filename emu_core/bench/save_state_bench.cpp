@@ -0,0 +1,52 @@
+#include <iostream>
+#include <chrono>
+#include <format>
+#include <vector>
+#include "core/save_state.hpp"
+
+/**
+ * Saving and loading a whole machine, with the most cart RAM there is (MBC5, 128 KB) so the state is as big as it
+ * gets. Both should stay far below a millisecond, hotkeys run them between two frames.
+ */
+static constexpr int ITERATIONS = 2000;
+
+int main() {
+    std::cout << "----------------Running Save State Benchmarks----------------" << std::endl;
+    std::vector<uint8_t> rom(0x8000, 0);
+    rom[0x0100] = 0x18; // JR -2
+    rom[0x0101] = 0xFE;
+    rom[0x0147] = 0x1B; // MBC5 + RAM + battery
+    rom[0x0149] = 0x04; // 128 KB
+
+    Cart cart;
+    cart.loadFromData(rom);
+    PPU ppu;
+    NullAudioSink sink;
+    APU apu(sink);
+    apu.init();
+    Timer timer;
+    Bus bus(cart, ppu, timer, apu);
+    Registers registers;
+    CPU cpu(bus, registers);
+    SaveState state(cpu, bus, cart, ppu, timer, apu);
+    for (int i = 0; i < 100000; i++) {
+        int cycles = cpu.step();
+        bool apu_div_tick = timer.tick(cycles);
+        ppu.tick(cycles);
+        apu.tick(cycles, apu_div_tick);
+    }
+
+    std::vector<uint8_t> saved;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) saved = state.save();
+    double save_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) state.load(saved);
+    double load_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << std::format("State size: {} KB\n", saved.size() / 1024);
+    std::cout << std::format("Save: {:.1f} us\n", save_us / ITERATIONS);
+    std::cout << std::format("Load: {:.1f} us\n", load_us / ITERATIONS);
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <random>
+#include <thread>
+#include <vector>
+#include "graphics/scaler.hpp"
+
+/**
+ * Time per frame for every filter at 2x/3x/4x, for each instruction set this CPU supports,
+ * single threaded and with the worker count the Screen uses.
+ */
+static constexpr int WIDTH = 160;
+static constexpr int HEIGHT = 144;
+static constexpr int FRAMES = 2000;
+
+std::vector<uint8_t> make_frame() {
+    // Blocky shapes with some noise, so the edge rules actually have something to do
+    std::mt19937 rng(42);
+    std::vector<uint8_t> frame(WIDTH * HEIGHT);
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            frame[y * WIDTH + x] = ((x / 6) + (y / 9) + (rng() % 11 == 0)) % 4;
+        }
+    }
+    return frame;
+}
+
+double bench(ScaleFilter filter, int factor, int threads, ScalerIsa isa, const std::vector<uint8_t>& frame) {
+    Scaler scaler(filter, factor, WIDTH, HEIGHT, threads, isa);
+    std::vector<uint8_t> out(scaler.out_width() * scaler.out_height());
+    scaler.scale(frame.data(), out.data()); // warm up
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < FRAMES; i++) {
+        scaler.scale(frame.data(), out.data());
+    }
+    auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start);
+    return elapsed.count() / FRAMES;
+}
+
+int main() {
+    std::vector<uint8_t> frame = make_frame();
+    int workers = std::clamp(static_cast<int>(std::thread::hardware_concurrency()) - 2, 0, 3);
+
+    std::cout << "----------------Running Scaler Benchmarks----------------" << std::endl;
+    std::cout << std::format("{:<8} {:>6} {:<7} {:>14} {:>14}\n", "filter", "scale", "isa", "us/frame (1t)",
+                             std::format("us/frame ({}t)", workers + 1));
+
+    for (ScaleFilter filter : {ScaleFilter::NEAREST, ScaleFilter::SCALEX, ScaleFilter::XBR}) {
+        for (int factor = 2; factor <= 4; factor++) {
+            for (ScalerIsa isa : Scaler::supported_isas()) {
+                double single = bench(filter, factor, 0, isa, frame);
+                double pooled = bench(filter, factor, workers, isa, frame);
+                std::cout << std::format("{:<8} {:>5}x {:<7} {:>14.1f} {:>14.1f}\n", Scaler::filter_name(filter),
+                                         factor, Scaler::isa_name(isa), single, pooled);
+            }
+        }
+    }
+    return 0;
+}
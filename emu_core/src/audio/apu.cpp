@@ -1,5 +1,8 @@
 #include "apu.hpp"
+#include "apu_thread.hpp"
+#include "vgm_writer.hpp"
 
+#include <algorithm>
 #include <stdexcept>
 
 /**
@@ -13,90 +16,200 @@
  */
 
 
-APU::APU(Speaker& speaker) : speaker(speaker) {};
+APU::APU(AudioSink& sink) : sink(sink), mixing(sink.wants_samples()) {};
+
+APU::~APU() = default;
 
 void APU::init() {
     //write values for PC = 0x0100
-    channel1.write_nrx0(0x80);
-    channel1.write_nrx1(0xBF);
-    channel1.write_nrx2(0xF3);
-    channel1.write_nrx3(0xFF);
-    channel1.write_nrx4(0xBF);
-
-    channel2.write_nrx1(0x3F);
-    channel2.write_nrx2(0x00);
-    channel2.write_nrx3(0xFF);
-    channel2.write_nrx4(0xBF);
-
-    channel3.write_nr30(0x7F);
-    channel3.write_nr31(0xFF);
-    channel3.write_nr32(0x9F);
-    channel3.write_nr33(0xFF);
-    channel3.write_nr34(0xBF);
+    for (const RegisterWrite& reg : POST_BOOT_REGISTERS) write_register(reg.addr, reg.value);
 
-    channel4.write_nr41(0xFF);
-    channel4.write_nr42(0x00);
-    channel4.write_nr43(0x00);
-    channel4.write_nr44(0xBF);
+    if (threaded && mixing) {
+        // The worker owns the sink from here on, this APU only answers register reads
+        mixing = false;
+        worker = std::make_unique<ApuThread>(sink, resampler_quality, print_audio_stats);
+        return;
+    }
 
-    speaker.init();
+    sink.init();
+    // Only now do we know what rate the device settled on
+    double output_rate = sink.sample_rate();
+    resampler = Resampler(INTERNAL_RATE, output_rate, resampler_quality);
+    rate_control.set_nominal_rate(output_rate);
 }
 
+/**
+ * Channels are not stepped here, cycles are only counted. They catch up (sync) when a block of output is due,
+ * before the frame sequencer clocks them and before the CPU touches a register, which are the only points where
+ * their state is observed from outside.
+ */
 void APU::tick(int cycle, bool apu_div_tick) {
-    if (apu_div_tick) {
-        apu_div++;
-        // every 2 ticks
-        if (apu_div % 2 == 0) {
-            channel1.length_timer_tick();
-            channel2.length_timer_tick();
-            channel3.length_timer_tick();
-            channel4.length_timer_tick();
-        }
+    cycles += cycle;
+    if (worker) {
+        // Lengths and sweep still run here, NR52 reads need them. Channels never step on this thread.
+        if (apu_div_tick && powered) frame_sequencer_tick();
+        worker->tick(cycle, apu_div_tick);
+        return;
+    }
+
+    // Powered off the frame sequencer is held in reset, only the output clock keeps going (silence)
+    if (apu_div_tick && powered) frame_sequencer_tick();
+
+    pending_cycles += cycle;
+    if (block_time + pending_cycles >= BLOCK_CYCLES) {
+        sync();
+        if (mixing) end_block();
+    }
+}
 
-        // Sweep (128 Hz) every 4 ticks
-        if (apu_div == 2 || apu_div == 6) {
-            channel1.period_sweep_tick();
-        }
+void APU::frame_sequencer_tick() {
+    sync();
+    apu_div++;
+    // every 2 ticks
+    if (apu_div % 2 == 0) {
+        channel1.length_timer_tick();
+        channel2.length_timer_tick();
+        channel3.length_timer_tick();
+        channel4.length_timer_tick();
+    }
 
-        // Envelope (64 Hz) every 8 ticks
-        if (apu_div == 7) {
-            channel1.volume_envelope_tick();
-            channel2.volume_envelope_tick();
-            channel4.env_sweep_tick();
-            apu_div = 0;
-        }
+    // Sweep (128 Hz) every 4 ticks
+    if (apu_div == 2 || apu_div == 6) {
+        channel1.period_sweep_tick();
     }
 
-    bool enabled = check_master_enable();
-    if (!enabled) {
-        speaker.pause();
-    } else {
-        speaker.unpause();
+    // Envelope (64 Hz) every 8 ticks
+    if (apu_div == 7) {
+        channel1.volume_envelope_tick();
+        channel2.volume_envelope_tick();
+        channel4.env_sweep_tick();
+        apu_div = 0;
     }
+    update_output();
+}
+
+void APU::bump_div() {
+    apu_div++;
+    if (worker) worker->bump_div();
+}
 
-    for (int i = 0; i < cycle; i++) {
-        tick_cycle();
+// Channels catch up first, a state has no pending cycles
+void APU::serialize(StateWriter& out) {
+    sync();
+    out.begin_section("APU ");
+    channel1.serialize(out);
+    channel2.serialize(out);
+    channel3.serialize(out);
+    channel4.serialize(out);
+    out.fields(nr21, nr22, nr23, nr24, nr30, nr31, nr32, nr33, nr34, nr41, nr42, nr43, nr44, nr50, nr51);
+    out.fields(powered, apu_div);
+    out.end_section();
+}
+
+void APU::deserialize(StateReader& in) {
+    size_t start = in.offset();
+    sync(); // the old state's output up to now
+    bool was_powered = powered;
+    in.begin_section("APU ");
+    channel1.deserialize(in);
+    channel2.deserialize(in);
+    channel3.deserialize(in);
+    channel4.deserialize(in);
+    in.fields(nr21, nr22, nr23, nr24, nr30, nr31, nr32, nr33, nr34, nr41, nr42, nr43, nr44, nr50, nr51);
+    in.fields(powered, apu_div);
+    in.end_section();
+
+    if (worker) {
+        worker->load_state(in.data().subspan(start, in.offset() - start));
+    } else if (powered != was_powered) {
+        if (powered) sink.unpause();
+        else sink.pause();
     }
+    update_output();
 }
 
-void APU::tick_cycle() {
-    channel1.tick();
-    channel2.tick();
-    channel3.tick();
-    channel4.tick();
+void APU::close() {
+    if (worker) {
+        worker->stop();
+    } else if (mixing) {
+        sync();
+        end_block();
+    }
+    if (register_log) register_log->close(cycles);
+}
 
-    // collect samples
-     sample_accumulator += 1.0;
-    if (sample_accumulator >= SAMPLE_RATE) {
-        mix_and_sample();
-        sample_accumulator -=  SAMPLE_RATE;
+/**
+ * Runs the channels over the pending cycles. Spans end wherever an audible channel's output can change, so every
+ * level change lands in the blip buffers at its exact cycle. Silent channels still advance (all but those with their
+ * DAC off), they just never split a span.
+ */
+void APU::sync() {
+    int remaining = pending_cycles;
+    pending_cycles = 0;
+    if (!powered) {
+        // Nothing to run, the output already sits at 0 since the power off edge
+        if (mixing) block_time += remaining;
+        return;
+    }
+    if (!mixing) {
+        // Nobody listens: keep channel state right (registers, NR52 status) but don't synthesize anything
+        advance_channels(remaining);
+        return;
+    }
+    while (remaining > 0) {
+        int span = remaining;
+        if (channel1.audible()) span = std::min(span, channel1.cycles_to_step());
+        if (channel2.audible()) span = std::min(span, channel2.cycles_to_step());
+        if (channel3.audible()) span = std::min(span, channel3.cycles_to_step());
+        if (channel4.audible()) span = std::min(span, channel4.cycles_to_step());
+
+        advance_channels(span);
+        remaining -= span;
+        block_time += span;
+        update_output();
     }
 }
 
+void APU::advance_channels(int cycles) {
+    if (channel1.dac_enabled()) channel1.advance(cycles);
+    if (channel2.dac_enabled()) channel2.advance(cycles);
+    if (channel3.dac_enabled()) channel3.advance(cycles);
+    if (channel4.dac_enabled()) channel4.advance(cycles);
+}
+
 
-void APU::mix_and_sample() {
-    int16_t left_stereo = 0;
-    int16_t right_stereo = 0;
+void APU::end_block() {
+    left_blip.end_frame(block_time);
+    right_blip.end_frame(block_time);
+    block_time = 0;
+
+    int count = left_blip.samples_avail();
+    native_samples.resize(count * 2);
+    left_blip.read_samples(native_samples.data(), count, 2);
+    right_blip.read_samples(native_samples.data() + 1, count, 2);
+    int frames = resampler.process(native_samples.data(), count, block_samples);
+    sink.play_samples(block_samples.data(), frames);
+
+    // A paused device isn't draining, its fill level says nothing until the APU is powered back on
+    if (!powered) return;
+    // Nudge the next block's sample rate to keep a real time sink's buffer near its target fill
+    int buffered = sink.buffered_frames();
+    if (buffered < 0) return;
+    double rate = rate_control.update(frames, buffered, sink.target_buffered_frames(), sink.underruns());
+    resampler.set_output_rate(rate);
+}
+
+void APU::update_output() {
+    if (!mixing) return;
+    if (!powered) {
+        left_blip.add_delta(block_time, -left_level);
+        right_blip.add_delta(block_time, -right_level);
+        left_level = 0;
+        right_level = 0;
+        return;
+    }
+    int left_stereo = 0;
+    int right_stereo = 0;
 
     int16_t ch1_sample = channel1.sample();
     int16_t ch2_sample = channel2.sample();
@@ -126,10 +239,15 @@ void APU::mix_and_sample() {
     // for 2 channels max is 1200, so each vale
     left_stereo = (left_stereo * (master_volume_left + 1)) / 8;
     right_stereo = (right_stereo * (master_volume_right + 1)) / 8;
-    speaker.play_sample(left_stereo, right_stereo);
+
+    left_blip.add_delta(block_time, left_stereo - left_level);
+    right_blip.add_delta(block_time, right_stereo - right_level);
+    left_level = left_stereo;
+    right_level = right_stereo;
 }
 
 uint8_t APU::apu_io_read(uint16_t addr) {
+    sync();
     switch (addr) {
         case 0xFF10: return channel1.read_nrx0();
         case 0xFF11: return channel1.read_nrx1();
@@ -154,7 +272,7 @@ uint8_t APU::apu_io_read(uint16_t addr) {
 
         case 0xFF24: return nr50;
         case 0xFF25: return nr51;
-        case 0xFF26: return nr52;
+        case 0xFF26: return read_nr52();
         default:
     }
 
@@ -164,6 +282,25 @@ uint8_t APU::apu_io_read(uint16_t addr) {
 }
 
 void APU::apu_io_write(uint16_t addr, uint8_t data) {
+    if (worker) worker->write(addr, data);
+    if (register_log) register_log->write(cycles, addr, data);
+    sync();
+    write_register(addr, data);
+    update_output(); // volume, panning, triggers and DAC switches change the level right away
+}
+
+/**
+ * Attach right after init(). The post boot state goes in first (power on, then the registers init() set), so
+ * any player starts from the same registers we do.
+ */
+void APU::set_register_log(VgmWriter* log) {
+    register_log = log;
+    if (!register_log) return;
+    register_log->write(cycles, 0xFF26, 0x80);
+    for (const RegisterWrite& reg : POST_BOOT_REGISTERS) register_log->write(cycles, reg.addr, reg.value);
+}
+
+void APU::write_register(uint16_t addr, uint8_t data) {
     switch (addr) {
 
         case 0xFF10: channel1.write_nrx0(data); break;
@@ -190,7 +327,7 @@ void APU::apu_io_write(uint16_t addr, uint8_t data) {
 
         case 0xFF24: nr50 = data; break;
         case 0xFF25: nr51 = data; break;
-        case 0xFF26: nr52 = (data & 0xF0) | (nr52 & 0x0F); break; //lower nibble is READ ONLY
+        case 0xFF26: set_power(data & 0x80); break; // lower nibble is READ ONLY
 
         default:
     }
@@ -200,6 +337,33 @@ void APU::apu_io_write(uint16_t addr, uint8_t data) {
     }
 }
 
-bool APU::check_master_enable() const {
-    return (nr52 & 0x80) != 0;
+/**
+ * NR52 bit 7. The audio device is only touched here, on an actual edge: games rewrite NR52 with the same value all
+ * the time and the old per tick check paused/unpaused it on every instruction.
+ * Powering off stops every channel and clears the mixer registers, powering on restarts the frame sequencer.
+ */
+void APU::set_power(bool on) {
+    if (on == powered) return;
+    powered = on;
+    if (on) {
+        apu_div = 0;
+        if (!worker) sink.unpause();
+        return;
+    }
+    channel1.disable();
+    channel2.disable();
+    channel3.disable();
+    channel4.disable();
+    nr50 = 0;
+    nr51 = 0;
+    if (!worker) sink.pause();
+}
+
+// Bit 7 power, bits 6-4 unused (read 1), bits 3-0 which channels are on
+uint8_t APU::read_nr52() const {
+    return (static_cast<uint8_t>(powered) << 7) | 0x70 |
+           (static_cast<uint8_t>(channel4.active()) << 3) |
+           (static_cast<uint8_t>(channel3.active()) << 2) |
+           (static_cast<uint8_t>(channel2.active()) << 1) |
+            static_cast<uint8_t>(channel1.active());
 }
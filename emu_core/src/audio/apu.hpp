@@ -1,31 +1,105 @@
 #pragma once
 #include <cstdint>
-#include <SDL2/SDL_audio.h>
+#include <memory>
+#include <vector>
 #include "square_channel.hpp"
-#include "speaker.hpp"
+#include "audio_sink.hpp"
 #include "wave_channel.hpp"
 #include "noise_channel.hpp"
+#include "blip_buffer.hpp"
+#include "rate_control.hpp"
+#include "resampler.hpp"
+#include "../core/state_io.hpp"
+
+class ApuThread;
+class VgmWriter;
 
 class APU {
     public:
-        APU(Speaker& speaker);
+        APU(AudioSink& sink);
+        ~APU();
         uint8_t apu_io_read(uint16_t addr);
         void apu_io_write(uint16_t addr, uint8_t data);
         void init();
         void tick(int cycle, bool apu_div_tick);
+        // A DIV write moved the frame sequencer counter
+        void bump_div();
+        // Plays the last partial block, stops the audio thread (if any) once everything logged is played and
+        // finishes the register log. Call it before closing the sink.
+        void close();
+
+        struct RegisterWrite {
+            uint16_t addr;
+            uint8_t value;
+        };
+        // What the boot ROM leaves in the sound registers, init() starts from this
+        static constexpr RegisterWrite POST_BOOT_REGISTERS[] = {
+            {0xFF24, 0x77}, {0xFF25, 0xF3},
+            {0xFF10, 0x80}, {0xFF11, 0xBF}, {0xFF12, 0xF3}, {0xFF13, 0xFF}, {0xFF14, 0xBF},
+            {0xFF16, 0x3F}, {0xFF17, 0x00}, {0xFF18, 0xFF}, {0xFF19, 0xBF},
+            {0xFF1A, 0x7F}, {0xFF1B, 0xFF}, {0xFF1C, 0x9F}, {0xFF1D, 0xFF}, {0xFF1E, 0xBF},
+            {0xFF20, 0xFF}, {0xFF21, 0x00}, {0xFF22, 0x00}, {0xFF23, 0xBF},
+        };
+
+        // Streams every register write with its cycle (see VgmWriter), nullptr stops logging
+        void set_register_log(VgmWriter* log);
+        /**
+         * Save states: channels, registers and the frame sequencer. The output side (blip buffers, resampler, what
+         * the sink has queued) just carries on, a load is heard as a cut, not a gap. With the audio thread the
+         * state is forwarded to it and applied at the same cycle. (Channels never step on this side then, so a
+         * state saved that way restarts each waveform at the phase it had when last written, which nobody hears.)
+         */
+        void serialize(StateWriter& out);
+        void deserialize(StateReader& in);
+
+        // M cycles ticked since power on
+        uint64_t cycle_count() const { return cycles; }
 
-        // 21.8453 M Cycles = 1048576.0 Hz / M Cycles ÷ 48,000 HZ (sample rate we desire)
-        static constexpr float SAMPLE_RATE = 1048576.0f / 48000.0f;
+        // These go before init(), that's when the sink's rate is known and the filter gets designed
+        void set_print_audio_stats(bool print) { print_audio_stats = print; rate_control.set_print_stats(print); }
+        void set_resampler_quality(ResamplerQuality quality) { resampler_quality = quality; }
+        // Synthesize on an audio thread (see ApuThread), this APU then only keeps register state for reads
+        void set_threaded(bool enable) { threaded = enable; }
+
+        static constexpr double CLOCK_RATE = 1048576.0; // M cycles per second
+        // Channels are mixed at this rate, then resampled to whatever the sink runs at
+        static constexpr double INTERNAL_RATE = CLOCK_RATE / 16;
+        // Output is produced in blocks of this many M cycles (128 internal frames, 2ms)
+        static constexpr int BLOCK_CYCLES = 2048;
         static constexpr int MAX_CHANNEL_VOL_FACTOR = 500;
 
         uint8_t apu_div{0};
     private:
-        Speaker& speaker;
-        void tick_cycle();
+        AudioSink& sink;
+        bool mixing; // false for sinks that discard audio, and when the worker does it
+        bool threaded{false};
+        bool print_audio_stats{false};
+        std::unique_ptr<ApuThread> worker;
+        VgmWriter* register_log{nullptr};
+        uint64_t cycles{0};
+
+        // The register side of a write: no sync, no output update, no logging
+        void write_register(uint16_t addr, uint8_t data);
+
+        void frame_sequencer_tick();
+        void sync();
+        void advance_channels(int cycles);
+        void end_block();
 
-        void mix_and_sample();
+        // Recomputes the mixed output level and records any change as a delta at the current time
+        void update_output();
 
-        float sample_accumulator{0};
+        BlipBuffer left_blip{CLOCK_RATE, INTERNAL_RATE, 1024};
+        BlipBuffer right_blip{CLOCK_RATE, INTERNAL_RATE, 1024};
+        std::vector<int16_t> native_samples; // interleaved L/R at INTERNAL_RATE
+        std::vector<int16_t> block_samples;  // interleaved L/R at the sink's rate, handed to the sink
+        ResamplerQuality resampler_quality{ResamplerQuality::MEDIUM};
+        Resampler resampler{INTERNAL_RATE, AudioSink::DEFAULT_SAMPLE_RATE};
+        RateControl rate_control{AudioSink::DEFAULT_SAMPLE_RATE};
+        int pending_cycles{0};  // M cycles the channels haven't run yet
+        uint32_t block_time{0}; // M cycles since the current block started
+        int left_level{0};
+        int right_level{0};
 
         SquareChannel channel1;
         SquareChannel channel2;
@@ -54,10 +128,10 @@ class APU {
 
         uint8_t nr50{0x77};
         uint8_t nr51{0xF3};
-        uint8_t nr52{0xF1};
-    ;
+        bool powered{true}; // NR52 bit 7
 
-        bool check_master_enable() const;
+        void set_power(bool on);
+        uint8_t read_nr52() const;
 
         void mixer();
 };
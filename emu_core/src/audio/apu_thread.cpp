@@ -0,0 +1,107 @@
+#include "apu_thread.hpp"
+
+ApuThread::ApuThread(AudioSink& sink, ResamplerQuality quality, bool print_stats) : synth(sink) {
+    synth.set_resampler_quality(quality);
+    synth.set_print_audio_stats(print_stats);
+    synth.init();
+    thread = std::thread([this] { run(); });
+}
+
+ApuThread::~ApuThread() {
+    stop();
+}
+
+// Once per block: lets the audio thread produce output up to now and wakes it up
+void ApuThread::publish() {
+    last_sync = now;
+    push({now, 0, 0, ApuEvent::SYNC});
+    published.fetch_add(1, std::memory_order_release);
+    published.notify_one();
+}
+
+// Writes land during an instruction, before its cycles are ticked
+void ApuThread::write(uint16_t addr, uint8_t value) {
+    push({now, addr, value, ApuEvent::WRITE});
+}
+
+void ApuThread::bump_div() {
+    push({now, 0, 0, ApuEvent::DIV_BUMP});
+}
+
+void ApuThread::load_state(std::span<const uint8_t> state) {
+    {
+        std::lock_guard<std::mutex> lock(states_mutex);
+        states.emplace_back(state.begin(), state.end());
+    }
+    push({now, 0, 0, ApuEvent::STATE});
+}
+
+// Never drops anything, a dropped write would desync the two APUs for good. Waits for room instead.
+void ApuThread::push(ApuEvent event) {
+    while (true) {
+        uint64_t seen = consumed.load(std::memory_order_acquire);
+        if (events.write(&event, 1) == 1) return;
+        published.fetch_add(1, std::memory_order_release);
+        published.notify_one();
+        consumed.wait(seen, std::memory_order_acquire);
+    }
+}
+
+void ApuThread::stop() {
+    if (!thread.joinable()) return;
+    publish(); // the cycles since the last SYNC
+    running.store(false, std::memory_order_release);
+    published.fetch_add(1, std::memory_order_release);
+    published.notify_one();
+    thread.join();
+    synth.close();
+}
+
+void ApuThread::run() {
+    constexpr size_t BATCH = 256;
+    ApuEvent batch[BATCH];
+    while (true) {
+        uint64_t seen = published.load(std::memory_order_acquire);
+        size_t count = events.read(batch, BATCH);
+        if (count > 0) {
+            consumed.fetch_add(1, std::memory_order_release);
+            consumed.notify_one();
+        }
+        for (size_t i = 0; i < count; i++) replay(batch[i]);
+        if (count > 0) continue;
+
+        if (!running.load(std::memory_order_acquire)) {
+            // stop() comes after the last push, drain whatever is left and finish
+            while ((count = events.read(batch, BATCH)) > 0) {
+                for (size_t i = 0; i < count; i++) replay(batch[i]);
+            }
+            return;
+        }
+        published.wait(seen, std::memory_order_acquire);
+    }
+}
+
+void ApuThread::replay(const ApuEvent& event) {
+    if (event.time > synth_time) {
+        synth.tick(static_cast<int>(event.time - synth_time), false);
+        synth_time = event.time;
+    }
+    switch (event.kind) {
+        case ApuEvent::WRITE: synth.apu_io_write(event.addr, event.value); break;
+        case ApuEvent::DIV_TICK: synth.tick(0, true); break;
+        case ApuEvent::DIV_BUMP: synth.apu_div++; break;
+        case ApuEvent::SYNC: break;
+        case ApuEvent::STATE: {
+            std::vector<uint8_t> state;
+            {
+                std::lock_guard<std::mutex> lock(states_mutex);
+                state = std::move(states.front());
+                states.pop_front();
+            }
+            // Already read once by the emulation thread's APU, it can't be malformed
+            StateReader reader(state);
+            synth.deserialize(reader);
+            break;
+        }
+    }
+}
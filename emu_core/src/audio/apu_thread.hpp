@@ -0,0 +1,82 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <span>
+#include <thread>
+#include "apu.hpp"
+#include "spsc_ring.hpp"
+
+/**
+ * Everything the channels need to hear from the emulation thread, stamped with the M cycle it happened on.
+ * Register writes are rare next to cycles, so a log of them is all it takes to replay the APU somewhere else.
+ */
+struct ApuEvent {
+    enum Kind : uint8_t {
+        WRITE,    // addr, value: FF10-FF3F
+        DIV_TICK, // frame sequencer step
+        DIV_BUMP, // a DIV write moved the frame sequencer counter without stepping it
+        SYNC,     // nothing happened, time just passed (once per block so output keeps flowing)
+        STATE     // a save state was loaded, the next one queued by load_state
+    };
+
+    uint64_t time;
+    uint16_t addr;
+    uint8_t value;
+    Kind kind;
+};
+
+/**
+ * Runs the synthesis half of the APU (channels, mixing, resampling, the sink) on its own thread.
+ *
+ * The emulation thread keeps its own APU for register reads and NR52 status, that one runs the frame sequencer but
+ * never steps a channel or mixes. It appends every write and frame sequencer tick here, and a full APU on the audio
+ * thread replays them at the same cycles, so the output is the same as running it inline.
+ */
+class ApuThread {
+    public:
+        static constexpr size_t EVENT_CAPACITY = 1 << 14;
+
+        ApuThread(AudioSink& sink, ResamplerQuality quality, bool print_stats);
+        ~ApuThread();
+
+        // Emulation thread, same meaning as APU::tick / apu_io_write. tick runs every instruction, keep it inline.
+        // A frame sequencer tick belongs before the instruction's cycles, same order as APU::tick.
+        void tick(int cycles, bool div_tick) {
+            if (div_tick) push({now, 0, 0, ApuEvent::DIV_TICK});
+            now += cycles;
+            if (now - last_sync >= APU::BLOCK_CYCLES) publish();
+        }
+        void write(uint16_t addr, uint8_t value);
+        void bump_div();
+        // The APU section of a save state the emulation thread just loaded
+        void load_state(std::span<const uint8_t> state);
+
+        // Replays everything logged up to now, plays the last partial block and stops the thread, before the sink
+        // is closed
+        void stop();
+
+    private:
+        APU synth;
+        SpscRing<ApuEvent> events{EVENT_CAPACITY};
+        std::atomic<uint64_t> published{0}; // bumped on every SYNC, the audio thread sleeps on it
+        std::atomic<uint64_t> consumed{0};  // bumped per batch read, a producer facing a full log sleeps on it
+        std::atomic<bool> running{true};
+        std::thread thread;
+        // Save states are rare and too big for an event, they wait here for their STATE event
+        std::mutex states_mutex;
+        std::deque<std::vector<uint8_t>> states;
+
+        // Emulation thread
+        uint64_t now{0};
+        uint64_t last_sync{0};
+
+        // Audio thread
+        uint64_t synth_time{0};
+
+        void push(ApuEvent event);
+        void publish();
+        void run();
+        void replay(const ApuEvent& event);
+};
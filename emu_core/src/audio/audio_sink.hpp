@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * Where the APU's output goes. Speaker plays it through SDL, WavWriter dumps it to a file and NullAudioSink
+ * throws it away (the APU then skips mixing altogether).
+ */
+class AudioSink {
+    public:
+        static constexpr int DEFAULT_SAMPLE_RATE = 48000;
+
+        virtual ~AudioSink() = default;
+
+        virtual void init() {}
+        // `frames` interleaved left/right samples
+        virtual void play_samples(const int16_t* samples, int frames) = 0;
+        // NR52 master switch
+        virtual void pause() {}
+        virtual void unpause() {}
+        virtual void close() {}
+
+        // False when nobody listens, the APU then only keeps channel state and never synthesizes output
+        virtual bool wants_samples() const { return true; }
+        // Output rate, only final after init()
+        virtual int sample_rate() const { return DEFAULT_SAMPLE_RATE; }
+        // Frames queued ahead of a real time consumer for rate control, -1 for sinks that take any amount
+        virtual int buffered_frames() const { return -1; }
+        virtual int target_buffered_frames() const { return 0; }
+        virtual uint64_t underruns() const { return 0; }
+};
+
+class NullAudioSink : public AudioSink {
+    public:
+        void play_samples(const int16_t*, int) override {}
+        bool wants_samples() const override { return false; }
+};
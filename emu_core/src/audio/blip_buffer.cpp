@@ -0,0 +1,102 @@
+#include "blip_buffer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <stdexcept>
+
+BlipBuffer::BlipBuffer(double clock_rate, double sample_rate, int max_samples)
+    : max_samples(max_samples),
+      buffer(max_samples + KERNEL_WIDTH, 0)
+{
+    set_rates(clock_rate, sample_rate);
+}
+
+void BlipBuffer::set_rates(double clock_rate, double sample_rate) {
+    if (sample_rate >= clock_rate) throw std::runtime_error("BlipBuffer needs a sample rate below the clock rate");
+    factor = static_cast<uint64_t>(std::llround(sample_rate / clock_rate * static_cast<double>(1ull << FRAC_BITS)));
+}
+
+/**
+ * One row per sub-sample phase. Tap i lands on output sample (delta sample + i), so the step is centered
+ * KERNEL_WIDTH / 2 - 1 samples late, a fixed ~0.15ms at 48 kHz.
+ * Cutoff sits a bit under Nyquist and each row is normalized so its taps sum exactly to 1 << KERNEL_BITS: the
+ * integrated step always settles on the exact delta and no DC error builds up.
+ */
+const BlipBuffer::Kernel& BlipBuffer::kernel() {
+    static const Kernel table = [] {
+        using std::numbers::pi;
+        constexpr double CUTOFF = 0.9;
+        constexpr double HALF = KERNEL_WIDTH / 2.0;
+        Kernel k{};
+        for (int p = 0; p < PHASES; p++) {
+            double frac = static_cast<double>(p) / PHASES;
+            double taps[KERNEL_WIDTH];
+            double sum = 0;
+            for (int i = 0; i < KERNEL_WIDTH; i++) {
+                double x = i - (HALF - 1) - frac;
+                double sinc = x == 0 ? 1.0 : std::sin(pi * CUTOFF * x) / (pi * CUTOFF * x);
+                double u = x / HALF;
+                double window = std::abs(u) >= 1 ? 0 : 0.42 + 0.5 * std::cos(pi * u) + 0.08 * std::cos(2 * pi * u);
+                taps[i] = sinc * window;
+                sum += taps[i];
+            }
+            int32_t total = 0;
+            int largest = 0;
+            for (int i = 0; i < KERNEL_WIDTH; i++) {
+                k[p][i] = static_cast<int32_t>(std::lround(taps[i] / sum * (1 << KERNEL_BITS)));
+                total += k[p][i];
+                if (k[p][i] > k[p][largest]) largest = i;
+            }
+            k[p][largest] += (1 << KERNEL_BITS) - total; // rounding leftovers
+        }
+        return k;
+    }();
+    return table;
+}
+
+void BlipBuffer::add_delta(uint32_t clock_time, int delta) {
+    if (delta == 0) return;
+    uint64_t pos = offset + clock_time * factor;
+    size_t index = static_cast<size_t>(pos >> FRAC_BITS);
+    if (index + KERNEL_WIDTH > buffer.size()) throw std::runtime_error("BlipBuffer frame is too long");
+
+    int phase = static_cast<int>(pos >> (FRAC_BITS - PHASE_BITS)) & (PHASES - 1);
+    const auto& taps = kernel()[phase];
+    int64_t* out = buffer.data() + index;
+    for (int i = 0; i < KERNEL_WIDTH; i++) {
+        out[i] += static_cast<int64_t>(taps[i]) * delta;
+    }
+}
+
+void BlipBuffer::end_frame(uint32_t clock_duration) {
+    offset += clock_duration * factor;
+    if (samples_avail() > max_samples) throw std::runtime_error("BlipBuffer overflow, read samples more often");
+}
+
+int BlipBuffer::read_samples(int16_t* out, int count, int stride) {
+    count = std::min(count, samples_avail());
+    if (count <= 0) return 0;
+
+    int64_t sum = integrator;
+    for (int i = 0; i < count; i++) {
+        int64_t sample = sum >> KERNEL_BITS;
+        out[i * stride] = static_cast<int16_t>(std::clamp<int64_t>(sample, INT16_MIN, INT16_MAX));
+        sum += buffer[i];
+        sum -= sample << (KERNEL_BITS - BASS_SHIFT);
+    }
+    integrator = sum;
+
+    // Drop what was read, deltas past it (the current frame's kernel tails) move to the front
+    size_t remaining = buffer.size() - count;
+    std::copy(buffer.begin() + count, buffer.end(), buffer.begin());
+    std::fill(buffer.begin() + remaining, buffer.end(), 0);
+    offset -= static_cast<uint64_t>(count) << FRAC_BITS;
+    return count;
+}
+
+void BlipBuffer::clear() {
+    offset = 0;
+    integrator = 0;
+    std::fill(buffer.begin(), buffer.end(), 0);
+}
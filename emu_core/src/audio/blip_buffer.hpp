@@ -0,0 +1,47 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Band limited synthesis, the same idea as blip_buf. Instead of point sampling a channel every ~21.8 M cycles
+ * (which aliases), the APU only reports when its output level changes: add_delta(clock_time, new - old).
+ * Each delta is spread over a few output samples with a windowed sinc kernel picked by the sub-sample position,
+ * read_samples integrates those back into a band limited signal at the output rate.
+ *
+ * Time is counted in input clocks (M cycles) from the start of the current frame. end_frame(n) closes a frame of n
+ * clocks and makes the samples it covers readable. Frames just need to be short enough for the buffer.
+ */
+class BlipBuffer {
+    public:
+        BlipBuffer(double clock_rate, double sample_rate, int max_samples);
+
+        // Only between frames (after end_frame), deltas already added keep the old rate
+        void set_rates(double clock_rate, double sample_rate);
+
+        void add_delta(uint32_t clock_time, int delta);
+        void end_frame(uint32_t clock_duration);
+
+        int samples_avail() const { return static_cast<int>(offset >> FRAC_BITS); }
+        // Writes up to count samples to out, `stride` apart (2 for interleaved stereo). Returns how many were read.
+        int read_samples(int16_t* out, int count, int stride = 1);
+        void clear();
+
+        static constexpr int KERNEL_WIDTH = 16;  // output samples touched by one delta
+        static constexpr int PHASE_BITS = 5;
+        static constexpr int PHASES = 1 << PHASE_BITS;
+        static constexpr int KERNEL_BITS = 15;   // taps of one phase sum to 1 << KERNEL_BITS
+        static constexpr int BASS_SHIFT = 9;     // DC blocking high pass, ~15 Hz at 48 kHz
+
+    private:
+        static constexpr int FRAC_BITS = 32;
+
+        using Kernel = std::array<std::array<int32_t, KERNEL_WIDTH>, PHASES>;
+        static const Kernel& kernel();
+
+        uint64_t factor{0};   // output samples per clock, FRAC_BITS fixed point
+        uint64_t offset{0};   // position of clock 0 of the current frame in the buffer, same fixed point
+        int max_samples;
+        int64_t integrator{0};
+        std::vector<int64_t> buffer;
+};
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+
+// M cycles until the divider next overflows
+template <typename T>
+inline int cycles_to_overflow(T div, int period) {
+    if (period < 1 || div >= static_cast<uint32_t>(period)) return 1;
+    return period - static_cast<int>(div);
+}
+
+/**
+ * Advances a channel's period divider by `cycles` in one go instead of one M cycle at a time.
+ * Same behavior as calling this `cycles` times:
+ *
+ *     div++;
+ *     if (div >= period) { div = 0; steps++; }
+ *
+ * Returns how many times the divider overflowed (duty steps, wave samples, LFSR shifts...).
+ * A period below 1 behaves like 1, the per cycle version would also overflow on every tick.
+ */
+template <typename T>
+inline int advance_divider(T& div, int period, int cycles) {
+    if (cycles <= 0) return 0;
+    if (period < 1) period = 1;
+
+    int steps = 0;
+    uint32_t current = div;
+    // The period can shrink below the counter when its register is rewritten, the next tick overflows right away
+    if (current >= static_cast<uint32_t>(period)) {
+        current = 0;
+        steps = 1;
+        cycles--;
+    }
+    uint32_t total = current + static_cast<uint32_t>(cycles);
+    steps += static_cast<int>(total / period);
+    div = static_cast<T>(total % period);
+    return steps;
+}
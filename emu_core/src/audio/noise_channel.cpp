@@ -1,15 +1,123 @@
 #include "noise_channel.hpp"
 
-void NoiseChannel::tick() {
+namespace {
+
+constexpr int PERIOD_15 = 32767;
+constexpr int PERIOD_7 = 127;
+constexpr uint16_t LOCKED = 0x7FFF; // all ones shifts into itself, in both widths
+
+// One LFSR shift. Bit 15 (and bit 7 in 7 bit mode) gets the XNOR of bits 0 and 1, then everything moves right
+uint16_t shift_lsfr(uint16_t lsfr, bool width_7) {
+    uint16_t bit = ~(lsfr ^ (lsfr >> 1)) & 0x01;
+    lsfr = (lsfr & 0x7FFF) | (bit << 15);
+    if (width_7) lsfr = (lsfr & 0xFF7F) | (bit << 7);
+    return lsfr >> 1;
+}
+
+/**
+ * Both LFSR widths are maximal length, so every state is just a position in one fixed cycle: 32767 states for 15
+ * bits, 127 for 7 bits. Advancing N shifts is then an index add, and for each position we also know how many
+ * shifts it takes for the output bit (bit 0) to flip.
+ *
+ * In 7 bit mode the upper bits keep shifting too, they only hold copies of recent low bits. Once 8 shifts went by
+ * the whole 15 bit register is a function of the low 7 bits, those are the states in the 7 bit table.
+ */
+struct LsfrTables {
+    uint16_t state_15[PERIOD_15];
+    int16_t index_15[0x8000];
+    uint8_t run_15[PERIOD_15];
+
+    uint16_t state_7[PERIOD_7];
+    int8_t index_7[0x80];
+    uint8_t run_7[PERIOD_7];
+
+    LsfrTables() {
+        uint16_t lsfr = 0; // what a trigger loads
+        for (int i = 0; i < 0x8000; i++) index_15[i] = -1;
+        for (int i = 0; i < PERIOD_15; i++) {
+            state_15[i] = lsfr;
+            index_15[lsfr] = static_cast<int16_t>(i);
+            lsfr = shift_lsfr(lsfr, false);
+        }
+
+        lsfr = 0;
+        for (int i = 0; i < 8; i++) lsfr = shift_lsfr(lsfr, true);
+        for (int i = 0; i < 0x80; i++) index_7[i] = -1;
+        for (int i = 0; i < PERIOD_7; i++) {
+            state_7[i] = lsfr;
+            index_7[lsfr & 0x7F] = static_cast<int8_t>(i);
+            lsfr = shift_lsfr(lsfr, true);
+        }
+
+        fill_runs(state_15, run_15, PERIOD_15);
+        fill_runs(state_7, run_7, PERIOD_7);
+    }
+
+    // Shifts until bit 0 differs from the current one, walking the cycle backwards (runs are at most 15 long)
+    static void fill_runs(const uint16_t* state, uint8_t* run, int period) {
+        int length = 1;
+        for (int i = 2 * period - 1; i >= 0; i--) {
+            int here = i % period;
+            int next = (i + 1) % period;
+            length = ((state[here] ^ state[next]) & 0x01) ? 1 : length + 1;
+            if (i < period) run[here] = static_cast<uint8_t>(length);
+        }
+    }
+};
+
+const LsfrTables TABLES;
+
+}
+
+void NoiseChannel::serialize(StateWriter& out) const {
+    out.fields(initial_length_timer, clock_shift, lsfr_width, clock_div, trigger_val, length_timer_enable, period,
+               period_div, DAC, enabled, length_timer, initial_volume, current_volume, env_dir, env_sweep_pace,
+               internal_env_sweep_pace_counter, lsfr, last_right_bit, div, tick_rate);
+}
+
+void NoiseChannel::deserialize(StateReader& in) {
+    in.fields(initial_length_timer, clock_shift, lsfr_width, clock_div, trigger_val, length_timer_enable, period,
+              period_div, DAC, enabled, length_timer, initial_volume, current_volume, env_dir, env_sweep_pace,
+              internal_env_sweep_pace_counter, lsfr, last_right_bit, div, tick_rate);
+}
+
+void NoiseChannel::advance(int cycles) {
     // this is clocked 1/4 an M cycle
-    int tick_rate = (clock_div == 0 ? 8 : clock_div * 16) << clock_shift;
+    int steps = advance_divider(div, tick_rate, cycles);
+    if (steps > 0) step_lsfr(steps);
+}
+
+int NoiseChannel::cycles_to_step() const {
+    int next_shift = cycles_to_overflow(div, tick_rate);
+    int index = table_index();
+    // Right after a trigger the output can still be the bit from before, the next shift may change it
+    if (index < 0 || last_right_bit != static_cast<bool>(lsfr & 0x01)) return next_shift;
+    int run = lsfr_width ? TABLES.run_7[index] : TABLES.run_15[index];
+    return next_shift + (run - 1) * tick_rate;
+}
+
+int NoiseChannel::table_index() const {
+    if (!lsfr_width) return TABLES.index_15[lsfr & 0x7FFF];
+    int index = TABLES.index_7[lsfr & 0x7F];
+    return (index >= 0 && TABLES.state_7[index] == lsfr) ? index : -1;
+}
 
-    div++;
-    if (div >= tick_rate) {
-        div = 0;
+void NoiseChannel::step_lsfr(int steps) {
+    // Off the table after a trigger in 7 bit mode or an NR43 width switch, a few plain shifts (8 at most) fix that
+    int index = table_index();
+    for (; index < 0 && steps > 0; steps--) {
         update_lsfr();
+        if (lsfr == LOCKED) return;
+        index = table_index();
     }
+    if (steps == 0) return;
 
+    if (lsfr_width) {
+        lsfr = TABLES.state_7[(index + steps) % PERIOD_7];
+    } else {
+        lsfr = TABLES.state_15[(index + steps) % PERIOD_15];
+    }
+    last_right_bit = lsfr & 0x01;
 }
 
 int16_t NoiseChannel::sample() {
@@ -35,24 +143,7 @@ void NoiseChannel::trigger() {
 }
 
 void NoiseChannel::update_lsfr() {
-    uint8_t lsfr0 = lsfr & 0x01;
-    uint8_t lsfr1 = (lsfr & 0x02) >> 1;
-    if (lsfr0 == lsfr1) {
-        //write 1 to bit 15
-        lsfr |= 0x8000;
-        // bit 7
-        if (lsfr_width) {
-            lsfr |= 0x0080;
-        }
-    } else {
-        //write 0 to bit 15
-        lsfr &= 0x7FFF;
-        // bit 7
-        if (lsfr_width) {
-            lsfr &= 0xFF7F;
-        }
-    }
-    lsfr = lsfr >> 1;
+    lsfr = shift_lsfr(lsfr, lsfr_width);
     last_right_bit = lsfr & 0x01;
 }
 
@@ -100,6 +191,7 @@ void NoiseChannel::write_nr43(uint8_t data) {
     clock_div = data & 0b00000111;
     lsfr_width = data & 0b00001000;
     clock_shift = data >> 4;
+    tick_rate = (clock_div == 0 ? 8 : clock_div * 16) << clock_shift;
 }
 
 uint8_t NoiseChannel::read_nr43() {
@@ -1,6 +1,8 @@
 #pragma once
 #include <cstdint>
 #include <cstdio>
+#include "divider.hpp"
+#include "../core/state_io.hpp"
 
 #define LENGTH_TIMER_MAX 64
 
@@ -17,38 +19,55 @@ class NoiseChannel {
         void write_nr44(uint8_t data);
         uint8_t read_nr44();
 
-        void tick();
+        void advance(int cycles);
+        // Skips LFSR shifts that don't change the output bit, the tables know how long each run of equal bits is
+        int cycles_to_step() const;
+        bool audible() const { return DAC && enabled && current_volume != 0; }
+        // NR52 status: DAC on and not cut by length (or sweep)
+        bool active() const { return DAC && enabled; }
+        // The APU only runs the period divider while this is on
+        bool dac_enabled() const { return DAC; }
+        // NR52 power off
+        void disable() { enabled = false; }
 
         int16_t sample();
         void length_timer_tick();
 
         void env_sweep_tick();
 
+        void serialize(StateWriter& out) const;
+        void deserialize(StateReader& in);
+
     private:
-        uint8_t initial_length_timer;
-        uint8_t clock_shift;
-        bool lsfr_width;
-        uint8_t clock_div;
+        uint8_t initial_length_timer{0};
+        uint8_t clock_shift{0};
+        bool lsfr_width{false};
+        uint8_t clock_div{0};
 
-        bool trigger_val;
-        bool length_timer_enable;
-        uint16_t period;
-        uint16_t period_div;
+        bool trigger_val{false};
+        bool length_timer_enable{false};
+        uint16_t period{0};
+        uint16_t period_div{0};
 
         bool DAC{true};
         bool enabled{true};
 
-        uint8_t length_timer;
-        uint8_t initial_volume;
-        uint8_t current_volume;
-        bool env_dir;
-        uint8_t env_sweep_pace;
-        uint8_t internal_env_sweep_pace_counter;
+        uint8_t length_timer{0};
+        uint8_t initial_volume{0};
+        uint8_t current_volume{0};
+        bool env_dir{false};
+        uint8_t env_sweep_pace{0};
+        uint8_t internal_env_sweep_pace_counter{0};
 
-        uint16_t lsfr;
+        uint16_t lsfr{0};
         bool last_right_bit{false};
-        uint16_t div{0};
+        uint32_t div{0}; // tick_rate goes up to 112 << 15
+        int tick_rate{8}; // only changes on NR43 writes
         void update_lsfr();
+        // Same as calling update_lsfr() `steps` times
+        void step_lsfr(int steps);
+        // Where lsfr sits in the precomputed sequence for the current width, -1 if it isn't on it (yet)
+        int table_index() const;
         void trigger();
 
 };
\ No newline at end of file
@@ -0,0 +1,41 @@
+#include "rate_control.hpp"
+#include "../log/logger.hpp"
+
+#include <algorithm>
+#include <format>
+#include <iostream>
+
+double RateControl::update(int block_samples, int buffered_frames, int target_frames, uint64_t underruns) {
+    double fill = std::clamp(static_cast<double>(buffered_frames) / target_frames, 0.0, 2.0);
+    current_ratio = 1.0 + MAX_DELTA * (1.0 - fill);
+
+    if (window_blocks == 0) {
+        fill_min = fill_max = buffered_frames;
+        ratio_min = ratio_max = current_ratio;
+    }
+    window_blocks++;
+    fill_sum += buffered_frames;
+    fill_min = std::min(fill_min, buffered_frames);
+    fill_max = std::max(fill_max, buffered_frames);
+    ratio_min = std::min(ratio_min, current_ratio);
+    ratio_max = std::max(ratio_max, current_ratio);
+
+    window_samples += block_samples;
+    if (window_samples >= nominal_rate) report(underruns);
+    return nominal_rate * current_ratio;
+}
+
+void RateControl::report(uint64_t underruns) {
+    seconds++;
+    std::string line = std::format(
+        "audio {:>4}s fill avg {:>5} min {:>5} max {:>5} ratio {:.5f} ({:.5f}-{:.5f}) underruns {} (+{})\n",
+        seconds, fill_sum / window_blocks, fill_min, fill_max, current_ratio, ratio_min, ratio_max,
+        underruns, underruns - window_underruns);
+    Logger::log_msg(line);
+    if (print_stats) std::cerr << line;
+
+    window_underruns = underruns;
+    window_samples = 0;
+    window_blocks = 0;
+    fill_sum = 0;
+}
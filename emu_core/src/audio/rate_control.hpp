@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * Dynamic rate control. Emulation is paced by video (vsync or a timer), which never runs at exactly the speed the
+ * sound card consumes samples. Instead of letting the audio ring slowly fill up or run dry, every block nudges the
+ * output sample rate by at most MAX_DELTA: a ring fuller than the target produces slightly fewer samples, an
+ * emptier one slightly more. 0.5% is well below what anyone can hear as pitch.
+ *
+ *   rate = nominal * (1 + MAX_DELTA * (1 - fill / target))   with fill / target clamped to [0, 2]
+ *
+ * It also keeps per second statistics (fill, ratio, underruns) and logs them.
+ */
+class RateControl {
+    public:
+        static constexpr double MAX_DELTA = 0.005;
+
+        explicit RateControl(double nominal_rate) : nominal_rate(nominal_rate) {}
+        // Once the sink has settled on a rate
+        void set_nominal_rate(double rate) { nominal_rate = rate; }
+
+        // Once per audio block, after handing block_samples to the speaker. Returns the sample rate for the next block.
+        double update(int block_samples, int buffered_frames, int target_frames, uint64_t underruns);
+
+        double ratio() const { return current_ratio; }
+        // Also print the per second stats to stderr, not just the log file
+        void set_print_stats(bool print) { print_stats = print; }
+
+    private:
+        double nominal_rate;
+        double current_ratio{1.0};
+        bool print_stats{false};
+
+        // Stats for the current one second window (counted in output samples)
+        int window_samples{0};
+        int window_blocks{0};
+        long long fill_sum{0};
+        int fill_min{0};
+        int fill_max{0};
+        double ratio_min{1.0};
+        double ratio_max{1.0};
+        uint64_t window_underruns{0};
+        uint64_t seconds{0};
+
+        void report(uint64_t underruns);
+};
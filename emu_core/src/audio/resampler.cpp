@@ -0,0 +1,163 @@
+#include "resampler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <stdexcept>
+
+namespace {
+
+ResampleFn kernel_for(ResamplerIsa isa) {
+    switch (isa) {
+#ifdef RESAMPLER_X86
+        case ResamplerIsa::AVX2: return resampler_kernel_avx2();
+        case ResamplerIsa::SSE2: return resampler_kernel_sse2();
+#endif
+        default: return resampler_kernel_scalar();
+    }
+}
+
+// Multiples of 8 so the AVX2 loop never needs a tail
+int taps_for(ResamplerQuality quality) {
+    switch (quality) {
+        case ResamplerQuality::FAST: return 8;
+        case ResamplerQuality::MEDIUM: return 16;
+        case ResamplerQuality::HIGH: return 32;
+    }
+    return 16;
+}
+
+uint64_t to_step(double input_rate, double output_rate) {
+    return static_cast<uint64_t>(std::llround(input_rate / output_rate * 4294967296.0));
+}
+
+}
+
+Resampler::Resampler(double input_rate, double output_rate, ResamplerQuality quality, ResamplerIsa isa)
+    : kernel(kernel_for(isa)), tap_count(taps_for(quality)), input_rate(input_rate)
+{
+    set_rates(input_rate, output_rate);
+}
+
+void Resampler::set_rates(double input_rate, double output_rate) {
+    if (input_rate <= 0 || output_rate <= 0) throw std::runtime_error("Resampler rates must be positive");
+    this->input_rate = input_rate;
+    design(output_rate);
+    step = to_step(input_rate, output_rate);
+    clear();
+}
+
+void Resampler::set_output_rate(double output_rate) {
+    step = to_step(input_rate, output_rate);
+}
+
+/**
+ * Row p holds the taps for an output p / PHASES of the way between two input frames, plus one extra row (a whole
+ * frame later) for the interpolation to blend into. Tap k sits (taps / 2 - 1 + frac - k) input frames before the
+ * output, so the delay is a fixed taps / 2 - 1 frames.
+ * The cutoff follows the lower of the two Nyquist rates, a bit under it, and each row sums to exactly 1.
+ */
+void Resampler::design(double output_rate) {
+    using std::numbers::pi;
+    const double cutoff = 0.9 * std::min(1.0, output_rate / input_rate);
+    const double half = tap_count / 2.0;
+
+    coeffs.assign((PHASES + 1) * tap_count, 0.0f);
+    std::vector<double> row(tap_count);
+    for (int p = 0; p <= PHASES; p++) {
+        double frac = static_cast<double>(p) / PHASES;
+        double sum = 0;
+        for (int k = 0; k < tap_count; k++) {
+            double x = (half - 1) + frac - k;
+            double sinc = x == 0 ? 1.0 : std::sin(pi * cutoff * x) / (pi * cutoff * x);
+            double u = x / half;
+            double window = std::abs(u) >= 1 ? 0 : 0.42 + 0.5 * std::cos(pi * u) + 0.08 * std::cos(2 * pi * u);
+            row[k] = sinc * window;
+            sum += row[k];
+        }
+        for (int k = 0; k < tap_count; k++) {
+            coeffs[p * tap_count + k] = static_cast<float>(row[k] / sum);
+        }
+    }
+}
+
+int Resampler::process(const int16_t* in, int frames, std::vector<int16_t>& out) {
+    size_t start = left.size();
+    left.resize(start + frames);
+    right.resize(start + frames);
+    for (int i = 0; i < frames; i++) {
+        left[start + i] = in[i * 2];
+        right[start + i] = in[i * 2 + 1];
+    }
+
+    // Every output whose taps end inside what we have
+    int count = 0;
+    int buffered = static_cast<int>(left.size());
+    if (buffered >= tap_count) {
+        uint64_t last = (static_cast<uint64_t>(buffered - tap_count) << 32) | 0xFFFFFFFFull;
+        if (position <= last) count = static_cast<int>((last - position) / step) + 1;
+    }
+    out.resize(count * 2);
+    if (count > 0) {
+        kernel(ResamplePass{left.data(), right.data(), coeffs.data(), tap_count, position, step, count, out.data()});
+        position += count * step;
+    }
+
+    // Drop the frames no future output reaches back to
+    size_t consumed = std::min<size_t>(position >> 32, left.size());
+    left.erase(left.begin(), left.begin() + consumed);
+    right.erase(right.begin(), right.begin() + consumed);
+    position -= static_cast<uint64_t>(consumed) << 32;
+    return count;
+}
+
+// Starts on silence, primed so the first input frame comes out after the filter's delay
+void Resampler::clear() {
+    left.assign(tap_count / 2 - 1, 0.0f);
+    right.assign(tap_count / 2 - 1, 0.0f);
+    position = 0;
+}
+
+ResamplerIsa Resampler::best_isa() {
+#ifdef RESAMPLER_X86
+    if (__builtin_cpu_supports("avx2")) return ResamplerIsa::AVX2;
+    return ResamplerIsa::SSE2;
+#else
+    return ResamplerIsa::SCALAR;
+#endif
+}
+
+std::vector<ResamplerIsa> Resampler::supported_isas() {
+    std::vector<ResamplerIsa> isas{ResamplerIsa::SCALAR};
+#ifdef RESAMPLER_X86
+    isas.push_back(ResamplerIsa::SSE2);
+    if (__builtin_cpu_supports("avx2")) isas.push_back(ResamplerIsa::AVX2);
+#endif
+    return isas;
+}
+
+bool Resampler::parse_quality(const std::string& name, ResamplerQuality& quality) {
+    if (name == "fast") quality = ResamplerQuality::FAST;
+    else if (name == "medium") quality = ResamplerQuality::MEDIUM;
+    else if (name == "high") quality = ResamplerQuality::HIGH;
+    else return false;
+    return true;
+}
+
+const char* Resampler::quality_name(ResamplerQuality quality) {
+    switch (quality) {
+        case ResamplerQuality::FAST: return "fast";
+        case ResamplerQuality::MEDIUM: return "medium";
+        case ResamplerQuality::HIGH: return "high";
+    }
+    return "unknown";
+}
+
+const char* Resampler::isa_name(ResamplerIsa isa) {
+    switch (isa) {
+        case ResamplerIsa::SCALAR: return "scalar";
+        case ResamplerIsa::SSE2: return "sse2";
+        case ResamplerIsa::AVX2: return "avx2";
+    }
+    return "unknown";
+}
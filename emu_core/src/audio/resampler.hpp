@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Converts the APU's native rate to whatever rate the sink runs at (44.1, 48, 96 kHz...), so the device never has
+ * to resample and the pitch is right whatever SDL negotiated.
+ *
+ * Polyphase windowed sinc: one row of taps per sub-sample phase, PHASES rows plus linear interpolation between
+ * neighbors, so any ratio works. Rate control nudges only change the step, the filter is designed once for the
+ * nominal rates. Presets trade taps (stopband, transition width) for CPU time:
+ *
+ *  FAST:    8 taps
+ *  MEDIUM: 16 taps
+ *  HIGH:   32 taps
+ */
+enum class ResamplerQuality {
+    FAST,
+    MEDIUM,
+    HIGH
+};
+
+enum class ResamplerIsa {
+    SCALAR,
+    SSE2,
+    AVX2
+};
+
+struct ResamplePass {
+    const float* left;   // planar input frames, converted from int16
+    const float* right;
+    const float* coeffs; // PHASES + 1 rows of `taps`
+    int taps;
+    uint64_t position;   // 32.32 fixed point, input frame where the first output's taps start
+    uint64_t step;       // input frames per output frame, same fixed point
+    int count;
+    int16_t* out;        // interleaved left/right
+};
+
+using ResampleFn = void (*)(const ResamplePass& pass);
+
+// One per instruction set, see resampler_kernels.hpp
+ResampleFn resampler_kernel_scalar();
+#ifdef RESAMPLER_X86
+ResampleFn resampler_kernel_sse2();
+ResampleFn resampler_kernel_avx2();
+#endif
+
+class Resampler {
+    public:
+        static constexpr int PHASE_BITS = 6;
+        static constexpr int PHASES = 1 << PHASE_BITS;
+
+        Resampler(double input_rate, double output_rate, ResamplerQuality quality = ResamplerQuality::MEDIUM,
+                  ResamplerIsa isa = best_isa());
+
+        // Nominal rates, redesigns the filter and drops buffered input
+        void set_rates(double input_rate, double output_rate);
+        // Small adjustments around the nominal output rate (rate control), keeps the filter and the input
+        void set_output_rate(double output_rate);
+
+        // Takes `frames` interleaved stereo frames, replaces `out` with every output frame they complete
+        int process(const int16_t* in, int frames, std::vector<int16_t>& out);
+        void clear();
+
+        int taps() const { return tap_count; }
+
+        static ResamplerIsa best_isa();
+        static std::vector<ResamplerIsa> supported_isas();
+        static bool parse_quality(const std::string& name, ResamplerQuality& quality);
+        static const char* quality_name(ResamplerQuality quality);
+        static const char* isa_name(ResamplerIsa isa);
+
+    private:
+        ResampleFn kernel;
+        int tap_count;
+        double input_rate;
+        std::vector<float> coeffs;
+
+        std::vector<float> left;
+        std::vector<float> right;
+        uint64_t position{0};
+        uint64_t step{0};
+
+        void design(double output_rate);
+};
@@ -0,0 +1,28 @@
+// Built with -mavx2, only called after a runtime CPU check (see Resampler::best_isa)
+#include <immintrin.h>
+#include "resampler_kernels.hpp"
+
+namespace {
+
+struct Avx2Float {
+    using reg = __m256;
+    static constexpr int width = 8;
+
+    static reg zero() { return _mm256_setzero_ps(); }
+    static reg set1(float v) { return _mm256_set1_ps(v); }
+    static reg load(const float* p) { return _mm256_loadu_ps(p); }
+    static reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+    static reg sub(reg a, reg b) { return _mm256_sub_ps(a, b); }
+    static reg mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+    static float sum(reg v) {
+        __m128 half = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        __m128 pairs = _mm_add_ps(half, _mm_movehl_ps(half, half));
+        return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+    }
+};
+
+}
+
+ResampleFn resampler_kernel_avx2() {
+    return resample<Avx2Float>;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include "resampler.hpp"
+
+/**
+ * The resampling loop, written once against a small float vector interface V and compiled once per instruction set
+ * (resampler_scalar.cpp, resampler_sse2.cpp, resampler_avx2.cpp). V provides:
+ *
+ *   reg, width, zero, set1, load, add, sub, mul, sum (horizontal add)
+ *
+ * Same anonymous namespace trick as the scaler kernels: each translation unit has its own -m flags.
+ */
+namespace {
+
+inline int16_t to_sample(float v) {
+    return static_cast<int16_t>(std::clamp(std::lrintf(v), -32768L, 32767L));
+}
+
+template <typename V>
+void resample(const ResamplePass& p) {
+    using R = typename V::reg;
+    constexpr uint64_t FRAC_MASK = 0xFFFFFFFFull;
+    constexpr int PHASE_SHIFT = 32 - Resampler::PHASE_BITS;
+
+    uint64_t position = p.position;
+    for (int i = 0; i < p.count; i++, position += p.step) {
+        const float* l = p.left + (position >> 32);
+        const float* r = p.right + (position >> 32);
+        uint32_t frac = static_cast<uint32_t>(position & FRAC_MASK);
+        const float* row0 = p.coeffs + (frac >> PHASE_SHIFT) * p.taps;
+        const float* row1 = row0 + p.taps;
+        R blend = V::set1(static_cast<float>(frac & ((1u << PHASE_SHIFT) - 1)) / (1u << PHASE_SHIFT));
+
+        R acc_l = V::zero();
+        R acc_r = V::zero();
+        for (int k = 0; k < p.taps; k += V::width) {
+            R c0 = V::load(row0 + k);
+            R c = V::add(c0, V::mul(blend, V::sub(V::load(row1 + k), c0)));
+            acc_l = V::add(acc_l, V::mul(c, V::load(l + k)));
+            acc_r = V::add(acc_r, V::mul(c, V::load(r + k)));
+        }
+        p.out[i * 2] = to_sample(V::sum(acc_l));
+        p.out[i * 2 + 1] = to_sample(V::sum(acc_r));
+    }
+}
+
+}
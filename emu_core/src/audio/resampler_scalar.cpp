@@ -0,0 +1,23 @@
+#include "resampler_kernels.hpp"
+
+namespace {
+
+// One float per "register", used on non x86 targets and as the reference for the SIMD versions
+struct ScalarFloat {
+    using reg = float;
+    static constexpr int width = 1;
+
+    static reg zero() { return 0.0f; }
+    static reg set1(float v) { return v; }
+    static reg load(const float* p) { return *p; }
+    static reg add(reg a, reg b) { return a + b; }
+    static reg sub(reg a, reg b) { return a - b; }
+    static reg mul(reg a, reg b) { return a * b; }
+    static float sum(reg v) { return v; }
+};
+
+}
+
+ResampleFn resampler_kernel_scalar() {
+    return resample<ScalarFloat>;
+}
@@ -0,0 +1,26 @@
+#include <emmintrin.h>
+#include "resampler_kernels.hpp"
+
+namespace {
+
+struct Sse2Float {
+    using reg = __m128;
+    static constexpr int width = 4;
+
+    static reg zero() { return _mm_setzero_ps(); }
+    static reg set1(float v) { return _mm_set1_ps(v); }
+    static reg load(const float* p) { return _mm_loadu_ps(p); }
+    static reg add(reg a, reg b) { return _mm_add_ps(a, b); }
+    static reg sub(reg a, reg b) { return _mm_sub_ps(a, b); }
+    static reg mul(reg a, reg b) { return _mm_mul_ps(a, b); }
+    static float sum(reg v) {
+        reg pairs = _mm_add_ps(v, _mm_movehl_ps(v, v));
+        return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+    }
+};
+
+}
+
+ResampleFn resampler_kernel_sse2() {
+    return resample<Sse2Float>;
+}
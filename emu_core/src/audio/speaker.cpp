@@ -1,53 +1,88 @@
 #include "speaker.hpp"
+#include "../log/logger.hpp"
+
+#include <format>
 
 void Speaker::init() {
     SDL_Init(SDL_INIT_AUDIO | SDL_INIT_NOPARACHUTE);
 
     SDL_AudioSpec want, have;
     SDL_zero(want);
-    want.freq = 48000;
+    want.freq = rate;
     want.format = AUDIO_S16SYS;
     want.channels = 2;
     want.samples = 512; // do NOT make this higher than 512 unless u want fried audio
-    device_id = SDL_OpenAudioDevice(nullptr, 0, &want, &have, 0);
+    want.callback = audio_callback;
+    want.userdata = this;
+    // Take the device's own rate rather than having SDL resample behind our back, the APU resamples to it
+    device_id = SDL_OpenAudioDevice(nullptr, 0, &want, &have, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE);
 
     if (device_id == 0) {
         std::cerr << "Failed to open audio device: " << SDL_GetError() << std::endl;
         return;
     }
+    if (have.freq != rate) {
+        Logger::log_msg(std::format("Audio device runs at {} Hz (asked for {})\n", have.freq, rate));
+        rate = have.freq;
+    }
 
-    SDL_PauseAudioDevice(device_id, UNPAUSE_AUDIO);
+    unpause();
 }
 
 /**
- * This is essentially processing a left stereo and right stereo value and playing it
- * @param left
- * @param right
+ * Plays a block of left/right sample pairs from the APU
+ * The APU's rate control keeps the ring around TARGET_LATENCY_MS deep, a full ring means something stalled
+ * and the rest of the block is dropped.
+ * @param samples interleaved left, right
+ * @param frames number of pairs
  */
-void Speaker::play_sample(int16_t left, int16_t right) {
-    if (device_id == 0) return;
-
-    int timeout = 0;
-    // almost like a rate limiter for the emulator
-    while (SDL_GetQueuedAudioSize(device_id) > 3840) {
-        std::this_thread::yield();
-        if (++timeout > 10000) break;
+void Speaker::play_samples(const int16_t* samples, int frames) {
+    if (device_id == 0 || paused || frames <= 0) return; // paused devices aren't draining the ring
+
+    size_t written = ring.write(samples, frames * 2);
+    if (written < static_cast<size_t>(frames) * 2) {
+        overrun_count.fetch_add(1, std::memory_order_relaxed);
     }
+}
 
-    int16_t frame[2] = { left, right };
-    SDL_QueueAudio(device_id, frame, sizeof(frame));
+// Runs on SDL's audio thread
+void Speaker::audio_callback(void* userdata, Uint8* stream, int len) {
+    static_cast<Speaker*>(userdata)->fill(reinterpret_cast<int16_t*>(stream), len / (2 * sizeof(int16_t)));
 }
 
+void Speaker::fill(int16_t* out, int frames) {
+    int read = static_cast<int>(ring.read(out, frames * 2)) / 2;
+    if (read > 0) {
+        last_frame[0] = out[read * 2 - 2];
+        last_frame[1] = out[read * 2 - 1];
+    }
+    if (read < frames) {
+        // Hold the last level instead of dropping to zero, a jump to silence clicks
+        underrun_count.fetch_add(1, std::memory_order_relaxed);
+        for (int i = read; i < frames; i++) {
+            out[i * 2] = last_frame[0];
+            out[i * 2 + 1] = last_frame[1];
+        }
+    }
+}
+
+// Only talks to SDL when the state actually changes, the APU calls these on every tick
 void Speaker::pause() {
+    if (paused || device_id == 0) return;
+    paused = true;
     SDL_PauseAudioDevice(device_id, PAUSE_AUDIO);
 }
 void Speaker::unpause() {
+    if (!paused || device_id == 0) return;
+    paused = false;
     SDL_PauseAudioDevice(device_id, UNPAUSE_AUDIO);
 }
 
 void Speaker::close() {
     if (device_id != 0) {
         SDL_CloseAudioDevice(device_id);
+        Logger::log_msg(std::format("Audio underruns: {} overruns: {}\n", underruns(), overruns()));
+        device_id = 0;
     }
     SDL_QuitSubSystem(SDL_INIT_AUDIO);
-}
\ No newline at end of file
+}
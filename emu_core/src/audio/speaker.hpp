@@ -2,26 +2,60 @@
 
 #include <SDL2/SDL_audio.h>
 #include <SDL2/SDL.h>
+#include <atomic>
 #include <iostream>
 #include <ostream>
 #include <thread>
+#include <vector>
+#include "audio_sink.hpp"
+#include "spsc_ring.hpp"
 
 #define UNPAUSE_AUDIO 0
 #define PAUSE_AUDIO 1
 
 
-class Speaker {
+/**
+ * SDL pulls audio from us: the APU writes blocks into a lock-free ring and SDL's audio thread drains it from
+ * audio_callback. Nothing on the emulation side takes SDL's lock while playing.
+ */
+class Speaker : public AudioSink {
     public:
-        void init();
+        // The device may settle on another rate, sample_rate() has the real one after init()
+        explicit Speaker(int wanted_rate = DEFAULT_SAMPLE_RATE) : rate(wanted_rate) {}
 
-        void play_sample(int16_t left, int16_t right);
+        void init() override;
 
-        void pause();
+        // Queues `frames` interleaved left/right samples. Never waits, pacing is up to the emulator.
+        void play_samples(const int16_t* samples, int frames) override;
 
-        void unpause();
+        // How much audio is queued, for rate control
+        int buffered_frames() const override { return static_cast<int>(ring.size() / 2); }
+        int target_buffered_frames() const override { return rate * TARGET_LATENCY_MS / 1000; }
+        int sample_rate() const override { return rate; }
+
+        void pause() override;
+
+        void unpause() override;
+
+        void close() override;
+
+        // Callback found the ring short / a block didn't fit in the ring
+        uint64_t underruns() const override { return underrun_count.load(std::memory_order_relaxed); }
+        uint64_t overruns() const { return overrun_count.load(std::memory_order_relaxed); }
+
+        static constexpr int RING_FRAMES = 8192; // room for rate control's overshoot at 96 kHz
+        static constexpr int TARGET_LATENCY_MS = 20;
 
-        void close();
     private:
-        SDL_AudioDeviceID device_id;
-        std::vector<int16_t> audio_bucket;
+        SDL_AudioDeviceID device_id{0};
+        int rate;
+        bool paused{true};
+        SpscRing<int16_t> ring{RING_FRAMES * 2};
+        int16_t last_frame[2]{0, 0};
+
+        std::atomic<uint64_t> underrun_count{0};
+        std::atomic<uint64_t> overrun_count{0};
+
+        static void audio_callback(void* userdata, Uint8* stream, int len);
+        void fill(int16_t* out, int frames);
 };
@@ -0,0 +1,70 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Lock-free single producer / single consumer ring buffer.
+ *
+ * The producer (emulation thread) only moves the write index and the consumer (SDL's audio thread) only moves the
+ * read index, so each side just needs to see the other's index with acquire/release ordering. Indices run freely
+ * and are masked on access, capacity is rounded up to a power of two. Both sides copy in blocks.
+ */
+template <typename T>
+class SpscRing {
+    public:
+        explicit SpscRing(size_t min_capacity) {
+            size_t capacity = 1;
+            while (capacity < min_capacity) capacity <<= 1;
+            data.resize(capacity);
+            mask = capacity - 1;
+        }
+
+        size_t capacity() const { return data.size(); }
+        // Exact from either thread for its own side, a lower bound of free space / available items otherwise
+        size_t size() const {
+            return write_index.load(std::memory_order_acquire) - read_index.load(std::memory_order_acquire);
+        }
+
+        // Producer. Copies as many of the count items as fit, returns how many were written.
+        size_t write(const T* items, size_t count) {
+            size_t write_pos = write_index.load(std::memory_order_relaxed);
+            size_t free = capacity() - (write_pos - read_index.load(std::memory_order_acquire));
+            count = std::min(count, free);
+            copy_in(write_pos, items, count);
+            write_index.store(write_pos + count, std::memory_order_release);
+            return count;
+        }
+
+        // Consumer. Copies up to count items out, returns how many were read.
+        size_t read(T* items, size_t count) {
+            size_t read_pos = read_index.load(std::memory_order_relaxed);
+            size_t available = write_index.load(std::memory_order_acquire) - read_pos;
+            count = std::min(count, available);
+            copy_out(read_pos, items, count);
+            read_index.store(read_pos + count, std::memory_order_release);
+            return count;
+        }
+
+    private:
+        std::vector<T> data;
+        size_t mask;
+        // Separate cache lines so the two threads don't keep stealing each other's line
+        alignas(64) std::atomic<size_t> write_index{0};
+        alignas(64) std::atomic<size_t> read_index{0};
+
+        void copy_in(size_t pos, const T* items, size_t count) {
+            size_t start = pos & mask;
+            size_t first = std::min(count, capacity() - start);
+            std::copy(items, items + first, data.begin() + start);
+            std::copy(items + first, items + count, data.begin());
+        }
+
+        void copy_out(size_t pos, T* items, size_t count) const {
+            size_t start = pos & mask;
+            size_t first = std::min(count, capacity() - start);
+            std::copy(data.begin() + start, data.begin() + start + first, items);
+            std::copy(data.begin(), data.begin() + (count - first), items + first);
+        }
+};
@@ -2,13 +2,25 @@
 
 //https://gbdev.io/pandocs/Audio_Registers.html#ff10--nr10-channel-1-sweep
 
+void SquareChannel::serialize(StateWriter& out) const {
+    out.fields(DAC, enabled, pace, pace_counter, direction, initial_volume, current_volume, env_dir, env_sweep_pace,
+               internal_env_sweep_pace_counter, initial_length_timer, length_timer, length_timer_enable,
+               length_timer_counter, period, period_shadow, period_div, sweep_rate, wave_duty, individual_step,
+               duty_step, trigger_val);
+}
 
-void SquareChannel::tick() {
-    period_div++; // period dividers are clocked at 1048576 Hz (1 M Cycle)
-    if (period_div >= (2048 - period)) {
-        period_div = 0;
-        duty_step = (duty_step + 1) & 0x7;
-    }
+void SquareChannel::deserialize(StateReader& in) {
+    in.fields(DAC, enabled, pace, pace_counter, direction, initial_volume, current_volume, env_dir, env_sweep_pace,
+              internal_env_sweep_pace_counter, initial_length_timer, length_timer, length_timer_enable,
+              length_timer_counter, period, period_shadow, period_div, sweep_rate, wave_duty, individual_step,
+              duty_step, trigger_val);
+}
+
+
+void SquareChannel::advance(int cycles) {
+    // period dividers are clocked at 1048576 Hz (1 M Cycle), every overflow moves one duty step
+    int steps = advance_divider(period_div, 2048 - period, cycles);
+    duty_step = (duty_step + steps) & 0x7;
 }
 
 
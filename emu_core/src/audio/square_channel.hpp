@@ -2,6 +2,8 @@
 #include <cstdint>
 #include <stdexcept>
 #include <iostream>
+#include "divider.hpp"
+#include "../core/state_io.hpp"
 
 #define LENGTH_TIMER_MAX 64
 #define ENV_RATE_M_CYCLES 16384
@@ -11,7 +13,17 @@ class SquareChannel {
     public:
         SquareChannel() = default;
 
-        void tick();
+        // Runs the period divider for a span of M cycles
+        void advance(int cycles);
+        // When the output can next change, and whether it can change at all (for the APU's event loop)
+        int cycles_to_step() const { return cycles_to_overflow(period_div, 2048 - period); }
+        bool audible() const { return DAC && enabled && current_volume != 0; }
+        // NR52 status: DAC on and not cut by length (or sweep)
+        bool active() const { return DAC && enabled; }
+        // The APU only runs the period divider while this is on
+        bool dac_enabled() const { return DAC; }
+        // NR52 power off
+        void disable() { enabled = false; }
 
         int16_t sample();
 
@@ -38,6 +50,9 @@ class SquareChannel {
 
         void volume_envelope_tick();
 
+        void serialize(StateWriter& out) const;
+        void deserialize(StateReader& in);
+
         bool DAC{true};
         bool enabled = true;
 
@@ -51,32 +66,32 @@ class SquareChannel {
          * So to get iterations we would do 1048576 Hz / (128Hz / pace)
          * If pace is zero, there are no iterations! it's disabled/
          */
-        uint8_t pace;
-        uint8_t pace_counter;
-        bool direction;
+        uint8_t pace{0};
+        uint8_t pace_counter{0};
+        bool direction{false};
 
-        uint8_t initial_volume;
-        uint8_t current_volume;
+        uint8_t initial_volume{0};
+        uint8_t current_volume{0};
 
-        bool env_dir;
-        uint8_t env_sweep_pace;
-        uint8_t internal_env_sweep_pace_counter;
+        bool env_dir{false};
+        uint8_t env_sweep_pace{0};
+        uint8_t internal_env_sweep_pace_counter{0};
 
 
         /**
          * Length timer counter wil tick once every 256Hz, when it reaches 64, the channel is disabled.
          * 1048576 Hz / 256Hz would be 4096 M cycles per length timer tick.
          */
-        uint8_t initial_length_timer;
-        uint8_t length_timer;
-        bool length_timer_enable;
-        uint8_t length_timer_counter;
+        uint8_t initial_length_timer{0};
+        uint8_t length_timer{0};
+        bool length_timer_enable{false};
+        uint8_t length_timer_counter{0};
 
 
         // This will determine pitch
-        uint16_t period;
+        uint16_t period{0};
         uint16_t period_shadow= 0;
-        uint16_t period_div;
+        uint16_t period_div{0};
         int sweep_rate = 0;
 
         /**
@@ -86,8 +101,8 @@ class SquareChannel {
          * Note: visual diagram is inverted. 12.5% is low 12.5% of the time...
          * https://gbdev.io/pandocs/Audio_Registers.html#ff11--nr11-channel-1-length-timer--duty-cycle
          */
-        uint8_t wave_duty;
-        uint8_t individual_step;
+        uint8_t wave_duty{0};
+        uint8_t individual_step{0};
         static constexpr uint8_t SQUARE_WAVE_DUTY[4][8] = {
             {0, 0, 0, 0, 0, 0, 0, 1},
             {1, 0, 0, 0, 0, 0, 0, 1},
@@ -0,0 +1,120 @@
+#include "vgm_player.hpp"
+#include "vgm_writer.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace {
+
+uint32_t get_le32(const std::vector<uint8_t>& data, size_t offset) {
+    return data[offset] | (data[offset + 1] << 8) | (data[offset + 2] << 16) | (static_cast<uint32_t>(data[offset + 3]) << 24);
+}
+
+// Operand bytes after a command we don't play, by command range (VGM spec). -1 for unknown commands.
+int operand_bytes(uint8_t cmd) {
+    if (cmd >= 0x30 && cmd <= 0x3F) return 1;
+    if (cmd == 0x4F || cmd == 0x50) return 1;
+    if (cmd >= 0x40 && cmd <= 0x4E) return 2;
+    if (cmd >= 0x51 && cmd <= 0x5F) return 2;
+    if (cmd >= 0xA0 && cmd <= 0xBF) return 2;
+    // PCM RAM write and the DAC stream control block have their own sizes
+    if (cmd == 0x68) return 11;
+    if (cmd == 0x90 || cmd == 0x91 || cmd == 0x95) return 4;
+    if (cmd == 0x92) return 5;
+    if (cmd == 0x93) return 10;
+    if (cmd == 0x94) return 1;
+    if (cmd >= 0xC0 && cmd <= 0xDF) return 3;
+    if (cmd >= 0xE0) return 4;
+    return -1;
+}
+
+// First M cycle inside the sample, the inverse of vgm::cycles_to_samples
+uint64_t sample_to_cycle(uint64_t sample) {
+    return (sample * vgm::M_CYCLES_PER_SECOND + vgm::SAMPLE_RATE - 1) / vgm::SAMPLE_RATE;
+}
+
+}
+
+VgmPlayer::VgmPlayer(const std::vector<uint8_t>& file) {
+    if (file.size() < 0x40 || !std::equal(file.begin(), file.begin() + 4, "Vgm ")) {
+        throw std::runtime_error("Not a VGM file");
+    }
+    uint32_t version = get_le32(file, vgm::OFFSET_VERSION);
+    // Before 1.50 data always starts at 0x40, and before 1.61 there is no DMG
+    size_t data = version >= 0x150 ? vgm::OFFSET_DATA + get_le32(file, vgm::OFFSET_DATA) : 0x40;
+    if (version < 0x161 || file.size() < vgm::OFFSET_DMG_CLOCK + 4 || get_le32(file, vgm::OFFSET_DMG_CLOCK) == 0) {
+        throw std::runtime_error("VGM file has no Game Boy DMG stream");
+    }
+
+    size_t pos = data;
+    auto need = [&](size_t bytes) {
+        if (pos + bytes > file.size()) throw std::runtime_error("VGM data ends in the middle of a command");
+    };
+    while (pos < file.size()) {
+        uint8_t cmd = file[pos++];
+        if (cmd == vgm::CMD_END) break;
+
+        if (cmd == vgm::CMD_DMG_WRITE) {
+            need(2);
+            // Bit 7 of the register selects a second chip, which we don't have
+            if (!(file[pos] & 0x80)) log.push_back({samples, static_cast<uint16_t>(0xFF10 + file[pos]), file[pos + 1]});
+            pos += 2;
+        } else if (cmd == vgm::CMD_WAIT) {
+            need(2);
+            samples += file[pos] | (file[pos + 1] << 8);
+            pos += 2;
+        } else if (cmd == vgm::CMD_WAIT_NTSC_FRAME) {
+            samples += 735;
+        } else if (cmd == vgm::CMD_WAIT_PAL_FRAME) {
+            samples += 882;
+        } else if ((cmd & 0xF0) == vgm::CMD_WAIT_SHORT) {
+            samples += (cmd & 0x0F) + 1;
+        } else if ((cmd & 0xF0) == 0x80) {
+            samples += cmd & 0x0F; // YM2612 DAC write + wait, only the wait matters to us
+        } else if (cmd == 0x67) {
+            need(6); // 0x67 0x66 type size32 data
+            pos += 6 + get_le32(file, pos + 2);
+        } else {
+            int skip = operand_bytes(cmd);
+            if (skip < 0) throw std::runtime_error("Unknown VGM command " + std::to_string(cmd));
+            need(skip);
+            pos += skip;
+        }
+    }
+}
+
+VgmPlayer VgmPlayer::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("Couldn't open " + path);
+    std::vector<uint8_t> file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return VgmPlayer(file);
+}
+
+double VgmPlayer::seconds() const {
+    return static_cast<double>(samples) / vgm::SAMPLE_RATE;
+}
+
+void VgmPlayer::render(APU& apu) const {
+    uint64_t cycle = 0;
+    int div_phase = 0;
+    auto run_until = [&](uint64_t target) {
+        while (cycle < target) {
+            int step = static_cast<int>(std::min<uint64_t>(target - cycle, FRAME_SEQUENCER_CYCLES - div_phase));
+            apu.tick(step, false);
+            cycle += step;
+            div_phase += step;
+            if (div_phase == FRAME_SEQUENCER_CYCLES) {
+                div_phase = 0;
+                apu.tick(0, true);
+            }
+        }
+    };
+
+    for (const VgmWrite& write : log) {
+        run_until(sample_to_cycle(write.sample));
+        apu.apu_io_write(write.addr, write.value);
+    }
+    run_until(sample_to_cycle(samples));
+}
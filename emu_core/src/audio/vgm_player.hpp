@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "apu.hpp"
+
+struct VgmWrite {
+    uint64_t sample; // 44.1 kHz samples from the start
+    uint16_t addr;
+    uint8_t value;
+};
+
+/**
+ * Plays a VGM register log (see VgmWriter) through our APU, no CPU or PPU involved, so rendering a track costs a
+ * tiny fraction of emulating the game that made it.
+ * Only the DMG chip is played. Commands for other chips are skipped, so files from other tools work as long as they
+ * carry a DMG stream.
+ */
+class VgmPlayer {
+    public:
+        // Throws std::runtime_error on anything that isn't a VGM with a DMG clock
+        explicit VgmPlayer(const std::vector<uint8_t>& file);
+        static VgmPlayer load(const std::string& path);
+
+        const std::vector<VgmWrite>& writes() const { return log; }
+        uint64_t total_samples() const { return samples; }
+        double seconds() const;
+
+        // Writes land on the first M cycle of their sample, the frame sequencer runs free at 512 Hz
+        void render(APU& apu) const;
+
+        static constexpr int FRAME_SEQUENCER_CYCLES = 2048;
+
+    private:
+        std::vector<VgmWrite> log;
+        uint64_t samples{0};
+};
@@ -0,0 +1,76 @@
+#include "vgm_writer.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+void put_le32(char* out, uint32_t value) {
+    for (int i = 0; i < 4; i++) out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+}
+
+}
+
+VgmWriter::VgmWriter(const std::string& path) {
+    file.open(path, std::ios::binary);
+    if (!file) throw std::runtime_error("Couldn't open VGM log " + path);
+    write_header(vgm::HEADER_SIZE); // sizes get patched in close()
+}
+
+VgmWriter::~VgmWriter() {
+    close(last_cycle);
+}
+
+void VgmWriter::write(uint64_t cycle, uint16_t addr, uint8_t value) {
+    if (closed || addr < 0xFF10 || addr > 0xFF3F) return;
+    wait_until(cycle);
+    file.put(static_cast<char>(vgm::CMD_DMG_WRITE));
+    file.put(static_cast<char>(addr - 0xFF10));
+    file.put(static_cast<char>(value));
+    write_count++;
+}
+
+// Picks the shortest encoding for each stretch, long gaps become a run of 16 bit waits
+void VgmWriter::wait_until(uint64_t cycle) {
+    last_cycle = std::max(last_cycle, cycle);
+    uint64_t target = vgm::cycles_to_samples(last_cycle);
+    while (samples_written < target) {
+        uint64_t wait = target - samples_written;
+        if (wait <= 16) {
+            file.put(static_cast<char>(vgm::CMD_WAIT_SHORT + wait - 1));
+        } else if (wait == 735) {
+            file.put(static_cast<char>(vgm::CMD_WAIT_NTSC_FRAME));
+        } else if (wait == 882) {
+            file.put(static_cast<char>(vgm::CMD_WAIT_PAL_FRAME));
+        } else {
+            wait = std::min<uint64_t>(wait, 0xFFFF);
+            file.put(static_cast<char>(vgm::CMD_WAIT));
+            file.put(static_cast<char>(wait & 0xFF));
+            file.put(static_cast<char>(wait >> 8));
+        }
+        samples_written += wait;
+    }
+}
+
+void VgmWriter::close(uint64_t cycle) {
+    if (closed) return;
+    wait_until(cycle);
+    file.put(static_cast<char>(vgm::CMD_END));
+    closed = true;
+
+    uint32_t size = static_cast<uint32_t>(file.tellp());
+    file.seekp(0);
+    write_header(size);
+    file.close();
+}
+
+void VgmWriter::write_header(uint32_t file_size) {
+    char header[vgm::HEADER_SIZE] = {};
+    std::copy_n("Vgm ", 4, header);
+    put_le32(header + vgm::OFFSET_EOF, file_size - vgm::OFFSET_EOF);
+    put_le32(header + vgm::OFFSET_VERSION, vgm::VERSION);
+    put_le32(header + vgm::OFFSET_TOTAL_SAMPLES, static_cast<uint32_t>(samples_written));
+    put_le32(header + vgm::OFFSET_DATA, vgm::HEADER_SIZE - vgm::OFFSET_DATA); // relative to the field itself
+    put_le32(header + vgm::OFFSET_DMG_CLOCK, vgm::DMG_CLOCK);
+    file.write(header, sizeof(header));
+}
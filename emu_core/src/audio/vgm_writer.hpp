@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+/**
+ * VGM 1.61 constants for the Game Boy DMG chip. A VGM file is a 0x100 byte header followed by commands:
+ *
+ *   0xB3 aa dd   write dd to sound register 0xFF10 + aa (wave RAM is 0x20 - 0x2F)
+ *   0x61 nn nn   wait nnnn samples (little endian), 0x62 / 0x63 wait 735 / 882, 0x7n waits n + 1
+ *   0x66         end of data
+ *
+ * Time is counted in 44.1 kHz samples whatever the chip. The DMG clock field (0x80) holds 4194304 (T cycles).
+ */
+namespace vgm {
+    constexpr uint32_t VERSION = 0x161;
+    constexpr int HEADER_SIZE = 0x100;
+    constexpr int SAMPLE_RATE = 44100;
+    constexpr uint32_t DMG_CLOCK = 4194304;
+    constexpr uint64_t M_CYCLES_PER_SECOND = 1048576;
+
+    constexpr int OFFSET_EOF = 0x04;
+    constexpr int OFFSET_VERSION = 0x08;
+    constexpr int OFFSET_TOTAL_SAMPLES = 0x18;
+    constexpr int OFFSET_DATA = 0x34;
+    constexpr int OFFSET_DMG_CLOCK = 0x80;
+
+    constexpr uint8_t CMD_DMG_WRITE = 0xB3;
+    constexpr uint8_t CMD_WAIT = 0x61;
+    constexpr uint8_t CMD_WAIT_NTSC_FRAME = 0x62; // 735 samples
+    constexpr uint8_t CMD_WAIT_PAL_FRAME = 0x63;  // 882 samples
+    constexpr uint8_t CMD_END = 0x66;
+    constexpr uint8_t CMD_WAIT_SHORT = 0x70;      // 0x70 - 0x7F wait 1 - 16
+
+    // Whole samples up to an M cycle, from time zero so rounding never drifts
+    constexpr uint64_t cycles_to_samples(uint64_t cycles) { return cycles * SAMPLE_RATE / M_CYCLES_PER_SECOND; }
+}
+
+/**
+ * Logs sound register writes as a VGM file, for audio regression tests and music capture. A few bytes per write
+ * instead of 192 KB per second of PCM, and it plays in any VGM player (or VgmRender, which renders it with our APU).
+ *
+ * Writes arrive with the M cycle they happened on and are placed at the 44.1 kHz sample that cycle falls in. The
+ * frame sequencer isn't in the format: players run their own at 512 Hz, so length/envelope ticks can land up to
+ * 2ms away from where DIV put them in the game.
+ */
+class VgmWriter {
+    public:
+        explicit VgmWriter(const std::string& path);
+        ~VgmWriter();
+
+        // addr is 0xFF10 - 0xFF3F, anything else is ignored
+        void write(uint64_t cycle, uint16_t addr, uint8_t value);
+        // Waits up to `cycle`, ends the data and fills in the header. Later writes are dropped.
+        void close(uint64_t cycle);
+
+        uint64_t samples() const { return samples_written; }
+        uint64_t writes() const { return write_count; }
+
+    private:
+        std::ofstream file;
+        uint64_t samples_written{0};
+        uint64_t last_cycle{0};
+        uint64_t write_count{0};
+        bool closed{false};
+
+        void wait_until(uint64_t cycle);
+        void write_header(uint32_t file_size);
+};
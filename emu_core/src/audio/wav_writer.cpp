@@ -0,0 +1,90 @@
+#include "wav_writer.hpp"
+
+#include <stdexcept>
+
+namespace {
+
+void put_le(std::ofstream& out, uint32_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) out.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+}
+
+bool ends_with(const std::string& s, const std::string& suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+}
+
+WavWriter::WavWriter(const std::string& path, int sample_rate)
+    : wav(ends_with(path, ".wav")), rate(sample_rate)
+{
+    file.open(path, std::ios::binary);
+    if (!file) throw std::runtime_error("Couldn't open audio dump " + path);
+    if (wav) write_header(0); // sizes get patched in close()
+    writer = std::thread([this] { writer_loop(); });
+}
+
+WavWriter::~WavWriter() {
+    close();
+}
+
+void WavWriter::play_samples(const int16_t* samples, int frames) {
+    if (frames <= 0) return;
+    std::unique_lock<std::mutex> lock(mutex);
+    drained_cv.wait(lock, [this] { return pending.size() * sizeof(int16_t) < MAX_PENDING_BYTES || stopping; });
+    if (stopping) return;
+    pending.insert(pending.end(), samples, samples + frames * 2);
+    total_frames += frames;
+    lock.unlock();
+    pending_cv.notify_one();
+}
+
+void WavWriter::writer_loop() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            pending_cv.wait(lock, [this] { return stopping || !pending.empty(); });
+            if (pending.empty()) return; // stopping and drained
+            writing.swap(pending);
+        }
+        drained_cv.notify_one();
+        // WAV and our raw format are both little endian, like every host we build for
+        file.write(reinterpret_cast<const char*>(writing.data()), writing.size() * sizeof(int16_t));
+        writing.clear();
+    }
+}
+
+void WavWriter::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) return;
+        stopping = true;
+    }
+    pending_cv.notify_one();
+    drained_cv.notify_all();
+    writer.join();
+
+    if (wav) {
+        file.seekp(0);
+        write_header(total_frames);
+    }
+    file.close();
+}
+
+void WavWriter::write_header(uint64_t frames) {
+    constexpr int CHANNELS = 2;
+    constexpr int BYTES_PER_SAMPLE = 2;
+    uint32_t data_bytes = static_cast<uint32_t>(frames * CHANNELS * BYTES_PER_SAMPLE);
+
+    file.write("RIFF", 4);
+    put_le(file, 36 + data_bytes, 4);
+    file.write("WAVEfmt ", 8);
+    put_le(file, 16, 4);                                  // fmt chunk size
+    put_le(file, 1, 2);                                   // PCM
+    put_le(file, CHANNELS, 2);
+    put_le(file, rate, 4);
+    put_le(file, rate * CHANNELS * BYTES_PER_SAMPLE, 4);
+    put_le(file, CHANNELS * BYTES_PER_SAMPLE, 2);         // block align
+    put_le(file, BYTES_PER_SAMPLE * 8, 2);
+    file.write("data", 4);
+    put_le(file, data_bytes, 4);
+}
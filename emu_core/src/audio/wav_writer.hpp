@@ -0,0 +1,47 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "audio_sink.hpp"
+
+/**
+ * Dumps the APU output to disk: a 16 bit stereo WAV, or headerless PCM (s16le) when the path doesn't end in .wav.
+ * Blocks are appended to a buffer and written by a background thread. Nothing is ever dropped (the APU waits if the
+ * writer falls more than MAX_PENDING_BYTES behind) and no rate control is applied, so the same ROM and input always
+ * give the same file.
+ */
+class WavWriter : public AudioSink {
+    public:
+        static constexpr size_t MAX_PENDING_BYTES = 4 << 20;
+
+        WavWriter(const std::string& path, int sample_rate);
+        ~WavWriter() override;
+
+        void play_samples(const int16_t* samples, int frames) override;
+        // Flushes everything, fixes up the WAV header and stops the writer thread
+        void close() override;
+        int sample_rate() const override { return rate; }
+
+        uint64_t frames_written() const { return total_frames; }
+
+    private:
+        std::ofstream file;
+        bool wav;
+        int rate;
+        uint64_t total_frames{0};
+
+        std::vector<int16_t> pending;
+        std::vector<int16_t> writing;
+        std::mutex mutex;
+        std::condition_variable pending_cv;  // writer waits for data
+        std::condition_variable drained_cv;  // producer waits for room
+        bool stopping{false};
+        std::thread writer;
+
+        void writer_loop();
+        void write_header(uint64_t frames);
+};
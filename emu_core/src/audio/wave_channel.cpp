@@ -1,11 +1,19 @@
 #include "wave_channel.hpp"
 
-void WaveChannel::tick() {
-    period_div++; // period dividers are clocked at 1048576 Hz (1 M Cycle)
-    if (period_div >= (2048 - period)/2) { //
-        period_div = 0;
-        wave_index = (wave_index + 1) & 0x1F;  // & 0x1F = % 32
-    }
+void WaveChannel::serialize(StateWriter& out) const {
+    out.fields(DAC, initial_length_timer, output_level, period, period_div, trigger_val, length_timer_enable,
+               WAVE_RAM, wave_index, enabled, length_timer, current_volume);
+}
+
+void WaveChannel::deserialize(StateReader& in) {
+    in.fields(DAC, initial_length_timer, output_level, period, period_div, trigger_val, length_timer_enable,
+              WAVE_RAM, wave_index, enabled, length_timer, current_volume);
+}
+
+void WaveChannel::advance(int cycles) {
+    // period dividers are clocked at 1048576 Hz (1 M Cycle)
+    int steps = advance_divider(period_div, (2048 - period) / 2, cycles);
+    wave_index = (wave_index + steps) & 0x1F;  // & 0x1F = % 32
 }
 
 int16_t WaveChannel::sample() {
@@ -1,4 +1,6 @@
 #include <cstdint>
+#include "divider.hpp"
+#include "../core/state_io.hpp"
 #define LENGTH_TIMER_MAX 256
 
 class WaveChannel {
@@ -24,25 +26,36 @@ class WaveChannel {
         void length_timer_tick();
 
         void trigger();
-        void tick();
+        void advance(int cycles);
+        int cycles_to_step() const { return cycles_to_overflow(period_div, (2048 - period) / 2); }
+        bool audible() const { return DAC && enabled && output_level != 0; }
+        // NR52 status: DAC on and not cut by length (or sweep)
+        bool active() const { return DAC && enabled; }
+        // The APU only runs the period divider while this is on
+        bool dac_enabled() const { return DAC; }
+        // NR52 power off
+        void disable() { enabled = false; }
 
         int16_t sample();
 
         uint8_t get_sample();
 
+        void serialize(StateWriter& out) const;
+        void deserialize(StateReader& in);
+
     private:
         bool DAC{true};
-        uint8_t initial_length_timer;
-        uint8_t output_level; // or volume
-        uint16_t period;
-        uint16_t period_div;
-
-        bool trigger_val;
-        bool length_timer_enable;
-        uint8_t WAVE_RAM[16]; // 16 byte ram
+        uint8_t initial_length_timer{0};
+        uint8_t output_level{0}; // or volume
+        uint16_t period{0};
+        uint16_t period_div{0};
+
+        bool trigger_val{false};
+        bool length_timer_enable{false};
+        uint8_t WAVE_RAM[16]{}; // 16 byte ram
         uint8_t wave_index{1};
         bool enabled{true};
-        uint8_t length_timer;
+        uint8_t length_timer{0};
 
         uint8_t current_volume = output_level;
 };
@@ -4,6 +4,24 @@ Bus::Bus(Cart& cart, PPU& ppu, Timer& timer, APU& apu)
     : cart(cart), ppu(ppu), timer(timer), apu(apu)
 {}
 
+void Bus::serialize(StateWriter& out) const {
+    out.begin_section("BUS ");
+    out.fields(IE, IF, serial_data, WRAM, HRAM);
+    out.fields(Joypad::D_PAD.load(), Joypad::KEYS.load());
+    out.end_section();
+}
+
+// Held keys aren't part of the state, they're whatever is held now
+void Bus::deserialize(StateReader& in) {
+    in.begin_section("BUS ");
+    in.fields(IE, IF, serial_data, WRAM, HRAM);
+    bool d_pad, keys;
+    in.fields(d_pad, keys);
+    Joypad::D_PAD = d_pad;
+    Joypad::KEYS = keys;
+    in.end_section();
+}
+
 // 0x0000 - 0x3FFF : ROM Bank 0
 // 0x4000 - 0x7FFF : ROM Bank 1 - Switchable
 // 0x8000 - 0x97FF : CHR RAM / VRAM
@@ -122,7 +140,7 @@ void Bus::write_io(uint16_t addr, uint8_t data) {
         serial_data[1] = data;
     } else if (addr >= 0xFF04 && addr < 0xFF08) {
         bool apu_div_tick = timer.write_timer(addr, data);
-        if (apu_div_tick) apu.apu_div++;
+        if (apu_div_tick) apu.bump_div();
     } else if (addr >= 0xFF40 && addr <= 0xFF4B) {
         ppu.ppu_io_registers_write(addr, data);
     } else if (addr >= 0xFF10 && addr <= 0xFF35) {
@@ -4,6 +4,7 @@
 #include "../graphics/ppu.hpp"
 #include "../joypad/joypad.hpp"
 #include "timer.hpp"
+#include "state_io.hpp"
 #include "../audio/apu.hpp"
 
 class Bus {
@@ -12,6 +13,16 @@ class Bus {
         uint8_t read(uint16_t addr);
         void write(uint16_t addr, uint8_t data);
 
+        // Raw memory for exporters/debug tools
+        const uint8_t* get_wram() const { return WRAM; }
+        const uint8_t* get_hram() const { return HRAM; }
+        static constexpr size_t WRAM_SIZE = 0x2000;
+        static constexpr size_t HRAM_SIZE = 0x80;
+
+        // Memory, interrupt flags and which joypad row is selected. Not the cart or the chips on the bus.
+        void serialize(StateWriter& out) const;
+        void deserialize(StateReader& in);
+
     private:
         Cart& cart;
         PPU& ppu;
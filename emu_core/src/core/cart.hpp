@@ -7,15 +7,41 @@
 #include <stdexcept>
 #include <iostream>
 #include <format>
+#include <span>
+#include <memory>
+#include <chrono>
+#include "mapper.hpp"
+#include "rom_cache.hpp"
+#include "save_writer.hpp"
+#include "state_io.hpp"
 
 class Cart {
     public:
         bool cart_loaded = false;
         void loadFromFile(const std::string& file_path);
-        void write(uint16_t addr, uint8_t data);
-        uint8_t read(uint16_t addr);
+        // ROM images built in memory (the GBS player's), there is no save file
+        void loadFromData(std::vector<uint8_t> data);
+        // 0x0000 - 0x7FFF and 0xA000 - 0xBFFF, straight to the mapper
+        void write(uint16_t addr, uint8_t data) {
+            if (addr < 0x8000) mapper->write_register(addr, data);
+            else mapper->write_ram(addr, data);
+        }
+        uint8_t read(uint16_t addr) const { return addr < 0x8000 ? mapper->read_rom(addr) : mapper->read_ram(addr); }
+        // Writes the battery save at exit. With autosave running that's only the pages it hasn't written yet.
         void create_save_file();
         void load_ram();
+        /**
+         * Starts writing the battery save in the background every interval (SaveWriter). Returns nullptr when the
+         * cart has no battery RAM. The emulator hands it dirty pages once a frame.
+         */
+        SaveWriter* start_autosave(std::chrono::milliseconds interval);
+        const std::vector<uint8_t>& get_ram() const { return ram; }
+
+        // RAM and bank registers for save states. Loaded RAM counts as written, the battery save picks it up.
+        void serialize(StateWriter& out) const;
+        void deserialize(StateReader& in);
+        // Save states only load into the ROM they were made with
+        uint64_t content_hash() const { return rom_image ? rom_image->content_hash() : 0; }
 
         // Cartridge Header metadata
         std::string title;
@@ -27,25 +53,16 @@ class Cart {
         uint8_t cart_type;
 
     private:
-        std::vector<uint8_t> rom;
+        // Shared with every other Cart running the same ROM (RomCache), rom is a view of it
+        std::shared_ptr<const RomImage> rom_image;
+        std::span<const uint8_t> rom;
         std::vector<uint8_t> ram;
         bool save_ram{false};
         std::string file_name;
         std::string file_path;
-        int bank_mode = 0;
-        uint8_t rom_bank_reg = 0x00;
-        uint8_t ram_bank_reg = 0x00;
-        uint8_t rtc_reg = 0x00;
-        int max_banks{2};
-        bool ram_enable{false};
-        bool rtc_enable{false};
-        void parse(const std::vector<uint8_t>& data);
-        void parse_header(const std::vector<uint8_t>& data);
-
-        void write_MBC(uint8_t mbc_mode, uint16_t addr, uint8_t data);
-        uint8_t read_MBC(uint8_t mbc_mode, uint16_t addr);
-
-        uint8_t get_rom_bank();
-
-        uint8_t get_ram_bank();
+        std::unique_ptr<Mapper> mapper;
+        std::unique_ptr<SaveWriter> save_writer;
+        std::string save_path() const { return file_path + file_name + ".sav"; }
+        void parse();
+        void parse_header(std::span<const uint8_t> data);
 };
\ No newline at end of file
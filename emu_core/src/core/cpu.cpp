@@ -7,6 +7,22 @@ CPU::CPU(Bus& bus, Registers& registers)
     : bus(bus), registers(registers)
 {}
 
+void CPU::serialize(StateWriter& out) const {
+    out.begin_section("CPU ");
+    out.fields(registers.A, registers.B, registers.C, registers.D, registers.E, registers.H, registers.L,
+               registers.F, registers.SP, registers.PC);
+    out.fields(IME, halted, halt_bug, IME_delay);
+    out.end_section();
+}
+
+void CPU::deserialize(StateReader& in) {
+    in.begin_section("CPU ");
+    in.fields(registers.A, registers.B, registers.C, registers.D, registers.E, registers.H, registers.L,
+              registers.F, registers.SP, registers.PC);
+    in.fields(IME, halted, halt_bug, IME_delay);
+    in.end_section();
+}
+
 // Executes a single instruction
 int CPU::step() {
     if (this->halted) {
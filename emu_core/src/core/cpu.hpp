@@ -3,6 +3,7 @@
 #include "registers.hpp"
 #include "bus.hpp"
 #include "interrupts.hpp"
+#include "state_io.hpp"
 #include "../log/logger.hpp"
 
 enum class Cond {
@@ -20,7 +21,11 @@ class CPU {
     public:
         CPU(Bus& bus, Registers& registers);
         int step();
-        
+
+        // Save states (SaveState), the registers go with it
+        void serialize(StateWriter& out) const;
+        void deserialize(StateReader& in);
+
     private:
         Bus& bus;
         Registers& registers;
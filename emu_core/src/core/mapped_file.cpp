@@ -0,0 +1,58 @@
+#include "mapped_file.hpp"
+
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+MappedFile::MappedFile(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("File not found");
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        ::close(fd);
+        throw std::runtime_error("Couldn't map empty or unreadable file " + path);
+    }
+    length = static_cast<size_t>(info.st_size);
+
+    // Fault every page in now (one syscall) rather than one page fault at a time while the game runs
+    int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    flags |= MAP_POPULATE;
+#endif
+    void* mapped = mmap(nullptr, length, PROT_READ, flags, fd, 0);
+    ::close(fd); // the mapping keeps the file alive
+    if (mapped == MAP_FAILED) {
+        length = 0;
+        throw std::runtime_error("Couldn't map " + path);
+    }
+#ifndef MAP_POPULATE
+    madvise(mapped, length, MADV_WILLNEED);
+#endif
+    data = static_cast<const uint8_t*>(mapped);
+}
+
+MappedFile::~MappedFile() {
+    unmap();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data(std::exchange(other.data, nullptr)), length(std::exchange(other.length, 0))
+{}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        data = std::exchange(other.data, nullptr);
+        length = std::exchange(other.length, 0);
+    }
+    return *this;
+}
+
+void MappedFile::unmap() {
+    if (data) munmap(const_cast<uint8_t*>(data), length);
+    data = nullptr;
+    length = 0;
+}
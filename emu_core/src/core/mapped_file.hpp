@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+/**
+ * A file mapped read only. Pages come straight from the page cache: nothing is copied, and every process mapping
+ * the same file shares them (a few dozen emulators running the same ROM keep one copy in memory).
+ * Move only, the mapping goes away with the last owner.
+ */
+class MappedFile {
+    public:
+        MappedFile() = default;
+        // Throws std::runtime_error when the file can't be opened or mapped (empty files can't be mapped)
+        explicit MappedFile(const std::string& path);
+        ~MappedFile();
+
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        std::span<const uint8_t> bytes() const { return {data, length}; }
+        size_t size() const { return length; }
+
+    private:
+        const uint8_t* data{nullptr};
+        size_t length{0};
+
+        void unmap();
+};
@@ -0,0 +1,320 @@
+#include "mapper.hpp"
+
+#include <ctime>
+
+Mapper::Mapper(std::span<const uint8_t> rom, std::span<uint8_t> ram, bool has_trailer)
+    : rom(rom), ram(ram), dirty((ram.size() + SAVE_PAGE_SIZE - 1) / SAVE_PAGE_SIZE + has_trailer, 0) {
+    rom_banks[0] = rom_bank(0);
+    rom_banks[1] = rom_bank(1);
+}
+
+const uint8_t* Mapper::rom_bank(unsigned bank) const {
+    return rom.data() + (bank % (rom.size() / ROM_BANK_SIZE)) * ROM_BANK_SIZE;
+}
+
+uint8_t* Mapper::ram_bank(unsigned bank) const {
+    if (ram.size() < RAM_BANK_SIZE) return nullptr;
+    return ram.data() + (bank % (ram.size() / RAM_BANK_SIZE)) * RAM_BANK_SIZE;
+}
+
+void Mapper::map_ram(uint8_t* bank) {
+    ram_window = bank;
+    dirty_window = bank ? dirty.data() + (bank - ram.data()) / SAVE_PAGE_SIZE : nullptr;
+}
+
+RomOnly::RomOnly(std::span<const uint8_t> rom, std::span<uint8_t> ram) : Mapper(rom, ram) {
+    map_ram(ram_bank(0));
+}
+
+Mbc1::Mbc1(std::span<const uint8_t> rom, std::span<uint8_t> ram) : Mapper(rom, ram) {
+    update_banks();
+}
+
+void Mbc1::write_register(uint16_t addr, uint8_t data) {
+    if (addr < 0x2000) {
+        ram_enabled = (data & 0x0F) == 0x0A;
+    } else if (addr < 0x4000) {
+        // If this register is set to $00, it behaves as if it is set to $01.
+        bank1 = data & 0x1F;
+        if (bank1 == 0) bank1 = 1;
+    } else if (addr < 0x6000) {
+        bank2 = data & 0x03;
+    } else {
+        // Small carts see no difference, their bank numbers wrap
+        mode = data & 0x01;
+    }
+    update_banks();
+}
+
+void Mbc1::serialize(StateWriter& out) const {
+    out.fields(ram_enabled, bank1, bank2, mode);
+}
+
+void Mbc1::deserialize(StateReader& in) {
+    in.fields(ram_enabled, bank1, bank2, mode);
+    update_banks();
+}
+
+void Mbc1::update_banks() {
+    rom_banks[0] = rom_bank(mode ? bank2 << 5 : 0);
+    rom_banks[1] = rom_bank(bank2 << 5 | bank1);
+    map_ram(ram_enabled ? ram_bank(mode ? bank2 : 0) : nullptr);
+}
+
+Mbc2::Mbc2(std::span<const uint8_t> rom, std::span<uint8_t> ram) : Mapper(rom, ram) {}
+
+// Bit 8 of the address picks the register: set for the ROM bank, clear for RAM enable
+void Mbc2::write_register(uint16_t addr, uint8_t data) {
+    if (addr >= 0x4000) return;
+    if (addr & 0x0100) {
+        rom_bank_number = data & 0x0F;
+        if (rom_bank_number == 0) rom_bank_number = 1;
+        rom_banks[1] = rom_bank(rom_bank_number);
+    } else {
+        ram_enabled = (data & 0x0F) == 0x0A;
+    }
+}
+
+void Mbc2::serialize(StateWriter& out) const {
+    out.fields(ram_enabled, rom_bank_number);
+}
+
+void Mbc2::deserialize(StateReader& in) {
+    in.fields(ram_enabled, rom_bank_number);
+    rom_banks[1] = rom_bank(rom_bank_number);
+}
+
+// Only the low nibble exists, the upper one reads as 1s. 512 bytes mirrored over the whole window.
+uint8_t Mbc2::read_unmapped(uint16_t addr) const {
+    if (!ram_enabled || ram.size() < RAM_SIZE) return 0xFF;
+    return 0xF0 | (ram[addr & 0x01FF] & 0x0F);
+}
+
+void Mbc2::write_unmapped(uint16_t addr, uint8_t data) {
+    if (!ram_enabled || ram.size() < RAM_SIZE) return;
+    ram[addr & 0x01FF] = data & 0x0F;
+    dirty[(addr & 0x01FF) / SAVE_PAGE_SIZE] = 1;
+}
+
+namespace {
+
+int64_t host_time() {
+    return std::time(nullptr);
+}
+
+void put_le(uint8_t* out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) out[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+uint64_t get_le(const uint8_t* in, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++) value |= static_cast<uint64_t>(in[i]) << (8 * i);
+    return value;
+}
+
+}
+
+Mbc3::Mbc3(std::span<const uint8_t> rom, std::span<uint8_t> ram, bool has_clock)
+    : Mapper(rom, ram, has_clock), has_clock(has_clock), now(host_time), base(host_time()) {
+    update_banks();
+}
+
+void Mbc3::write_register(uint16_t addr, uint8_t data) {
+    if (addr < 0x2000) {
+        ram_enabled = (data & 0x0F) == 0x0A;
+    } else if (addr < 0x4000) {
+        rom_bank_number = data & 0x7F;
+        if (rom_bank_number == 0) rom_bank_number = 1;
+    } else if (addr < 0x6000) {
+        if (data <= 0x0C) select = data;
+    } else {
+        // Latch Clock Data: 0x00 then 0x01 copies the clock into the registers the game reads
+        if (has_clock && last_latch_write == 0x00 && data == 0x01) {
+            clock_registers(latched);
+            mark_trailer_dirty();
+        }
+        last_latch_write = data;
+        return;
+    }
+    update_banks();
+}
+
+void Mbc3::update_banks() {
+    rom_banks[1] = rom_bank(rom_bank_number);
+    map_ram((ram_enabled && select < 0x08) ? ram_bank(select) : nullptr);
+}
+
+uint8_t Mbc3::read_unmapped(uint16_t) const {
+    if (has_clock && ram_enabled && select >= 0x08) return latched[select - 0x08];
+    return 0xFF;
+}
+
+void Mbc3::write_unmapped(uint16_t, uint8_t data) {
+    if (has_clock && ram_enabled && select >= 0x08) write_clock_register(select - 0x08, data);
+}
+
+/**
+ * Seconds on the clock. Past 512 days the day counter wraps and sets carry, that's folded in here.
+ * A save from the future or a host clock that stepped back would read negative, the clock restarts from 0 then.
+ */
+int64_t Mbc3::clock_seconds() const {
+    int64_t seconds = halted ? halted_at : now() - base;
+    if (seconds < 0) {
+        seconds = 0;
+        if (halted) halted_at = 0;
+        else base = now();
+    }
+    if (seconds >= CLOCK_WRAP) {
+        carry = true;
+        seconds %= CLOCK_WRAP;
+        if (halted) halted_at = seconds;
+        else base = now() - seconds;
+    }
+    return seconds;
+}
+
+void Mbc3::set_clock_seconds(int64_t seconds) {
+    if (halted) halted_at = seconds;
+    else base = now() - seconds;
+}
+
+void Mbc3::clock_registers(uint8_t out[5]) const {
+    int64_t seconds = clock_seconds();
+    int64_t days = seconds / SECONDS_PER_DAY;
+    out[0] = seconds % 60;
+    out[1] = seconds / 60 % 60;
+    out[2] = seconds / 3600 % 24;
+    out[3] = days & 0xFF;
+    out[4] = (days >> 8 & 0x01) | (halted ? 0x40 : 0) | (carry ? 0x80 : 0);
+}
+
+/**
+ * Writes set the running clock, not the latched copy. The value is split into fields, one is replaced and it's put
+ * back together. Out of range values (seconds up to 63, hours up to 31) just count as that many.
+ */
+void Mbc3::write_clock_register(int index, uint8_t data) {
+    int64_t seconds = clock_seconds();
+    int64_t s = seconds % 60, m = seconds / 60 % 60, h = seconds / 3600 % 24, days = seconds / SECONDS_PER_DAY;
+    switch (index) {
+        case 0: s = data & 0x3F; break;
+        case 1: m = data & 0x3F; break;
+        case 2: h = data & 0x1F; break;
+        case 3: days = (days & 0x100) | data; break;
+        case 4:
+            days = (days & 0xFF) | (data & 0x01) << 8;
+            carry = data & 0x80;
+            halted = data & 0x40; // from here on seconds go to halted_at, or base restarts from it
+            break;
+    }
+    set_clock_seconds(s + m * 60 + h * 3600 + days * SECONDS_PER_DAY);
+    mark_trailer_dirty();
+}
+
+void Mbc3::write_save_trailer(std::span<uint8_t> out) const {
+    if (!has_clock || out.size() < RTC_TRAILER_SIZE) return;
+    uint8_t current[5];
+    clock_registers(current);
+    for (int i = 0; i < 5; i++) {
+        put_le(out.data() + i * 4, current[i], 4);
+        put_le(out.data() + 20 + i * 4, latched[i], 4);
+    }
+    put_le(out.data() + 40, static_cast<uint64_t>(now()), 8);
+}
+
+// 48 bytes, or 44 from emulators that store the time as 32 bits. Anything else leaves the clock at zero.
+void Mbc3::read_save_trailer(std::span<const uint8_t> in) {
+    if (!has_clock || (in.size() != 44 && in.size() != RTC_TRAILER_SIZE)) return;
+    uint8_t current[5];
+    for (int i = 0; i < 5; i++) {
+        current[i] = static_cast<uint8_t>(get_le(in.data() + i * 4, 4));
+        latched[i] = static_cast<uint8_t>(get_le(in.data() + 20 + i * 4, 4));
+    }
+    int64_t saved_at = static_cast<int64_t>(get_le(in.data() + 40, static_cast<int>(in.size()) - 40));
+    halted = current[4] & 0x40;
+    carry = current[4] & 0x80;
+    int64_t days = current[3] | (current[4] & 0x01) << 8;
+    int64_t seconds = current[0] + current[1] * 60 + current[2] * 3600 + days * SECONDS_PER_DAY;
+    // The clock kept going since it was saved, base is when it read zero
+    if (halted) halted_at = seconds;
+    else base = saved_at - seconds;
+}
+
+void Mbc3::serialize(StateWriter& out) const {
+    out.fields(ram_enabled, rom_bank_number, select);
+    if (!has_clock) return;
+    out.fields(clock_seconds(), halted, carry, latched, last_latch_write);
+}
+
+void Mbc3::deserialize(StateReader& in) {
+    in.fields(ram_enabled, rom_bank_number, select);
+    update_banks();
+    if (!has_clock) return;
+    int64_t seconds;
+    in.fields(seconds, halted, carry, latched, last_latch_write);
+    set_clock_seconds(seconds);
+}
+
+Mbc5::Mbc5(std::span<const uint8_t> rom, std::span<uint8_t> ram, bool rumble)
+    : Mapper(rom, ram), ram_bank_mask(rumble ? 0x07 : 0x0F) {
+    update_banks();
+}
+
+void Mbc5::write_register(uint16_t addr, uint8_t data) {
+    if (addr < 0x2000) {
+        // Only 0x0A enables, the upper nibble counts too
+        ram_enabled = data == 0x0A;
+    } else if (addr < 0x3000) {
+        rom_bank_number = (rom_bank_number & 0x100) | data;
+    } else if (addr < 0x4000) {
+        rom_bank_number = (rom_bank_number & 0xFF) | (data & 0x01) << 8;
+    } else if (addr < 0x6000) {
+        ram_bank_number = data & ram_bank_mask;
+    } else {
+        return;
+    }
+    update_banks();
+}
+
+void Mbc5::serialize(StateWriter& out) const {
+    out.fields(ram_enabled, rom_bank_number, ram_bank_number);
+}
+
+void Mbc5::deserialize(StateReader& in) {
+    in.fields(ram_enabled, rom_bank_number, ram_bank_number);
+    update_banks();
+}
+
+void Mbc5::update_banks() {
+    rom_banks[1] = rom_bank(rom_bank_number);
+    map_ram(ram_enabled ? ram_bank(ram_bank_number) : nullptr);
+}
+
+//https://gbdev.io/pandocs/The_Cartridge_Header.html#0147--cartridge-type
+std::unique_ptr<Mapper> make_mapper(uint8_t cart_type, std::span<const uint8_t> rom, std::span<uint8_t> ram) {
+    switch (cart_type) {
+        case 0x01: // MBC1
+        case 0x02: // MBC1 + RAM
+        case 0x03: // MBC1 + RAM + BATTERY
+            return std::make_unique<Mbc1>(rom, ram);
+        case 0x05: // MBC2
+        case 0x06: // MBC2 + BATTERY
+            return std::make_unique<Mbc2>(rom, ram);
+        case 0x0F: // MBC3 + TIMER + BATTERY
+        case 0x10: // MBC3 + TIMER + RAM + BATTERY
+            return std::make_unique<Mbc3>(rom, ram, true);
+        case 0x11: // MBC3
+        case 0x12: // MBC3 + RAM
+        case 0x13: // MBC3 + RAM + BATTERY
+            return std::make_unique<Mbc3>(rom, ram, false);
+        case 0x19: // MBC5
+        case 0x1A: // MBC5 + RAM
+        case 0x1B: // MBC5 + RAM + BATTERY
+            return std::make_unique<Mbc5>(rom, ram, false);
+        case 0x1C: // MBC5 + RUMBLE
+        case 0x1D: // MBC5 + RUMBLE + RAM
+        case 0x1E: // MBC5 + RUMBLE + RAM + BATTERY
+            return std::make_unique<Mbc5>(rom, ram, true);
+        default: // 0x00 ROM ONLY, 0x08 / 0x09 ROM + RAM (+ BATTERY)
+            return std::make_unique<RomOnly>(rom, ram);
+    }
+}
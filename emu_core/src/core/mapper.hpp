@@ -0,0 +1,196 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+#include "state_io.hpp"
+
+/**
+ * The cartridge's memory bank controller. Picked once when the cart is loaded (make_mapper), so reads don't look at
+ * the cart type anymore.
+ *
+ * Reads are inline and branch free for ROM: rom_banks holds where 0x0000 - 0x3FFF and 0x4000 - 0x7FFF currently
+ * point, and ram_window where 0xA000 - 0xBFFF does. They only change on bank register writes, which are the only
+ * virtual calls. RAM that isn't plain bytes (disabled, MBC2's nibbles, MBC3's clock registers) leaves ram_window
+ * null and goes through read_unmapped / write_unmapped.
+ *
+ * Bank numbers past the end of the ROM or RAM wrap around, like the address lines the chip doesn't have.
+ * The mapper only points into the cart's ROM and RAM, it owns neither.
+ *
+ * RAM writes also mark the 256 byte page they land in as dirty, so battery saves only write what changed
+ * (SaveWriter). That's one extra store per write, reads don't pay anything.
+ */
+class Mapper {
+    public:
+        static constexpr size_t ROM_BANK_SIZE = 0x4000;
+        static constexpr size_t RAM_BANK_SIZE = 0x2000;
+        static constexpr size_t SAVE_PAGE_SIZE = 0x100;
+
+        // rom is a whole number of banks, at least two. ram is empty or a whole number of banks (MBC2: 512 bytes).
+        // has_trailer: the mapper saves state of its own after the RAM (save_trailer_size)
+        Mapper(std::span<const uint8_t> rom, std::span<uint8_t> ram, bool has_trailer = false);
+        virtual ~Mapper() = default;
+
+        // 0x0000 - 0x7FFF
+        uint8_t read_rom(uint16_t addr) const { return rom_banks[addr >> 14][addr & 0x3FFF]; }
+        // 0xA000 - 0xBFFF
+        uint8_t read_ram(uint16_t addr) const { return ram_window ? ram_window[addr & 0x1FFF] : read_unmapped(addr); }
+        void write_ram(uint16_t addr, uint8_t data) {
+            if (ram_window) {
+                ram_window[addr & 0x1FFF] = data;
+                dirty_window[(addr & 0x1FFF) / SAVE_PAGE_SIZE] = 1;
+            } else {
+                write_unmapped(addr, data);
+            }
+        }
+        // 0x0000 - 0x7FFF, bank registers
+        virtual void write_register(uint16_t addr, uint8_t data) = 0;
+
+        // One flag per SAVE_PAGE_SIZE bytes of RAM, set on writes. Whoever saves clears them.
+        // With a trailer there's one more flag at the end, set when the trailer changed.
+        std::span<uint8_t> dirty_pages() { return dirty; }
+
+        // State stored after the RAM in the .sav (MBC3's clock). Most mappers have none.
+        virtual size_t save_trailer_size() const { return 0; }
+        virtual void write_save_trailer(std::span<uint8_t>) const {}
+        // Gets whatever followed the RAM in the .sav, possibly nothing or an older format
+        virtual void read_save_trailer(std::span<const uint8_t>) {}
+
+        // Bank registers for save states (SaveState), the RAM itself is the cart's. RomOnly has nothing to save.
+        virtual void serialize(StateWriter&) const {}
+        virtual void deserialize(StateReader&) {}
+
+    protected:
+        std::span<const uint8_t> rom;
+        std::span<uint8_t> ram;
+        const uint8_t* rom_banks[2];
+        uint8_t* ram_window{nullptr};
+        uint8_t* dirty_window{nullptr}; // dirty flags of the pages ram_window points at
+        std::vector<uint8_t> dirty;
+
+        virtual uint8_t read_unmapped(uint16_t) const { return 0xFF; }
+        virtual void write_unmapped(uint16_t, uint8_t) {}
+
+        const uint8_t* rom_bank(unsigned bank) const;
+        // nullptr when there's no RAM
+        uint8_t* ram_bank(unsigned bank) const;
+        // Points 0xA000 - 0xBFFF at a bank from ram_bank, or nothing (nullptr)
+        void map_ram(uint8_t* bank);
+};
+
+// No MBC: 32 KB of ROM and maybe 8 KB of RAM, always there
+class RomOnly : public Mapper {
+    public:
+        RomOnly(std::span<const uint8_t> rom, std::span<uint8_t> ram);
+        void write_register(uint16_t, uint8_t) override {}
+};
+
+// https://gbdev.io/pandocs/MBC1.html
+class Mbc1 : public Mapper {
+    public:
+        Mbc1(std::span<const uint8_t> rom, std::span<uint8_t> ram);
+        void write_register(uint16_t addr, uint8_t data) override;
+        void serialize(StateWriter& out) const override;
+        void deserialize(StateReader& in) override;
+
+    private:
+        bool ram_enabled{false};
+        uint8_t bank1{1}; // 5 bits, 0 reads as 1
+        uint8_t bank2{0}; // 2 bits: ROM bank bits 5 - 6 or the RAM bank
+        uint8_t mode{0};  // 1: bank2 also applies to 0x0000 - 0x3FFF and RAM
+        void update_banks();
+};
+
+// https://gbdev.io/pandocs/MBC2.html, 512 x 4 bits of RAM built in
+class Mbc2 : public Mapper {
+    public:
+        static constexpr size_t RAM_SIZE = 0x200;
+
+        Mbc2(std::span<const uint8_t> rom, std::span<uint8_t> ram);
+        void write_register(uint16_t addr, uint8_t data) override;
+        void serialize(StateWriter& out) const override;
+        void deserialize(StateReader& in) override;
+
+    private:
+        bool ram_enabled{false};
+        uint8_t rom_bank_number{1};
+        uint8_t read_unmapped(uint16_t addr) const override;
+        void write_unmapped(uint16_t addr, uint8_t data) override;
+};
+
+/**
+ * https://gbdev.io/pandocs/MBC3.html
+ *
+ * The real time clock never ticks. It's a host time at which it read zero (or its value while halted), and the
+ * registers are only worked out when the game latches them, so a running clock costs nothing per cycle. Like on
+ * hardware it keeps running while the emulator is closed: the .sav ends with the usual 48 byte RTC trailer
+ * (current and latched registers as 32 bit values, then the unix time they were saved at) that other emulators use.
+ */
+class Mbc3 : public Mapper {
+    public:
+        static constexpr size_t RTC_TRAILER_SIZE = 48;
+
+        Mbc3(std::span<const uint8_t> rom, std::span<uint8_t> ram, bool has_clock);
+        void write_register(uint16_t addr, uint8_t data) override;
+
+        size_t save_trailer_size() const override { return has_clock ? RTC_TRAILER_SIZE : 0; }
+        void write_save_trailer(std::span<uint8_t> out) const override;
+        void read_save_trailer(std::span<const uint8_t> in) override;
+        // The clock goes in as its value, a loaded state's clock carries on from where it was saved
+        void serialize(StateWriter& out) const override;
+        void deserialize(StateReader& in) override;
+
+        // Unix seconds, replaceable for tests. The clock restarts from zero.
+        using TimeSource = int64_t (*)();
+        void set_time_source(TimeSource source) {
+            now = source;
+            base = now();
+        }
+
+    private:
+        static constexpr int64_t SECONDS_PER_DAY = 86400;
+        static constexpr int64_t CLOCK_WRAP = 512 * SECONDS_PER_DAY; // the day counter is 9 bits
+
+        bool ram_enabled{false}; // RAM and clock
+        uint8_t rom_bank_number{1};
+        uint8_t select{0}; // 0x00 - 0x07 RAM bank, 0x08 - 0x0C clock register
+        void update_banks();
+
+        bool has_clock;
+        TimeSource now;
+        mutable int64_t base;        // host time the clock read 0, while running
+        mutable int64_t halted_at{0}; // clock value, while halted
+        bool halted{false};
+        mutable bool carry{false};   // day counter overflowed, sticks until written
+        // Seconds, minutes, hours, days low, days high / flags, as of the last latch
+        uint8_t latched[5]{};
+        uint8_t last_latch_write{0xFF}; // latching is writing 0x00, then 0x01
+
+        int64_t clock_seconds() const;
+        void set_clock_seconds(int64_t seconds);
+        void clock_registers(uint8_t out[5]) const;
+        void write_clock_register(int index, uint8_t data);
+        void mark_trailer_dirty() { dirty.back() = 1; }
+        uint8_t read_unmapped(uint16_t addr) const override;
+        void write_unmapped(uint16_t addr, uint8_t data) override;
+};
+
+// https://gbdev.io/pandocs/MBC5.html, up to 8 MB ROM and 128 KB RAM
+class Mbc5 : public Mapper {
+    public:
+        Mbc5(std::span<const uint8_t> rom, std::span<uint8_t> ram, bool rumble);
+        void write_register(uint16_t addr, uint8_t data) override;
+        void serialize(StateWriter& out) const override;
+        void deserialize(StateReader& in) override;
+
+    private:
+        bool ram_enabled{false};
+        uint16_t rom_bank_number{1}; // 9 bits, unlike MBC1 bank 0 can be mapped at 0x4000
+        uint8_t ram_bank_number{0};
+        // Rumble carts wire RAM bank bit 3 to the motor, only bits 0 - 2 pick the bank
+        uint8_t ram_bank_mask;
+        void update_banks();
+};
+
+// Header byte 0x0147. Unknown types get RomOnly, like before mappers.
+std::unique_ptr<Mapper> make_mapper(uint8_t cart_type, std::span<const uint8_t> rom, std::span<uint8_t> ram);
@@ -0,0 +1,93 @@
+#include "rom_cache.hpp"
+#include "mapper.hpp"
+#include "rom_index.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <sys/stat.h>
+
+RomImage::RomImage(MappedFile file, uint64_t hash)
+    : file(std::move(file)), rom(this->file.bytes()), unpadded_size(rom.size()), hash(hash) {
+    pad_to_banks();
+}
+
+RomImage::RomImage(std::vector<uint8_t> data, uint64_t hash)
+    : data(std::move(data)), rom(this->data), unpadded_size(rom.size()), hash(hash) {
+    pad_to_banks();
+}
+
+void RomImage::pad_to_banks() {
+    if (rom.size() >= 2 * Mapper::ROM_BANK_SIZE && rom.size() % Mapper::ROM_BANK_SIZE == 0) return;
+    size_t banks = std::max<size_t>(2, (rom.size() + Mapper::ROM_BANK_SIZE - 1) / Mapper::ROM_BANK_SIZE);
+    std::vector<uint8_t> padded(banks * Mapper::ROM_BANK_SIZE, 0xFF);
+    std::copy(rom.begin(), rom.end(), padded.begin());
+    data = std::move(padded);
+    file = MappedFile();
+    rom = data;
+}
+
+RomCache& RomCache::shared() {
+    static RomCache cache;
+    return cache;
+}
+
+size_t RomCache::FileKeyHash::operator()(const FileKey& key) const {
+    return std::hash<uint64_t>()(key.inode * 31 + key.device) ^ std::hash<int64_t>()(key.mtime + key.size);
+}
+
+std::shared_ptr<const RomImage> RomCache::load_file(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) throw std::runtime_error("File not found");
+    FileKey key{static_cast<uint64_t>(info.st_dev), static_cast<uint64_t>(info.st_ino),
+                static_cast<uint64_t>(info.st_size), static_cast<int64_t>(info.st_mtime),
+                static_cast<int64_t>(info.st_ctime)};
+    auto same_file = by_file.find(key);
+    if (same_file != by_file.end()) {
+        if (auto image = same_file->second.lock()) return image;
+    }
+
+    prune();
+    MappedFile file(path);
+    uint64_t hash = rom_hash(file.bytes());
+    std::shared_ptr<const RomImage> image = find_content(hash, file.bytes());
+    if (!image) {
+        image = std::make_shared<const RomImage>(std::move(file), hash);
+        by_hash[hash] = image;
+    }
+    by_file[key] = image;
+    return image;
+}
+
+std::shared_ptr<const RomImage> RomCache::load_data(std::vector<uint8_t> data) {
+    std::lock_guard<std::mutex> lock(mutex);
+    prune();
+    uint64_t hash = rom_hash(data);
+    std::shared_ptr<const RomImage> image = find_content(hash, data);
+    if (!image) {
+        image = std::make_shared<const RomImage>(std::move(data), hash);
+        by_hash[hash] = image;
+    }
+    return image;
+}
+
+// Same hash isn't proof, the bytes are compared too (only ever on a hit, which saves a whole image)
+std::shared_ptr<const RomImage> RomCache::find_content(uint64_t hash, std::span<const uint8_t> content) {
+    auto found = by_hash.find(hash);
+    if (found == by_hash.end()) return nullptr;
+    std::shared_ptr<const RomImage> image = found->second.lock();
+    if (!image || image->original_size() != content.size()) return nullptr;
+    if (!std::equal(content.begin(), content.end(), image->bytes().begin())) return nullptr;
+    return image;
+}
+
+// Images nobody uses anymore are already freed, this drops their entries
+void RomCache::prune() {
+    std::erase_if(by_hash, [](const auto& entry) { return entry.second.expired(); });
+    std::erase_if(by_file, [](const auto& entry) { return entry.second.expired(); });
+}
+
+size_t RomCache::live_images() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return std::count_if(by_hash.begin(), by_hash.end(), [](const auto& entry) { return !entry.second.expired(); });
+}
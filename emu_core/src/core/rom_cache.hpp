@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "mapped_file.hpp"
+
+/**
+ * One loaded ROM, shared read-only by every Cart running it. Always a whole number of 16 KB banks (at least two),
+ * what mappers expect: a file that isn't gets padded with 0xFF, that's the only time the ROM is copied.
+ */
+class RomImage {
+    public:
+        RomImage(MappedFile file, uint64_t hash);
+        RomImage(std::vector<uint8_t> data, uint64_t hash);
+
+        std::span<const uint8_t> bytes() const { return rom; }
+        // Of the file or data it came from, before padding
+        size_t original_size() const { return unpadded_size; }
+        uint64_t content_hash() const { return hash; }
+
+    private:
+        MappedFile file;
+        std::vector<uint8_t> data;
+        std::span<const uint8_t> rom;
+        size_t unpadded_size;
+        uint64_t hash;
+
+        void pad_to_banks();
+};
+
+/**
+ * Process wide, so many emulators running the same game in one process (bots, test sweeps) share one ROM image.
+ * Each Cart only keeps its own RAM and bank registers.
+ *
+ * Images are keyed by content hash (rom_hash) and held by weak_ptr: the cache never keeps a ROM alive, the last
+ * Cart using one frees it. Files are also looked up by identity (device, inode, size, mtimes), so loading a file
+ * that's already in use doesn't even open it. A different file with the same content still ends up on the same
+ * image, after being hashed.
+ */
+class RomCache {
+    public:
+        static RomCache& shared();
+
+        std::shared_ptr<const RomImage> load_file(const std::string& path);
+        // In-memory ROMs (the GBS player's), deduplicated the same way
+        std::shared_ptr<const RomImage> load_data(std::vector<uint8_t> data);
+
+        // Images still in use
+        size_t live_images();
+
+    private:
+        struct FileKey {
+            uint64_t device, inode, size;
+            int64_t mtime, ctime;
+            bool operator==(const FileKey&) const = default;
+        };
+        struct FileKeyHash {
+            size_t operator()(const FileKey& key) const;
+        };
+
+        std::mutex mutex;
+        std::unordered_map<uint64_t, std::weak_ptr<const RomImage>> by_hash;
+        std::unordered_map<FileKey, std::weak_ptr<const RomImage>, FileKeyHash> by_file;
+
+        std::shared_ptr<const RomImage> find_content(uint64_t hash, std::span<const uint8_t> content);
+        void prune();
+};
@@ -0,0 +1,228 @@
+#include "rom_index.hpp"
+#include "mapped_file.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t PRIME3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t PRIME4 = 0x85EBCA77C2B2AE63ULL;
+
+uint64_t rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+// Little endian, like every host we build for
+uint64_t load64(const uint8_t* p) {
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+uint64_t hash_round(uint64_t lane, uint64_t word) {
+    return rotl(lane + word * PRIME2, 31) * PRIME1;
+}
+
+// The title is printable ASCII padded with zeros, anything else would break the index's lines
+std::string clean_title(std::span<const uint8_t> bytes) {
+    std::string title;
+    for (uint8_t c : bytes) {
+        if (c == 0) break;
+        title += (c >= 0x20 && c < 0x7F && c != '\t') ? static_cast<char>(c) : '?';
+    }
+    return title;
+}
+
+}
+
+uint64_t rom_hash(std::span<const uint8_t> data) {
+    const uint8_t* p = data.data();
+    const uint8_t* end = p + data.size();
+    uint64_t hash;
+
+    if (data.size() >= 32) {
+        uint64_t lanes[4] = {PRIME1 + PRIME2, PRIME2, 0, 0 - PRIME1};
+        for (; p + 32 <= end; p += 32) {
+            for (int i = 0; i < 4; i++) lanes[i] = hash_round(lanes[i], load64(p + i * 8));
+        }
+        hash = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18);
+        for (uint64_t lane : lanes) hash = (hash ^ hash_round(0, lane)) * PRIME1 + PRIME4;
+    } else {
+        hash = PRIME3;
+    }
+    hash += data.size();
+
+    for (; p + 8 <= end; p += 8) hash = rotl(hash ^ hash_round(0, load64(p)), 27) * PRIME1 + PRIME4;
+    for (; p < end; p++) hash = rotl(hash ^ (*p * PRIME3), 11) * PRIME1;
+
+    // Avalanche, so every input bit reaches every output bit
+    hash ^= hash >> 33;
+    hash *= PRIME2;
+    hash ^= hash >> 29;
+    hash *= PRIME3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+bool RomIndex::is_rom_path(const std::string& path) {
+    std::string extension = fs::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    return extension == ".gb" || extension == ".gbc";
+}
+
+bool RomIndex::parse_header(std::span<const uint8_t> header, RomEntry& entry) {
+    if (header.size() < HEADER_SIZE) return false;
+    entry.title = clean_title(header.subspan(0x0134, 0x0F));
+    entry.cart_type = header[0x0147];
+    entry.rom_size = header[0x0148];
+    entry.ram_size = header[0x0149];
+    entry.header_checksum = header[0x014D];
+    entry.global_checksum = static_cast<uint16_t>(header[0x014E] << 8 | header[0x014F]);
+
+    // https://gbdev.io/pandocs/The_Cartridge_Header.html#014d--header-checksum
+    uint8_t checksum = 0;
+    for (uint16_t addr = 0x0134; addr <= 0x014C; addr++) checksum = checksum - header[addr] - 1;
+    entry.header_ok = checksum == entry.header_checksum;
+    return true;
+}
+
+bool RomIndex::read_rom(const std::string& path, RomEntry& entry) {
+    try {
+        MappedFile file(path);
+        std::span<const uint8_t> bytes = file.bytes();
+        if (!parse_header(bytes.first(std::min(bytes.size(), HEADER_SIZE)), entry)) return false;
+        entry.hash = rom_hash(bytes);
+        return true;
+    } catch (const std::runtime_error&) {
+        return false;
+    }
+}
+
+void RomIndex::load(const std::string& index_path) {
+    entries.clear();
+    std::ifstream in(index_path);
+    std::string line;
+    if (!std::getline(in, line) || line != FILE_HEADER) return;
+
+    while (std::getline(in, line)) {
+        // Ten tab separated fields, then the path (which may contain tabs)
+        std::vector<std::string> fields;
+        size_t start = 0;
+        for (int i = 0; i < 10; i++) {
+            size_t tab = line.find('\t', start);
+            if (tab == std::string::npos) break;
+            fields.push_back(line.substr(start, tab - start));
+            start = tab + 1;
+        }
+        if (fields.size() != 10) continue;
+        try {
+            RomEntry entry;
+            entry.hash = std::stoull(fields[0], nullptr, 16);
+            entry.size = std::stoull(fields[1]);
+            entry.mtime = std::stoll(fields[2]);
+            entry.cart_type = static_cast<uint8_t>(std::stoul(fields[3], nullptr, 16));
+            entry.rom_size = static_cast<uint8_t>(std::stoul(fields[4], nullptr, 16));
+            entry.ram_size = static_cast<uint8_t>(std::stoul(fields[5], nullptr, 16));
+            entry.header_checksum = static_cast<uint8_t>(std::stoul(fields[6], nullptr, 16));
+            entry.global_checksum = static_cast<uint16_t>(std::stoul(fields[7], nullptr, 16));
+            entry.header_ok = fields[8] == "1";
+            entry.title = fields[9];
+            entry.path = line.substr(start);
+            entries.push_back(std::move(entry));
+        } catch (const std::logic_error&) {
+            continue; // a damaged line only costs that ROM a rescan
+        }
+    }
+    std::sort(entries.begin(), entries.end(), [](const RomEntry& a, const RomEntry& b) { return a.path < b.path; });
+}
+
+void RomIndex::save(const std::string& index_path) const {
+    std::string tmp_path = index_path + ".tmp";
+    {
+        std::ofstream out(tmp_path);
+        if (!out) throw std::runtime_error("Couldn't write ROM index " + tmp_path);
+        out << FILE_HEADER << '\n';
+        char numbers[128];
+        for (const RomEntry& entry : entries) {
+            std::snprintf(numbers, sizeof(numbers), "%016llx\t%llu\t%lld\t%02x\t%02x\t%02x\t%02x\t%04x\t%d\t",
+                          static_cast<unsigned long long>(entry.hash), static_cast<unsigned long long>(entry.size),
+                          static_cast<long long>(entry.mtime), entry.cart_type, entry.rom_size, entry.ram_size,
+                          entry.header_checksum, entry.global_checksum, entry.header_ok ? 1 : 0);
+            out << numbers << entry.title << '\t' << entry.path << '\n';
+        }
+        if (!out) throw std::runtime_error("Couldn't write ROM index " + tmp_path);
+    }
+    if (std::rename(tmp_path.c_str(), index_path.c_str()) != 0) {
+        throw std::runtime_error("Couldn't replace ROM index " + index_path);
+    }
+}
+
+/**
+ * Walking the tree is one thread (it's mostly directory reads the OS caches anyway), reading the ROMs is the pool.
+ * Each new or changed file is its own work item, ROM sizes vary too much for even splits.
+ */
+RomIndex::ScanStats RomIndex::scan(const std::string& root, ThreadPool& pool) {
+    ScanStats stats;
+    std::unordered_map<std::string, const RomEntry*> previous;
+    for (const RomEntry& entry : entries) previous[entry.path] = &entry;
+
+    std::vector<RomEntry> found;
+    std::vector<int> to_read;
+    int still_there = 0;
+    std::error_code error;
+    auto options = fs::directory_options::skip_permission_denied;
+    for (auto it = fs::recursive_directory_iterator(root, options, error); !error && it != fs::end(it);
+         it.increment(error)) {
+        // A file that vanished or can't be stat'ed is skipped, it doesn't end the walk
+        std::error_code file_error;
+        if (!it->is_regular_file(file_error) || !is_rom_path(it->path().string())) continue;
+        RomEntry entry;
+        entry.path = it->path().string();
+        entry.size = it->file_size(file_error);
+        entry.mtime = it->last_write_time(file_error).time_since_epoch().count();
+        if (file_error) continue;
+        auto old = previous.find(entry.path);
+        if (old != previous.end()) still_there++;
+        if (old != previous.end() && old->second->size == entry.size && old->second->mtime == entry.mtime) {
+            found.push_back(*old->second);
+            stats.unchanged++;
+        } else {
+            to_read.push_back(static_cast<int>(found.size()));
+            found.push_back(std::move(entry));
+        }
+    }
+    if (error) throw std::runtime_error("Couldn't scan " + root + ": " + error.message());
+
+    std::vector<uint8_t> ok(found.size(), 1);
+    pool.parallel_for(static_cast<int>(to_read.size()), [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            int index = to_read[i];
+            ok[index] = read_rom(found[index].path, found[index]);
+        }
+    }, 1);
+
+    std::vector<RomEntry> readable;
+    readable.reserve(found.size());
+    for (size_t i = 0; i < found.size(); i++) {
+        if (ok[i]) readable.push_back(std::move(found[i]));
+        else stats.failed++;
+    }
+    stats.read = static_cast<int>(to_read.size()) - stats.failed;
+    std::sort(readable.begin(), readable.end(), [](const RomEntry& a, const RomEntry& b) { return a.path < b.path; });
+
+    stats.removed = static_cast<int>(entries.size()) - still_there;
+    entries = std::move(readable);
+    return stats;
+}
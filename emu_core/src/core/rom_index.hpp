@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+#include "thread_pool.hpp"
+
+/**
+ * 64 bit hash of a whole ROM, 32 bytes per round in four independent lanes (xxHash64's structure). Fast enough
+ * that hashing a library is bound by reading it. Not cryptographic, it only has to tell dumps apart.
+ */
+uint64_t rom_hash(std::span<const uint8_t> data);
+
+// What the launcher shows for one ROM, from its header (https://gbdev.io/pandocs/The_Cartridge_Header.html)
+struct RomEntry {
+    std::string path;
+    uint64_t size{0};
+    int64_t mtime{0}; // file time ticks, only ever compared to itself
+    uint64_t hash{0};
+    std::string title;
+    uint8_t cart_type{0};
+    uint8_t rom_size{0};
+    uint8_t ram_size{0};
+    uint8_t header_checksum{0};
+    uint16_t global_checksum{0};
+    bool header_ok{false}; // header checksum matches, a bad one usually means it isn't a ROM
+};
+
+/**
+ * The ROM library behind --scan: every .gb / .gbc under a directory, saved as a text file the launcher can read.
+ *
+ * Rescans are incremental, files whose size and mtime haven't changed keep their entry without being opened. New
+ * and changed ones are read on a ThreadPool: the 0x150 byte header for the fields, and the whole file (mapped) for
+ * the hash.
+ *
+ * The file is one line per ROM after a version line, tab separated, path last so it can hold anything but a newline:
+ *     hash size mtime cart_type rom_size ram_size header_checksum global_checksum header_ok title path
+ * Numbers are hex except size and mtime.
+ */
+class RomIndex {
+    public:
+        static constexpr const char* FILE_HEADER = "# GameBoyCpp ROM index 1";
+        static constexpr size_t HEADER_SIZE = 0x150;
+
+        struct ScanStats {
+            int read{0};      // new or changed, opened and hashed
+            int unchanged{0}; // kept from the previous index
+            int removed{0};   // in the previous index but gone
+            int failed{0};    // too small or unreadable, left out
+        };
+
+        // A missing or unreadable index just means everything gets read
+        void load(const std::string& index_path);
+        // Written to a temporary file and renamed, the launcher never sees half an index
+        void save(const std::string& index_path) const;
+        ScanStats scan(const std::string& root, ThreadPool& pool);
+
+        // Sorted by path
+        const std::vector<RomEntry>& get_entries() const { return entries; }
+
+        static bool is_rom_path(const std::string& path);
+        // Fills everything but path, size and mtime. False when the file isn't a ROM we can read.
+        static bool read_rom(const std::string& path, RomEntry& entry);
+        static bool parse_header(std::span<const uint8_t> header, RomEntry& entry);
+
+    private:
+        std::vector<RomEntry> entries;
+};
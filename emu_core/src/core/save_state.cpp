@@ -0,0 +1,113 @@
+#include "save_state.hpp"
+#include "mapped_file.hpp"
+#include "rom_index.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+SaveState::SaveState(CPU& cpu, Bus& bus, Cart& cart, PPU& ppu, Timer& timer, APU& apu, std::string hotkey_path)
+    : cpu(cpu), bus(bus), cart(cart), ppu(ppu), timer(timer), apu(apu), hotkey_path(std::move(hotkey_path))
+{}
+
+std::vector<uint8_t> SaveState::save() {
+    StateWriter out;
+    out.data().reserve(last_size);
+    out.bytes(MAGIC, sizeof(MAGIC));
+    out.fields(VERSION, cart.content_hash(), uint64_t{0});
+    cpu.serialize(out);
+    bus.serialize(out);
+    cart.serialize(out);
+    ppu.serialize(out);
+    timer.serialize(out);
+    apu.serialize(out);
+
+    std::vector<uint8_t>& state = out.data();
+    StateWriter hash;
+    hash.fields(rom_hash(std::span<const uint8_t>(state).subspan(HEADER_SIZE)));
+    std::copy(hash.data().begin(), hash.data().end(), state.begin() + HEADER_SIZE - hash.data().size());
+    last_size = state.size();
+    return std::move(state);
+}
+
+/**
+ * The header and hash catch most bad states before anything is touched. Past that a section can still disagree
+ * with this build, so the current state is saved first and put back if reading fails halfway.
+ */
+void SaveState::load(std::span<const uint8_t> state) {
+    check_header(state);
+    std::vector<uint8_t> backup = save();
+    try {
+        apply(state);
+    } catch (const std::runtime_error&) {
+        apply(backup);
+        throw;
+    }
+}
+
+void SaveState::check_header(std::span<const uint8_t> state) {
+    if (state.size() < HEADER_SIZE || std::memcmp(state.data(), MAGIC, sizeof(MAGIC)) != 0) {
+        throw std::runtime_error("Not a save state");
+    }
+    StateReader header(state.subspan(sizeof(MAGIC), HEADER_SIZE - sizeof(MAGIC)));
+    uint16_t version;
+    uint64_t rom, hash;
+    header.fields(version, rom, hash);
+    if (version != VERSION) {
+        throw std::runtime_error("Save state version " + std::to_string(version) + ", this build reads version " +
+                                 std::to_string(VERSION));
+    }
+    if (rom != cart.content_hash()) throw std::runtime_error("Save state is from a different ROM");
+    if (hash != rom_hash(state.subspan(HEADER_SIZE))) throw std::runtime_error("Save state is corrupted");
+}
+
+void SaveState::apply(std::span<const uint8_t> state) {
+    StateReader in(state.subspan(HEADER_SIZE));
+    cpu.deserialize(in);
+    bus.deserialize(in);
+    cart.deserialize(in);
+    ppu.deserialize(in);
+    timer.deserialize(in);
+    apu.deserialize(in);
+    if (in.offset() != in.data().size()) throw std::runtime_error("Save state has data this version doesn't know");
+}
+
+void SaveState::save_file(const std::string& path) {
+    std::vector<uint8_t> state = save();
+    std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(state.data()), static_cast<std::streamsize>(state.size()));
+        if (!out) throw std::runtime_error("Couldn't write save state " + tmp_path);
+    }
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Couldn't replace save state " + path);
+    }
+}
+
+void SaveState::load_file(const std::string& path) {
+    MappedFile file(path);
+    load(file.bytes());
+}
+
+void SaveState::handle_hotkeys() {
+    bool save_requested = Joypad::SAVE_STATE_REQUESTED.exchange(false);
+    bool load_requested = Joypad::LOAD_STATE_REQUESTED.exchange(false);
+    if ((!save_requested && !load_requested) || hotkey_path.empty()) return;
+
+    auto start = std::chrono::steady_clock::now();
+    try {
+        if (save_requested) save_file(hotkey_path);
+        if (load_requested) load_file(hotkey_path);
+    } catch (const std::runtime_error& e) {
+        std::cout << e.what() << std::endl;
+        return;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    std::cout << (load_requested ? "Loaded state " : "Saved state ") << hotkey_path << " in " << elapsed.count()
+              << " us" << std::endl;
+}
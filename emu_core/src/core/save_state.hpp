@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+#include "cpu.hpp"
+#include "state_io.hpp"
+
+/**
+ * Save states: the whole machine as one binary snapshot, loaded with --load-state or saved / loaded with F5 / F8.
+ *
+ *  magic "GBST" | version (u16) | ROM hash (u64) | hash of the rest (u64) | CPU | BUS | CART | PPU | TIMR | APU
+ *
+ * Each component serializes its own fields into its section (see StateWriter). Everything is raw memory and
+ * registers, about 40 KB plus the cart's RAM, so saving and loading are a few memcpys and one hash each: tens of
+ * microseconds. A state only loads into the ROM it was saved from and the version that wrote it.
+ *
+ * Not in a state: which keys are held (that's the player, not the machine) and the audio output pipeline.
+ */
+class SaveState {
+    public:
+        static constexpr char MAGIC[4] = {'G', 'B', 'S', 'T'};
+        static constexpr uint16_t VERSION = 1;
+        static constexpr size_t HEADER_SIZE = 4 + 2 + 8 + 8;
+
+        // hotkey_path: where F5 saves and F8 loads
+        SaveState(CPU& cpu, Bus& bus, Cart& cart, PPU& ppu, Timer& timer, APU& apu, std::string hotkey_path = "");
+
+        std::vector<uint8_t> save();
+        // Throws std::runtime_error when the state can't be loaded, the machine is then left as it was
+        void load(std::span<const uint8_t> state);
+
+        // Written to a temporary file and renamed, a crash mid save keeps the old state
+        void save_file(const std::string& path);
+        void load_file(const std::string& path);
+
+        // Emulation thread, between frames. A save or load that fails is reported, the game goes on.
+        void handle_hotkeys();
+
+    private:
+        CPU& cpu;
+        Bus& bus;
+        Cart& cart;
+        PPU& ppu;
+        Timer& timer;
+        APU& apu;
+        std::string hotkey_path;
+        size_t last_size{0}; // of the last state, the next one is the same size
+
+        void check_header(std::span<const uint8_t> state);
+        void apply(std::span<const uint8_t> state);
+};
@@ -0,0 +1,191 @@
+#include "save_writer.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t PAGE = Mapper::SAVE_PAGE_SIZE;
+
+bool pwrite_all(int fd, const uint8_t* data, size_t size, off_t offset) {
+    while (size > 0) {
+        ssize_t written = pwrite(fd, data, size, offset);
+        if (written < 0) return false;
+        data += written;
+        size -= written;
+        offset += written;
+    }
+    return true;
+}
+
+// Makes a rename stick, the directory entry is only durable once the directory is synced
+void sync_directory(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    std::string dir = slash == std::string::npos ? "." : path.substr(0, slash + 1);
+    int fd = open(dir.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    fsync(fd);
+    ::close(fd);
+}
+
+// Atomically swaps the two names, false when the OS or filesystem can't
+bool exchange(const std::string& a, const std::string& b) {
+#if defined(RENAME_EXCHANGE)
+    return renameat2(AT_FDCWD, a.c_str(), AT_FDCWD, b.c_str(), RENAME_EXCHANGE) == 0;
+#elif defined(RENAME_SWAP)
+    return renamex_np(a.c_str(), b.c_str(), RENAME_SWAP) == 0; // macOS
+#else
+    return false;
+#endif
+}
+
+// On macOS fsync only reaches the drive's cache
+bool sync_file(int fd) {
+#ifdef F_FULLFSYNC
+    if (fcntl(fd, F_FULLFSYNC) == 0) return true;
+#endif
+    return fsync(fd) == 0;
+}
+
+}
+
+SaveWriter::SaveWriter(const std::string& path, std::span<const uint8_t> ram, Mapper& mapper,
+                       std::chrono::milliseconds interval)
+    : path(path), tmp_path(path + ".tmp"), ram(ram), mapper(mapper), dirty(mapper.dirty_pages()),
+      ram_pages((ram.size() + PAGE - 1) / PAGE), interval(interval),
+      image(ram.begin(), ram.end()), tmp_stale(dirty.size(), 0), save_stale(dirty.size(), 0)
+{
+    image.resize(ram.size() + mapper.save_trailer_size());
+    mapper.write_save_trailer(std::span<uint8_t>(image).subspan(ram.size()));
+    writer = std::thread([this] { writer_loop(); });
+}
+
+SaveWriter::~SaveWriter() {
+    close();
+}
+
+size_t SaveWriter::page_start(size_t page) const {
+    return page < ram_pages ? page * PAGE : ram.size();
+}
+
+size_t SaveWriter::page_size(size_t page) const {
+    return page < ram_pages ? std::min(PAGE, ram.size() - page * PAGE) : mapper.save_trailer_size();
+}
+
+// Copies the dirty pages out, runs on the emulation thread so RAM can't change under it
+void SaveWriter::hand_off() {
+    std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+    if (!lock.owns_lock()) return;
+    for (size_t page = 0; page < dirty.size(); page++) {
+        if (!dirty[page]) continue;
+        dirty[page] = 0;
+        pending_pages.push_back(static_cast<uint16_t>(page));
+        size_t offset = pending_data.size();
+        pending_data.resize(offset + page_size(page));
+        if (page < ram_pages) {
+            std::copy_n(ram.begin() + page_start(page), page_size(page), pending_data.begin() + offset);
+        } else {
+            mapper.write_save_trailer(std::span<uint8_t>(pending_data).subspan(offset));
+        }
+    }
+    wants_pages.store(false, std::memory_order_relaxed);
+    lock.unlock();
+    cv.notify_all();
+}
+
+void SaveWriter::take_pending(std::vector<uint16_t>& pages, std::vector<uint8_t>& data) {
+    pages.clear();
+    data.clear();
+    pages.swap(pending_pages);
+    data.swap(pending_data);
+}
+
+void SaveWriter::apply(const std::vector<uint16_t>& pages, const std::vector<uint8_t>& data) {
+    size_t offset = 0;
+    for (uint16_t page : pages) {
+        std::memcpy(image.data() + page_start(page), data.data() + offset, page_size(page));
+        offset += page_size(page);
+        tmp_stale[page] = 1;
+        save_stale[page] = 1;
+    }
+}
+
+/**
+ * Brings .tmp up to date, then makes it the save. Nothing happens when the save is already current.
+ * On failure the stale flags stay, the next interval tries again.
+ */
+bool SaveWriter::flush() {
+    if (std::find(save_stale.begin(), save_stale.end(), 1) == save_stale.end()) return true;
+
+    int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | (tmp_valid ? 0 : O_TRUNC), 0644);
+    bool ok = fd >= 0;
+    if (ok && !tmp_valid) {
+        ok = pwrite_all(fd, image.data(), image.size(), 0);
+    } else if (ok) {
+        for (size_t page = 0; ok && page < tmp_stale.size(); page++) {
+            if (!tmp_stale[page]) continue;
+            ok = pwrite_all(fd, image.data() + page_start(page), page_size(page), page_start(page));
+        }
+    }
+    if (ok) ok = sync_file(fd);
+    if (fd >= 0) ::close(fd);
+    if (!ok) {
+        tmp_valid = false;
+        std::cerr << "Couldn't write save file " << tmp_path << std::endl;
+        return false;
+    }
+
+    if (exchange(tmp_path, path)) {
+        // The old save is the new .tmp, it's missing whatever the save was missing
+        tmp_stale.swap(save_stale);
+        tmp_valid = true;
+    } else if (std::rename(tmp_path.c_str(), path.c_str()) == 0) {
+        tmp_valid = false; // no save to reuse, the first flush always ends up here
+    } else {
+        tmp_valid = false;
+        std::cerr << "Couldn't replace save file " << path << std::endl;
+        return false;
+    }
+    std::fill(save_stale.begin(), save_stale.end(), 0);
+    sync_directory(path);
+    flushes.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void SaveWriter::writer_loop() {
+    std::vector<uint16_t> pages;
+    std::vector<uint8_t> data;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!cv.wait_for(lock, interval, [this] { return stopping; })) {
+        wants_pages.store(true, std::memory_order_relaxed);
+        cv.wait(lock, [this] { return stopping || !wants_pages.load(std::memory_order_relaxed); });
+        if (stopping) return; // close() picks up what was handed off
+        take_pending(pages, data);
+        lock.unlock();
+        apply(pages, data);
+        flush();
+        lock.lock();
+    }
+}
+
+void SaveWriter::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (closed) return;
+        closed = stopping = true;
+    }
+    cv.notify_all();
+    writer.join();
+
+    // Only this thread is left, the last handoff can't miss
+    hand_off();
+    std::vector<uint16_t> pages;
+    std::vector<uint8_t> data;
+    take_pending(pages, data);
+    apply(pages, data);
+    flush();
+}
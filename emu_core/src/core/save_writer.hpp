@@ -0,0 +1,79 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+#include "mapper.hpp"
+
+/**
+ * Keeps a battery save on disk while the game runs, so a crash or kill loses at most one interval.
+ *
+ * The emulation thread calls collect() once a frame. Usually that's one relaxed load. Once per interval the writer
+ * thread asks for pages, and the next collect() copies the dirty ones (Mapper::dirty_pages) over. It only try_locks,
+ * so when the writer is busy the handoff waits for the next frame and emulation never does.
+ *
+ * Writes are crash safe: dirty pages are pwritten into <save>.tmp, which gets fsynced and then swapped with the save
+ * (renameat2 RENAME_EXCHANGE). The old save becomes the next .tmp, one flush behind, so only the pages changed since
+ * then need writing. Without exchange the .tmp is renamed over the save and the next flush writes a whole new one.
+ * The save file is either the old or the new RAM, never half of each.
+ *
+ * Mappers with a save trailer (MBC3's clock) get it written after the RAM, it's handed off like one more page.
+ */
+class SaveWriter {
+    public:
+        // ram is the cart's RAM and mapper the mapper over it, both have to outlive the writer
+        SaveWriter(const std::string& path, std::span<const uint8_t> ram, Mapper& mapper,
+                   std::chrono::milliseconds interval);
+        ~SaveWriter();
+        SaveWriter(const SaveWriter&) = delete;
+        SaveWriter& operator=(const SaveWriter&) = delete;
+
+        // Emulation thread, between instructions
+        void collect() {
+            if (wants_pages.load(std::memory_order_relaxed)) hand_off();
+        }
+        // Stops the thread and writes whatever is still dirty. Emulation has to be stopped by then.
+        void close();
+
+        uint64_t flush_count() const { return flushes.load(std::memory_order_relaxed); }
+
+    private:
+        std::string path;
+        std::string tmp_path;
+        std::span<const uint8_t> ram;
+        Mapper& mapper;
+        std::span<uint8_t> dirty;
+        size_t ram_pages;
+        std::chrono::milliseconds interval;
+
+        // Handoff, guarded by mutex
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::atomic<bool> wants_pages{false};
+        std::vector<uint16_t> pending_pages;
+        std::vector<uint8_t> pending_data;
+        bool stopping{false};
+        bool closed{false};
+
+        // Writer thread only (and close() after the join)
+        std::vector<uint8_t> image;      // RAM and trailer as of the last handoff
+        std::vector<uint8_t> tmp_stale;  // pages where .tmp differs from image
+        std::vector<uint8_t> save_stale; // pages where the save differs from image
+        bool tmp_valid{false};           // false: .tmp is missing or junk, write all of it
+        std::atomic<uint64_t> flushes{0};
+        std::thread writer;
+
+        // Where a page is in the file: RAM pages, then the trailer
+        size_t page_start(size_t page) const;
+        size_t page_size(size_t page) const;
+        void hand_off();
+        void take_pending(std::vector<uint16_t>& pages, std::vector<uint8_t>& data);
+        void apply(const std::vector<uint16_t>& pages, const std::vector<uint8_t>& data);
+        bool flush();
+        void writer_loop();
+};
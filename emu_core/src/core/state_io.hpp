@@ -0,0 +1,116 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/**
+ * What components write their save state with (see SaveState). Fields are little endian bytes in the order they're
+ * given, no names and no padding, so serialize() and deserialize() have to list the same fields in the same
+ * order. Each component's fields go in a section (4 character tag + length), a reader that doesn't end exactly at
+ * the end of its section means the two sides disagree and the state is rejected.
+ */
+// Numbers (and enums) get swapped on big endian hosts. Anything else is copied as is, so it has to be made of bytes:
+// byte arrays, structs of uint8_t.
+template <typename T>
+constexpr void check_field() {
+    static_assert(std::is_trivially_copyable_v<T>, "State fields are copied as bytes");
+    static_assert(std::is_scalar_v<T> || alignof(T) == 1, "Only numbers and byte arrays have a byte order we know");
+}
+
+class StateWriter {
+    public:
+        template <typename... T>
+        void fields(const T&... values) { (put(values), ...); }
+
+        void bytes(const void* data, size_t size) {
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            out.insert(out.end(), bytes, bytes + size);
+        }
+
+        void begin_section(const char (&tag)[5]) {
+            bytes(tag, 4);
+            section_start = out.size();
+            put(uint32_t{0}); // length, filled in by end_section
+        }
+        void end_section() {
+            uint32_t length = static_cast<uint32_t>(out.size() - section_start - sizeof(uint32_t));
+            for (size_t i = 0; i < sizeof(length); i++) {
+                out[section_start + i] = static_cast<uint8_t>(length >> (8 * i));
+            }
+        }
+
+        std::vector<uint8_t>& data() { return out; }
+
+    private:
+        std::vector<uint8_t> out;
+        size_t section_start{0};
+
+        template <typename T>
+        void put(const T& value) {
+            check_field<T>();
+            size_t at = out.size();
+            bytes(&value, sizeof(T));
+            if constexpr (std::is_scalar_v<T> && std::endian::native == std::endian::big) {
+                std::reverse(out.begin() + at, out.end());
+            }
+        }
+};
+
+// Throws std::runtime_error when the state runs out or a section doesn't match
+class StateReader {
+    public:
+        explicit StateReader(std::span<const uint8_t> data) : in(data) {}
+
+        template <typename... T>
+        void fields(T&... values) { (get(values), ...); }
+
+        void bytes(void* data, size_t size) {
+            if (size > in.size() - position) throw std::runtime_error("Save state is truncated");
+            std::memcpy(data, in.data() + position, size);
+            position += size;
+        }
+
+        void begin_section(const char (&tag)[5]) {
+            char found[4];
+            bytes(found, 4);
+            if (std::memcmp(found, tag, 4) != 0) throw std::runtime_error(std::string("Save state has no ") + tag);
+            uint32_t length;
+            get(length);
+            if (length > in.size() - position) throw std::runtime_error("Save state is truncated");
+            section_end = position + length;
+        }
+        void end_section() {
+            if (position != section_end) throw std::runtime_error("Save state section doesn't match this version");
+        }
+
+        size_t offset() const { return position; }
+        std::span<const uint8_t> data() const { return in; }
+
+    private:
+        std::span<const uint8_t> in;
+        size_t position{0};
+        size_t section_end{0};
+
+        template <typename T>
+        void get(T& value) {
+            check_field<T>();
+            if constexpr (std::is_same_v<T, bool>) {
+                // Any byte but 0 is true, a bool holding anything else isn't a bool
+                uint8_t byte;
+                bytes(&byte, 1);
+                value = byte != 0;
+            } else {
+                bytes(&value, sizeof(T));
+                if constexpr (std::is_scalar_v<T> && std::endian::native == std::endian::big) {
+                    uint8_t* raw = reinterpret_cast<uint8_t*>(&value);
+                    std::reverse(raw, raw + sizeof(T));
+                }
+            }
+        }
+};
@@ -0,0 +1,72 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(int workers) {
+    for (int i = 0; i < workers; i++) {
+        this->workers.emplace_back([this] { worker_loop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    work_cv.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallel_for(int count, const std::function<void(int, int)>& fn, int chunk) {
+    if (count <= 0) return;
+    if (chunk <= 0) chunk = std::max(1, (count + thread_count() - 1) / thread_count());
+
+    if (workers.empty() || chunk >= count) {
+        fn(0, count);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &fn;
+        job_count = count;
+        job_chunk = chunk;
+        next_index = 0;
+        busy_workers = static_cast<int>(workers.size());
+        generation++;
+    }
+    work_cv.notify_all();
+
+    run_chunks();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done_cv.wait(lock, [this] { return busy_workers == 0; });
+    job = nullptr;
+}
+
+void ThreadPool::worker_loop() {
+    uint64_t seen_generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            work_cv.wait(lock, [&] { return stopping || generation != seen_generation; });
+            if (stopping) return;
+            seen_generation = generation;
+        }
+
+        run_chunks();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busy_workers == 0) done_cv.notify_one();
+    }
+}
+
+// Grab ranges until the job runs out. Shared by the workers and the thread that called parallel_for.
+void ThreadPool::run_chunks() {
+    int begin;
+    while ((begin = next_index.fetch_add(job_chunk, std::memory_order_relaxed)) < job_count) {
+        (*job)(begin, std::min(begin + job_chunk, job_count));
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Small fixed size pool for splitting one job (rows of a frame, files of a directory...) across threads.
+ * The calling thread always helps out, so a pool with 0 workers simply runs the job inline.
+ */
+class ThreadPool {
+    public:
+        explicit ThreadPool(int workers);
+        ~ThreadPool();
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /**
+         * Runs fn(begin, end) over [0, count) in ranges of `chunk` items (0 = split evenly between threads).
+         * Returns once every range has finished.
+         */
+        void parallel_for(int count, const std::function<void(int, int)>& fn, int chunk = 0);
+
+        int thread_count() const { return static_cast<int>(workers.size()) + 1; }
+
+    private:
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable work_cv;
+        std::condition_variable done_cv;
+
+        const std::function<void(int, int)>* job{nullptr};
+        int job_count{0};
+        int job_chunk{1};
+        std::atomic<int> next_index{0};
+        int busy_workers{0};
+        uint64_t generation{0};
+        bool stopping{false};
+
+        void worker_loop();
+        void run_chunks();
+};
@@ -2,102 +2,112 @@
 
 #include <stdexcept>
 
-
-bool Timer::tick(int clock_cycles) {
-    bool apu_div_tick = tick_div(clock_cycles);
-    if (TAC & 0x04) {
-        tick_tima(clock_cycles + tima_remainder);
-    }
-
-    return apu_div_tick;
+// The overflow schedule is saved as is, it's a counter value like the rest
+void Timer::serialize(StateWriter& out) const {
+    out.begin_section("TIMR");
+    out.fields(counter, TIMA, TMA, TAC, tima_counter, overflow_at, reloading, interrupt);
+    out.end_section();
 }
 
-void Timer::tick_tima(int clock_cycles) {
-
-    if (tima_overflow_pending > 0) {
-        tima_overflow_pending -= clock_cycles;
-        if (tima_overflow_pending <= 0) {
-            TIMA = TMA;
-            interrupt = true;
-            tima_overflow_pending = 0;
-        }
-    }
+void Timer::deserialize(StateReader& in) {
+    in.begin_section("TIMR");
+    in.fields(counter, TIMA, TMA, TAC, tima_counter, overflow_at, reloading, interrupt);
+    in.end_section();
+}
 
-    int divisor = 0;
-    switch (TAC & 0x03) {
-        case 0b00: divisor = 256; break;
-        case 0b01: divisor = 4;   break;
-        case 0b10: divisor = 16;   break;
-        case 0b11: divisor = 64;  break;
+/**
+ * TIMA wrapped somewhere in the last tick. It reads 0 for one M cycle, then TMA gets loaded and the interrupt is
+ * requested. A tick that ends right on the wrap leaves it reloading, the next tick finishes the job.
+ */
+void Timer::overflow() {
+    if (reloading) {
+        reloading = false;
+        TIMA = TMA;
+        interrupt = true;
+        schedule_overflow(); // edges still count from the wrap, tima_counter was left there
     }
-
-    int ticks = clock_cycles / divisor;
-    tima_remainder = clock_cycles % divisor;
-
-    for (int i = 0; i < ticks; i++) {
-        if (TIMA == 0xFF) {
-            TIMA = TMA;
-            tima_overflow_pending = 4;
-        } else {
-            TIMA++;
+    while (counter >= overflow_at) {
+        tima_counter = overflow_at;
+        if (counter == overflow_at) {
+            TIMA = 0;
+            reloading = true;
+            overflow_at = NEVER;
+            return;
         }
+        TIMA = TMA;
+        interrupt = true;
+        schedule_overflow();
     }
 }
 
-/**
- * 1048576Hz is 1 M cycle
- * The timer increments every 16384Hz
- * 16384hz = 64 M (or clock_cycles)
- * Essentially, DIV will increment once every 64 M cycles
- * @returns apu_div_tick
- */
-bool Timer::tick_div(int clock_cycles) {
-    int total_cycles = clock_cycles + div_remainder;
+// Brings TIMA up to the current counter. Never carries it past 0xFF, overflow() runs first.
+void Timer::sync_tima() {
+    if ((TAC & 0x04) && !reloading) {
+        int s = shift();
+        TIMA += static_cast<uint8_t>((counter >> s) - (tima_counter >> s));
+    }
+    tima_counter = counter;
+}
 
-    // This indicates our div will actually increment, so now we should to see if apu_div should be updated.
-    // We check that be seeing if bit 4 ( 0b00010000) changed from 1 to 0
-    if (total_cycles >= 64) {
-        bool div_bit4_0 = DIV & 0b00010000;
-        DIV++;
-        bool div_bit4_1 = DIV & 0b00010000;
-        if (div_bit4_0 && !div_bit4_1) {
-            return true;
-        }
+// One extra TIMA count from a falling edge caused by a register write
+void Timer::increment_tima() {
+    if (reloading) return;
+    if (TIMA == 0xFF) {
+        TIMA = 0;
+        reloading = true;
+    } else {
+        TIMA++;
     }
+}
 
-    div_remainder = total_cycles % 64;
-    return false;
+// The overflow is 0x100 - TIMA falling edges away, edges land on multiples of the period
+void Timer::schedule_overflow() {
+    overflow_at = NEVER;
+    if (!(TAC & 0x04) || reloading) return;
+    int s = shift();
+    overflow_at = ((tima_counter >> s) + (0x100 - TIMA)) << s;
 }
 
 /**
- * We also need to handle the apu-div falling edge case here
+ * Writes move the counter or what TIMA listens to, so TIMA is synced first and the overflow rescheduled after.
+ * Resetting DIV or changing TAC can make the timer input fall, which counts like any other edge.
+ * @returns apu_div_tick, a DIV reset with bit 4 set clocks the frame sequencer too
  */
 bool Timer::write_timer(uint16_t addr, uint8_t data) {
+    sync_tima();
+    bool apu_div_tick = false;
+    bool input_before = timer_input();
+
     if (addr == 0xFF04) {
-        bool apu_div_tick = DIV & 0b00010000;
-        DIV = 0x00;
-        div_remainder = 0x00;
-        if (apu_div_tick) return true;
+        apu_div_tick = counter & (1 << 10);
+        counter = 0;
+        tima_counter = 0;
+        if (input_before) increment_tima();
     } else if (addr == 0xFF05) {
+        // Writing during the reload cycle cancels it, interrupt included
+        reloading = false;
         TIMA = data;
-        tima_remainder = 0x00;
     } else if (addr == 0xFF06) {
         TMA = data;
     } else if (addr == 0xFF07) {
         TAC = data & 0x0F;
+        if (input_before && !timer_input()) increment_tima();
     }
-    return false;
+
+    schedule_overflow();
+    return apu_div_tick;
 }
 
 uint8_t Timer::read_timer(uint16_t addr) {
     if (addr == 0xFF04) {
-        return DIV;
+        return static_cast<uint8_t>(counter >> 6);
     } else if (addr == 0xFF05) {
+        sync_tima();
         return TIMA;
     } else if (addr == 0xFF06) {
         return TMA;
     } else if (addr == 0xFF07) {
         return TAC;
     }
-    std::runtime_error("Invalid timer read");
+    throw std::runtime_error("Invalid timer read");
 }
@@ -1,25 +1,57 @@
 #pragma once
 #include <cstdint>
+#include <limits>
+#include "state_io.hpp"
 
-// https://gbdev.io/pandocs/Timer_and_Divider_Registers.html#timer-and-divider-registers
+/**
+ * https://gbdev.io/pandocs/Timer_and_Divider_Registers.html#timer-and-divider-registers
+ * https://gbdev.io/pandocs/Timer_Obscure_Behaviour.html
+ *
+ * Everything hangs off the system counter, which counts M cycles since the last DIV write. DIV is bits 6 - 13 of
+ * it, and TIMA counts falling edges of the counter bit TAC selects. TIMA is only brought up to date when it's
+ * accessed: we keep the value it had at some counter value and add the edges since. The next overflow is worked out
+ * ahead of time, so between register accesses and overflows a tick is an add and two compares.
+ */
 class Timer {
     public:
-    bool write_timer(uint16_t addr, uint8_t data);
+        bool write_timer(uint16_t addr, uint8_t data);
         uint8_t read_timer(uint16_t addr);
 
-        bool tick(int clock_cycles);
+        void serialize(StateWriter& out) const;
+        void deserialize(StateReader& in);
+
+        // Returns true when DIV bit 4 fell (the APU frame sequencer's clock). Inline, it runs after every instruction.
+        bool tick(int clock_cycles) {
+            uint64_t before = counter;
+            counter += clock_cycles;
+            if (counter >= overflow_at || reloading) overflow();
+            // DIV bit 4 is counter bit 10, it falls every 2048 M cycles (512 Hz)
+            return (counter >> 11) != (before >> 11);
+        }
         //This will request and interrupt
         bool interrupt = false;
+
     private:
-        uint8_t DIV{0x18}; // 0xFF04
-        uint8_t TIMA{0}; // 0xFF05
+        static constexpr uint64_t NEVER = std::numeric_limits<uint64_t>::max();
+
+        uint64_t counter{0x18 << 6}; // DIV 0x18 after boot
+        uint8_t TIMA{0}; // 0xFF05, as of tima_counter
         uint8_t TMA{0}; // 0xFF06
         uint8_t TAC{0}; // 0xFF07
 
-        int tima_remainder{0};
-        int div_remainder{0};
-        int tima_overflow_pending = 0;
-        void tick_tima(int clock_cycles);
+        uint64_t tima_counter{0x18 << 6};
+        // Counter value at which TIMA wraps to 0. TMA is loaded (and the interrupt requested) one M cycle later.
+        uint64_t overflow_at{NEVER};
+        bool reloading{false}; // wrapped, TIMA reads 0 until the reload
+
+        // TIMA counts every 2^shift M cycles: 256, 4, 16, 64
+        int shift() const { return TIMA_SHIFTS[TAC & 0x03]; }
+        static constexpr int TIMA_SHIFTS[4] = {8, 2, 4, 6};
+        // What TIMA is clocked by: TAC enable AND the selected counter bit. TIMA counts on its falling edges.
+        bool timer_input() const { return (TAC & 0x04) && ((counter >> (shift() - 1)) & 1); }
 
-        bool tick_div(int clock_cycles);
-};
\ No newline at end of file
+        void sync_tima();
+        void increment_tima();
+        void schedule_overflow();
+        void overflow();
+};
@@ -0,0 +1,224 @@
+#include "frame_capture.hpp"
+#include "palette.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+namespace {
+
+// DMG frame rate is 4194304 Hz / 70224 dots per frame (~59.73 fps)
+constexpr const char* Y4M_HEADER = "YUV4MPEG2 W160 H144 F4194304:70224 Ip A1:1 C420jpeg\n";
+
+uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0) {
+    static const auto table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[n] = c;
+        }
+        return t;
+    }();
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+uint32_t adler32(const uint8_t* data, size_t size) {
+    uint32_t a = 1, b = 0;
+    for (size_t i = 0; i < size; i++) {
+        a = (a + data[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    return (b << 16) | a;
+}
+
+void put_be32(std::vector<uint8_t>& out, uint32_t v) {
+    out.push_back(v >> 24);
+    out.push_back(v >> 16);
+    out.push_back(v >> 8);
+    out.push_back(v);
+}
+
+void put_chunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data) {
+    put_be32(out, static_cast<uint32_t>(data.size()));
+    size_t type_start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    put_be32(out, crc32(out.data() + type_start, out.size() - type_start));
+}
+
+}
+
+FrameCapture::FrameCapture(const std::string& y4m_path, const std::string& png_dir, int queue_frames,
+                           CaptureDropPolicy policy)
+    : policy(policy), png_dir(png_dir), slots(std::max(1, queue_frames))
+{
+    if (!y4m_path.empty()) {
+        y4m.open(y4m_path, std::ios::binary);
+        if (!y4m) throw std::runtime_error("Couldn't open capture file " + y4m_path);
+        y4m << Y4M_HEADER;
+    }
+    if (!png_dir.empty()) {
+        std::filesystem::create_directories(png_dir);
+    }
+    for (Slot& slot : slots) free_slots.push_back(&slot);
+    encoder = std::thread([this] { encoder_loop(); });
+}
+
+FrameCapture::~FrameCapture() {
+    stop();
+}
+
+/**
+ * The lock is only held to move slot pointers around, the 23KB copy happens outside it.
+ * A slot taken from the free list belongs to this thread until it is queued.
+ */
+void FrameCapture::submit_frame(const uint8_t* frame) {
+    uint64_t frame_number = next_frame_number++;
+    Slot* slot = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!free_slots.empty()) {
+            slot = free_slots.back();
+            free_slots.pop_back();
+        } else if (policy == CaptureDropPolicy::DROP_OLDEST && !queued.empty()) {
+            // Recycle the oldest waiting frame, the encoder has every other slot
+            slot = queued.front();
+            queued.pop_front();
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    if (slot == nullptr) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    std::memcpy(slot->pixels.data(), frame, slot->pixels.size());
+    slot->frame_number = frame_number;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queued.push_back(slot);
+    }
+    queued_cv.notify_one();
+}
+
+void FrameCapture::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) return;
+        stopping = true;
+    }
+    queued_cv.notify_one();
+    encoder.join();
+    if (y4m.is_open()) y4m.close();
+}
+
+bool FrameCapture::parse_drop_policy(const std::string& name, CaptureDropPolicy& policy) {
+    if (name == "newest") policy = CaptureDropPolicy::DROP_NEWEST;
+    else if (name == "oldest") policy = CaptureDropPolicy::DROP_OLDEST;
+    else return false;
+    return true;
+}
+
+void FrameCapture::encoder_loop() {
+    while (true) {
+        Slot* slot;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            queued_cv.wait(lock, [this] { return stopping || !queued.empty(); });
+            if (queued.empty()) return; // stopping and drained
+            slot = queued.front();
+            queued.pop_front();
+        }
+
+        if (y4m.is_open()) write_y4m(*slot);
+        if (!png_dir.empty()) write_png(*slot);
+        written.fetch_add(1, std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        free_slots.push_back(slot);
+    }
+}
+
+// Frames that were dropped are filled with the last one written, so playback keeps emulated time
+void FrameCapture::write_y4m(const Slot& slot) {
+    while (next_y4m_frame < slot.frame_number) {
+        write_y4m_frame(last_frame);
+        next_y4m_frame++;
+    }
+    write_y4m_frame(slot.pixels);
+    last_frame = slot.pixels;
+    next_y4m_frame = slot.frame_number + 1;
+}
+
+/**
+ * Gray only: studio range luma from the palette, chroma planes (4:2:0, 80x72 each) at the neutral 128.
+ */
+void FrameCapture::write_y4m_frame(const Frame& pixels) {
+    static const auto luma = [] {
+        std::array<uint8_t, 4> l{};
+        for (int i = 0; i < 4; i++) l[i] = static_cast<uint8_t>(16 + DMG_PALETTE[i][0] * 219 / 255);
+        return l;
+    }();
+    static const std::vector<uint8_t> chroma(2 * (WIDTH / 2) * (HEIGHT / 2), 128);
+
+    Frame y_plane;
+    for (size_t i = 0; i < pixels.size(); i++) y_plane[i] = luma[pixels[i] & 3];
+
+    y4m << "FRAME\n";
+    y4m.write(reinterpret_cast<const char*>(y_plane.data()), y_plane.size());
+    y4m.write(reinterpret_cast<const char*>(chroma.data()), chroma.size());
+}
+
+/**
+ * 2 bit palette PNG. The image data goes in as uncompressed (stored) deflate blocks: a frame is about 6KB packed,
+ * so real compression isn't worth a dependency or the encoder time.
+ */
+void FrameCapture::write_png(const Slot& slot) const {
+    constexpr int ROW_BYTES = 1 + WIDTH / 4; // filter byte + 4 pixels per byte
+    std::vector<uint8_t> raw(ROW_BYTES * HEIGHT);
+    for (int y = 0; y < HEIGHT; y++) {
+        uint8_t* row = raw.data() + y * ROW_BYTES;
+        row[0] = 0; // filter: none
+        for (int x = 0; x < WIDTH; x++) {
+            row[1 + x / 4] |= (slot.pixels[y * WIDTH + x] & 3) << (6 - 2 * (x % 4));
+        }
+    }
+
+    std::vector<uint8_t> zlib{0x78, 0x01};
+    constexpr size_t MAX_STORED = 65535;
+    for (size_t pos = 0; pos < raw.size(); pos += MAX_STORED) {
+        size_t len = std::min(MAX_STORED, raw.size() - pos);
+        zlib.push_back(pos + len == raw.size() ? 1 : 0); // BFINAL, BTYPE = stored
+        zlib.push_back(len & 0xFF);
+        zlib.push_back(len >> 8);
+        zlib.push_back(~len & 0xFF);
+        zlib.push_back((~len >> 8) & 0xFF);
+        zlib.insert(zlib.end(), raw.begin() + pos, raw.begin() + pos + len);
+    }
+    put_be32(zlib, adler32(raw.data(), raw.size()));
+
+    std::vector<uint8_t> ihdr;
+    put_be32(ihdr, WIDTH);
+    put_be32(ihdr, HEIGHT);
+    ihdr.insert(ihdr.end(), {2, 3, 0, 0, 0}); // bit depth 2, indexed color, deflate, no filter, no interlace
+
+    std::vector<uint8_t> plte;
+    for (const auto& color : DMG_PALETTE) plte.insert(plte.end(), color, color + 3);
+
+    static constexpr uint8_t SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    std::vector<uint8_t> png(SIGNATURE, SIGNATURE + 8);
+    put_chunk(png, "IHDR", ihdr);
+    put_chunk(png, "PLTE", plte);
+    put_chunk(png, "IDAT", zlib);
+    put_chunk(png, "IEND", {});
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "frame_%06llu.png", static_cast<unsigned long long>(slot.frame_number));
+    std::ofstream file(std::filesystem::path(png_dir) / name, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(png.data()), png.size());
+}
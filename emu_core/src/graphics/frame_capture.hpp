@@ -0,0 +1,79 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// What to do when the encoder falls behind and every queue slot is taken
+enum class CaptureDropPolicy {
+    DROP_NEWEST, // skip the incoming frame
+    DROP_OLDEST  // overwrite the oldest frame still waiting
+};
+
+/**
+ * Records finished PPU frames without slowing emulation down.
+ * submit_frame copies the frame into one of a fixed number of preallocated slots and returns, a background thread
+ * writes them out as a Y4M stream and/or a PNG sequence. Queue memory is bounded by the slot count; when it runs out
+ * frames are dropped according to the policy, and the Y4M repeats the previous frame so the timeline stays intact.
+ */
+class FrameCapture {
+    public:
+        static constexpr int WIDTH = 160;
+        static constexpr int HEIGHT = 144;
+
+        FrameCapture(const std::string& y4m_path, const std::string& png_dir, int queue_frames,
+                     CaptureDropPolicy policy);
+        ~FrameCapture();
+        FrameCapture(const FrameCapture&) = delete;
+        FrameCapture& operator=(const FrameCapture&) = delete;
+
+        // Emulation thread. frame is WIDTH * HEIGHT shade indices.
+        void submit_frame(const uint8_t* frame);
+
+        // Writes out everything still queued and stops the encoder thread
+        void stop();
+
+        uint64_t frames_written() const { return written.load(std::memory_order_relaxed); }
+        uint64_t frames_dropped() const { return dropped.load(std::memory_order_relaxed); }
+
+        // "newest" or "oldest"
+        static bool parse_drop_policy(const std::string& name, CaptureDropPolicy& policy);
+
+    private:
+        using Frame = std::array<uint8_t, WIDTH * HEIGHT>;
+        struct Slot {
+            Frame pixels;
+            uint64_t frame_number;
+        };
+
+        CaptureDropPolicy policy;
+        std::ofstream y4m;
+        std::string png_dir;
+
+        std::vector<Slot> slots;
+        std::vector<Slot*> free_slots;
+        std::deque<Slot*> queued;
+        std::mutex mutex;
+        std::condition_variable queued_cv;
+        bool stopping{false};
+        std::thread encoder;
+
+        uint64_t next_frame_number{0};
+        std::atomic<uint64_t> written{0};
+        std::atomic<uint64_t> dropped{0};
+
+        // Encoder thread only
+        Frame last_frame{};
+        uint64_t next_y4m_frame{0};
+
+        void encoder_loop();
+        void write_y4m(const Slot& slot);
+        void write_y4m_frame(const Frame& pixels);
+        void write_png(const Slot& slot) const;
+};
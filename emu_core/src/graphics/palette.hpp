@@ -0,0 +1,5 @@
+#pragma once
+#include <cstdint>
+
+// RGB for the four DMG shades (0 = lightest), shared by the screen shader and frame capture
+static constexpr uint8_t DMG_PALETTE[4][3] = {{255, 255, 255}, {211, 211, 211}, {169, 169, 169}, {0, 0, 0}};
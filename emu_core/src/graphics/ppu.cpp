@@ -2,8 +2,6 @@
 
 using namespace std;
 
-PPU::PPU(Screen& screen) : screen(screen) {}
-
 // one frame 70224 dots
 void PPU::tick(int cycles) {
     for (int i = 0; i < cycles * 4; i++) {
@@ -11,6 +9,33 @@ void PPU::tick(int cycles) {
     }
 }
 
+void PPU::serialize(StateWriter& out) const {
+    out.begin_section("PPU ");
+    out.fields(OAM, VRAM, LCDC, LY, LYC, STAT, SCY, SCX, WY, WX, BGP, DMA, OBP0, OBP1);
+    out.fields(mode, dots, window_internal_line_counter, oam_scanned, scanline_drawn, hblank_happened);
+    out.fields(vblank_interrupt, lcd_stat_interrupt, prev_lcd_stat_interrupt, frame_ready);
+    out.fields(pixels_pushed, window_pixels_pushed, wy_cond);
+    out.fields(static_cast<uint8_t>(sprite_buffer.size()));
+    for (const Sprite& sprite : sprite_buffer) out.fields(sprite);
+    out.fields(frame_buffer);
+    out.end_section();
+}
+
+void PPU::deserialize(StateReader& in) {
+    in.begin_section("PPU ");
+    in.fields(OAM, VRAM, LCDC, LY, LYC, STAT, SCY, SCX, WY, WX, BGP, DMA, OBP0, OBP1);
+    in.fields(mode, dots, window_internal_line_counter, oam_scanned, scanline_drawn, hblank_happened);
+    in.fields(vblank_interrupt, lcd_stat_interrupt, prev_lcd_stat_interrupt, frame_ready);
+    in.fields(pixels_pushed, window_pixels_pushed, wy_cond);
+    uint8_t sprites;
+    in.fields(sprites);
+    if (sprites > 10) throw std::runtime_error("Save state has more than 10 sprites on a line");
+    sprite_buffer.resize(sprites);
+    for (Sprite& sprite : sprite_buffer) in.fields(sprite);
+    in.fields(frame_buffer);
+    in.end_section();
+}
+
 void PPU::tick_dot() {
     dots++;
     // Vblank
@@ -22,7 +47,7 @@ void PPU::tick_dot() {
         }
         if (LY == 153 && dots == 4) {
             LY = 0;
-            screen.render(frame_buffer, FRAME_BUFFER_SIZE);
+            frame_ready = true;
             lyc_ly_coincidence_check();
         }
 
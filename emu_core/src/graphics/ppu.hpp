@@ -1,8 +1,9 @@
 #pragma once
 #include <cstdint>
 #include <algorithm>
+#include <stdexcept>
 #include <vector>
-#include "screen.hpp"
+#include "../core/state_io.hpp"
 
 //https://gbdev.io/pandocs/Rendering.html#rendering-overview
 enum Mode {
@@ -14,7 +15,7 @@ enum Mode {
 
 class PPU {
     public:
-        PPU(Screen& screen);
+        PPU() = default;
         void tick(int clock_cycles);
         void tick_dot();
 
@@ -28,11 +29,20 @@ class PPU {
 
         void ppu_io_registers_write(uint16_t addr, uint8_t data);
         uint8_t ppu_io_read(uint16_t addr);
+
+        // Everything, the half drawn frame in the frame buffer included
+        void serialize(StateWriter& out) const;
+        void deserialize(StateReader& in);
         bool lcd_stat_interrupt{false};
         bool prev_lcd_stat_interrupt{false};
         static constexpr int FRAME_BUFFER_SIZE{160*144};
+
+        // Set once a full frame is in the frame buffer, the emulator hands it out (screen, capture...) and clears it
+        bool frame_ready{false};
+        const uint8_t* get_frame_buffer() const { return frame_buffer; }
+        const uint8_t* get_oam() const { return OAM; }
+        static constexpr size_t OAM_SIZE = 0xA0;
     private:
-        Screen& screen;
         struct Sprite {
             uint8_t tile_id;
             uint8_t x;
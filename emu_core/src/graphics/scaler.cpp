@@ -0,0 +1,128 @@
+#include "scaler.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+ScalerKernels kernels_for(ScalerIsa isa) {
+    switch (isa) {
+#ifdef SCALER_X86
+        case ScalerIsa::AVX2: return scaler_kernels_avx2();
+        case ScalerIsa::SSE2: return scaler_kernels_sse2();
+#endif
+        default: return scaler_kernels_scalar();
+    }
+}
+
+}
+
+Scaler::Scaler(ScaleFilter filter, int factor, int width, int height, int threads, ScalerIsa isa)
+    : filter(filter), factor(factor), width(width), height(height), kernels(kernels_for(isa)), pool(threads)
+{
+    if (factor < min_factor(filter) || factor > SCALER_MAX_FACTOR) {
+        throw std::runtime_error(std::string("Unsupported scale factor for ") + filter_name(filter));
+    }
+    // Kernels step 32 pixels at a time at most (AVX2), and Scale4x runs a second pass at twice the width
+    if (width % 32 != 0) throw std::runtime_error("Scaler width must be a multiple of 32");
+    if (filter == ScaleFilter::SCALEX && factor == 4) {
+        intermediate.resize(width * 2 * height * 2);
+    }
+}
+
+void Scaler::scale(const uint8_t* frame, uint8_t* out) {
+    switch (filter) {
+        case ScaleFilter::NEAREST:
+            pad(frame, width, height);
+            run_pass(kernels.nearest, width, height, factor, out);
+            break;
+        case ScaleFilter::XBR:
+            pad(frame, width, height);
+            run_pass(kernels.xbr, width, height, factor, out);
+            break;
+        case ScaleFilter::SCALEX:
+            pad(frame, width, height);
+            if (factor == 3) {
+                run_pass(kernels.scale3x, width, height, 3, out);
+            } else if (factor == 2) {
+                run_pass(kernels.scale2x, width, height, 2, out);
+            } else {
+                run_pass(kernels.scale2x, width, height, 2, intermediate.data());
+                pad(intermediate.data(), width * 2, height * 2);
+                run_pass(kernels.scale2x, width * 2, height * 2, 2, out);
+            }
+            break;
+    }
+}
+
+// Copies the image into `padded` with SCALER_PAD clamped pixels around it
+void Scaler::pad(const uint8_t* src, int w, int h) {
+    int stride = w + 2 * SCALER_PAD;
+    padded.resize(stride * (h + 2 * SCALER_PAD));
+    for (int y = -SCALER_PAD; y < h + SCALER_PAD; y++) {
+        const uint8_t* row = src + std::clamp(y, 0, h - 1) * w;
+        uint8_t* dst = padded.data() + (y + SCALER_PAD) * stride;
+        std::memset(dst, row[0], SCALER_PAD);
+        std::memcpy(dst + SCALER_PAD, row, w);
+        std::memset(dst + SCALER_PAD + w, row[w - 1], SCALER_PAD);
+    }
+}
+
+void Scaler::run_pass(ScaleRowsFn fn, int w, int h, int pass_factor, uint8_t* dst) {
+    int stride = w + 2 * SCALER_PAD;
+    ScalePass pass{
+        padded.data() + SCALER_PAD * stride + SCALER_PAD,
+        stride,
+        w,
+        h,
+        pass_factor,
+        dst,
+        w * pass_factor
+    };
+    pool.parallel_for(h, [&](int y_begin, int y_end) { fn(pass, y_begin, y_end); });
+}
+
+ScalerIsa Scaler::best_isa() {
+#ifdef SCALER_X86
+    if (__builtin_cpu_supports("avx2")) return ScalerIsa::AVX2;
+    return ScalerIsa::SSE2;
+#else
+    return ScalerIsa::SCALAR;
+#endif
+}
+
+std::vector<ScalerIsa> Scaler::supported_isas() {
+    std::vector<ScalerIsa> isas{ScalerIsa::SCALAR};
+#ifdef SCALER_X86
+    isas.push_back(ScalerIsa::SSE2);
+    if (__builtin_cpu_supports("avx2")) isas.push_back(ScalerIsa::AVX2);
+#endif
+    return isas;
+}
+
+bool Scaler::parse_filter(const std::string& name, ScaleFilter& filter) {
+    if (name == "nearest") filter = ScaleFilter::NEAREST;
+    else if (name == "scalex") filter = ScaleFilter::SCALEX;
+    else if (name == "xbr") filter = ScaleFilter::XBR;
+    else return false;
+    return true;
+}
+
+const char* Scaler::filter_name(ScaleFilter filter) {
+    switch (filter) {
+        case ScaleFilter::NEAREST: return "nearest";
+        case ScaleFilter::SCALEX: return "scalex";
+        case ScaleFilter::XBR: return "xbr";
+    }
+    return "unknown";
+}
+
+const char* Scaler::isa_name(ScalerIsa isa) {
+    switch (isa) {
+        case ScalerIsa::SCALAR: return "scalar";
+        case ScalerIsa::SSE2: return "sse2";
+        case ScalerIsa::AVX2: return "avx2";
+    }
+    return "unknown";
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../core/thread_pool.hpp"
+
+/**
+ * CPU side upscaling between the PPU frame and presentation, for when there is no GPU to do it well.
+ * Filters work on shade indices (0-3) rather than RGB, so the output still goes through the palette shader and
+ * nothing gets blended: xBR is the "no-blend" flavor that only moves edges.
+ *
+ *  NEAREST: integer pixel replication, 1x - 4x
+ *  SCALEX:  AdvMAME Scale2x / Scale3x, 4x is Scale2x applied twice
+ *  XBR:     xBR level 1 edge detection (21 pixel neighborhood), 2x - 4x
+ */
+enum class ScaleFilter {
+    NEAREST,
+    SCALEX,
+    XBR
+};
+
+enum class ScalerIsa {
+    SCALAR,
+    SSE2,
+    AVX2
+};
+
+// Source images are padded by this many clamped pixels on every side so kernels can read neighbors without checks
+static constexpr int SCALER_PAD = 2;
+static constexpr int SCALER_MAX_FACTOR = 4;
+
+struct ScalePass {
+    const uint8_t* src; // first unpadded pixel of the padded source
+    int src_stride;
+    int width;          // unpadded source size, width must be a multiple of 32
+    int height;
+    int factor;
+    uint8_t* dst;
+    int dst_stride;
+};
+
+using ScaleRowsFn = void (*)(const ScalePass& pass, int y_begin, int y_end);
+
+// One set per instruction set, see scaler_kernels.hpp
+struct ScalerKernels {
+    ScaleRowsFn nearest;
+    ScaleRowsFn scale2x;
+    ScaleRowsFn scale3x;
+    ScaleRowsFn xbr;
+};
+
+ScalerKernels scaler_kernels_scalar();
+#ifdef SCALER_X86
+ScalerKernels scaler_kernels_sse2();
+ScalerKernels scaler_kernels_avx2();
+#endif
+
+class Scaler {
+    public:
+        Scaler(ScaleFilter filter, int factor, int width, int height, int threads, ScalerIsa isa = best_isa());
+
+        // frame is width * height shade indices, out must hold out_width() * out_height()
+        void scale(const uint8_t* frame, uint8_t* out);
+
+        int out_width() const { return width * factor; }
+        int out_height() const { return height * factor; }
+
+        static ScalerIsa best_isa();
+        static std::vector<ScalerIsa> supported_isas();
+        static bool parse_filter(const std::string& name, ScaleFilter& filter);
+        // Smallest factor the filter does, all of them go up to SCALER_MAX_FACTOR
+        static int min_factor(ScaleFilter filter) { return filter == ScaleFilter::NEAREST ? 1 : 2; }
+        static const char* filter_name(ScaleFilter filter);
+        static const char* isa_name(ScalerIsa isa);
+
+    private:
+        ScaleFilter filter;
+        int factor;
+        int width;
+        int height;
+        ScalerKernels kernels;
+        ThreadPool pool;
+
+        std::vector<uint8_t> padded;
+        std::vector<uint8_t> intermediate; // Scale4x runs Scale2x twice
+
+        void pad(const uint8_t* src, int w, int h);
+        void run_pass(ScaleRowsFn fn, int w, int h, int pass_factor, uint8_t* dst);
+};
@@ -0,0 +1,35 @@
+// Built with -mavx2, only called after a runtime CPU check (see Scaler::best_isa)
+#include <immintrin.h>
+#include "scaler_kernels.hpp"
+
+namespace {
+
+struct Avx2Vec {
+    using reg = __m256i;
+    static constexpr int width = 32;
+
+    static reg load(const uint8_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static void store(uint8_t* p, reg v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    static reg set1(uint8_t v) { return _mm256_set1_epi8(static_cast<char>(v)); }
+    static reg eq(reg a, reg b) { return _mm256_cmpeq_epi8(a, b); }
+    static reg and_(reg a, reg b) { return _mm256_and_si256(a, b); }
+    static reg or_(reg a, reg b) { return _mm256_or_si256(a, b); }
+    static reg andnot(reg a, reg b) { return _mm256_andnot_si256(a, b); }
+    static reg select(reg mask, reg a, reg b) { return _mm256_blendv_epi8(b, a, mask); }
+    static reg absdiff(reg a, reg b) { return _mm256_or_si256(_mm256_subs_epu8(a, b), _mm256_subs_epu8(b, a)); }
+    static reg adds(reg a, reg b) { return _mm256_adds_epu8(a, b); }
+    static reg lt(reg a, reg b) { return _mm256_cmpgt_epi8(b, a); }
+    // unpack works per 128 bit lane, so stitch the lanes back into order
+    static void zip2(reg a, reg b, uint8_t* out) {
+        reg lo = _mm256_unpacklo_epi8(a, b);
+        reg hi = _mm256_unpackhi_epi8(a, b);
+        store(out, _mm256_permute2x128_si256(lo, hi, 0x20));
+        store(out + 32, _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+};
+
+}
+
+ScalerKernels scaler_kernels_avx2() {
+    return make_kernels<Avx2Vec>();
+}
@@ -0,0 +1,220 @@
+#pragma once
+#include <cstring>
+#include "scaler.hpp"
+
+/**
+ * Filter kernels, written once against a small vector interface V and compiled once per instruction set
+ * (scaler_scalar.cpp, scaler_sse2.cpp, scaler_avx2.cpp). V provides:
+ *
+ *   reg, width, load, store, set1, eq, and_, or_, andnot (~a & b), select (mask ? a : b),
+ *   absdiff, adds (saturating), lt (values stay below 128), zip2 (interleave two regs into 2 * width bytes)
+ *
+ * Everything lives in an anonymous namespace: each translation unit is built with different -m flags, and a shared
+ * inline symbol could let the linker hand AVX2 code to the scalar path.
+ */
+namespace {
+
+template <typename V>
+inline void interleave(const typename V::reg* parts, int n, uint8_t* out) {
+    constexpr int W = V::width;
+    if (n == 1) {
+        V::store(out, parts[0]);
+    } else if (n == 2) {
+        V::zip2(parts[0], parts[1], out);
+    } else if (n == 4) {
+        alignas(64) uint8_t even[2 * W];
+        alignas(64) uint8_t odd[2 * W];
+        V::zip2(parts[0], parts[2], even);
+        V::zip2(parts[1], parts[3], odd);
+        V::zip2(V::load(even), V::load(odd), out);
+        V::zip2(V::load(even + W), V::load(odd + W), out + 2 * W);
+    } else {
+        // No byte shuffle before SSSE3, so three way interleaving goes through memory
+        alignas(64) uint8_t lanes[3][W];
+        for (int i = 0; i < 3; i++) V::store(lanes[i], parts[i]);
+        for (int x = 0; x < W; x++) {
+            out[x * 3] = lanes[0][x];
+            out[x * 3 + 1] = lanes[1][x];
+            out[x * 3 + 2] = lanes[2][x];
+        }
+    }
+}
+
+template <typename V>
+void nearest_rows(const ScalePass& p, int y_begin, int y_end) {
+    typename V::reg parts[SCALER_MAX_FACTOR];
+    for (int y = y_begin; y < y_end; y++) {
+        const uint8_t* row = p.src + y * p.src_stride;
+        uint8_t* out = p.dst + (y * p.factor) * p.dst_stride;
+        for (int x = 0; x < p.width; x += V::width) {
+            typename V::reg e = V::load(row + x);
+            for (int i = 0; i < p.factor; i++) parts[i] = e;
+            interleave<V>(parts, p.factor, out + x * p.factor);
+        }
+        for (int j = 1; j < p.factor; j++) {
+            std::memcpy(out + j * p.dst_stride, out, p.width * p.factor);
+        }
+    }
+}
+
+/**
+ *  A B C
+ *  D E F   E expands to 2x2, a corner takes a neighbor's color when two sides of it agree
+ *  G H I   and the opposite sides don't (so lines and solid areas stay untouched)
+ */
+template <typename V>
+void scale2x_rows(const ScalePass& p, int y_begin, int y_end) {
+    using R = typename V::reg;
+    const R ones = V::set1(0xFF);
+    for (int y = y_begin; y < y_end; y++) {
+        const uint8_t* row = p.src + y * p.src_stride;
+        uint8_t* out0 = p.dst + (y * 2) * p.dst_stride;
+        uint8_t* out1 = out0 + p.dst_stride;
+        for (int x = 0; x < p.width; x += V::width) {
+            R B = V::load(row - p.src_stride + x);
+            R H = V::load(row + p.src_stride + x);
+            R D = V::load(row + x - 1);
+            R E = V::load(row + x);
+            R F = V::load(row + x + 1);
+
+            R active = V::andnot(V::or_(V::eq(B, H), V::eq(D, F)), ones);
+            R top[2] = {
+                V::select(V::and_(active, V::eq(D, B)), D, E),
+                V::select(V::and_(active, V::eq(B, F)), F, E)
+            };
+            R bottom[2] = {
+                V::select(V::and_(active, V::eq(D, H)), D, E),
+                V::select(V::and_(active, V::eq(H, F)), F, E)
+            };
+            interleave<V>(top, 2, out0 + x * 2);
+            interleave<V>(bottom, 2, out1 + x * 2);
+        }
+    }
+}
+
+template <typename V>
+void scale3x_rows(const ScalePass& p, int y_begin, int y_end) {
+    using R = typename V::reg;
+    const R ones = V::set1(0xFF);
+    for (int y = y_begin; y < y_end; y++) {
+        const uint8_t* above = p.src + (y - 1) * p.src_stride;
+        const uint8_t* row = above + p.src_stride;
+        const uint8_t* below = row + p.src_stride;
+        uint8_t* out = p.dst + (y * 3) * p.dst_stride;
+        for (int x = 0; x < p.width; x += V::width) {
+            R A = V::load(above + x - 1), B = V::load(above + x), C = V::load(above + x + 1);
+            R D = V::load(row + x - 1),   E = V::load(row + x),   F = V::load(row + x + 1);
+            R G = V::load(below + x - 1), H = V::load(below + x), I = V::load(below + x + 1);
+
+            R active = V::andnot(V::or_(V::eq(B, H), V::eq(D, F)), ones);
+            R db = V::and_(active, V::eq(D, B));
+            R bf = V::and_(active, V::eq(B, F));
+            R dh = V::and_(active, V::eq(D, H));
+            R hf = V::and_(active, V::eq(H, F));
+            auto differs = [&](R a) { return V::andnot(V::eq(E, a), ones); };
+
+            R r0[3] = {
+                V::select(db, D, E),
+                V::select(V::or_(V::and_(db, differs(C)), V::and_(bf, differs(A))), B, E),
+                V::select(bf, F, E)
+            };
+            R r1[3] = {
+                V::select(V::or_(V::and_(db, differs(G)), V::and_(dh, differs(A))), D, E),
+                E,
+                V::select(V::or_(V::and_(bf, differs(I)), V::and_(hf, differs(C))), F, E)
+            };
+            R r2[3] = {
+                V::select(dh, D, E),
+                V::select(V::or_(V::and_(dh, differs(I)), V::and_(hf, differs(G))), H, E),
+                V::select(hf, F, E)
+            };
+            interleave<V>(r0, 3, out + x * 3);
+            interleave<V>(r1, 3, out + p.dst_stride + x * 3);
+            interleave<V>(r2, 3, out + 2 * p.dst_stride + x * 3);
+        }
+    }
+}
+
+/**
+ * xBR level 1. For each corner of E we weigh the color differences along the two possible edge directions
+ * over the 21 pixel neighborhood (shown for the bottom right corner):
+ *
+ *        A1 B1 C1
+ *     A0 A  B  C  C4
+ *     D0 D  E  F  F4      e = d(E,C) + d(E,G) + d(I,F4) + d(I,H5) + 4 d(H,F)
+ *     G0 G  H  I  I4      i = d(H,D) + d(H,I5) + d(F,I4) + d(F,B) + 4 d(E,I)
+ *        G5 H5 I5
+ *
+ * e < i means an edge runs along H-F, so the corner sub-pixels beyond that line take the closer of F and H.
+ * Shade indices are ordered by brightness, so |a - b| works as the color distance.
+ * The other corners are the same rule mirrored, the rule is symmetric so mirroring covers every rotation.
+ */
+template <typename V>
+void xbr_rows(const ScalePass& p, int y_begin, int y_end) {
+    using R = typename V::reg;
+    const int n = p.factor;
+
+    // Which corner (0 BR, 1 BL, 2 TR, 3 TL) each sub-pixel belongs to, -1 keeps E. A sub-pixel is past the edge
+    // when its center sits at least 1.5 pixels (in the corner's direction) from the opposite corner.
+    int corner_of[SCALER_MAX_FACTOR][SCALER_MAX_FACTOR];
+    for (int j = 0; j < n; j++) {
+        for (int i = 0; i < n; i++) {
+            float fx = (i + 0.5f) / n;
+            float fy = (j + 0.5f) / n;
+            corner_of[j][i] = -1;
+            if (fx + fy >= 1.5f) corner_of[j][i] = 0;
+            else if ((1.0f - fx) + fy >= 1.5f) corner_of[j][i] = 1;
+            else if (fx + (1.0f - fy) >= 1.5f) corner_of[j][i] = 2;
+            else if ((1.0f - fx) + (1.0f - fy) >= 1.5f) corner_of[j][i] = 3;
+        }
+    }
+
+    auto dist = [](R a, R b) { return V::absdiff(a, b); };
+    auto times4 = [](R a) { R twice = V::adds(a, a); return V::adds(twice, twice); };
+
+    R P[5][5];
+    R corner_mask[4];
+    R corner_color[4];
+    R parts[SCALER_MAX_FACTOR];
+
+    for (int y = y_begin; y < y_end; y++) {
+        for (int x = 0; x < p.width; x += V::width) {
+            for (int dy = -2; dy <= 2; dy++) {
+                const uint8_t* row = p.src + (y + dy) * p.src_stride + x;
+                for (int dx = -2; dx <= 2; dx++) P[dy + 2][dx + 2] = V::load(row + dx);
+            }
+
+            for (int c = 0; c < 4; c++) {
+                int sx = (c & 1) ? -1 : 1;
+                int sy = (c & 2) ? -1 : 1;
+                auto at = [&](int dx, int dy) { return P[sy * dy + 2][sx * dx + 2]; };
+
+                R E = at(0, 0), I = at(1, 1), H = at(0, 1), F = at(1, 0);
+                R e = V::adds(V::adds(dist(E, at(1, -1)), dist(E, at(-1, 1))),
+                              V::adds(V::adds(dist(I, at(2, 0)), dist(I, at(0, 2))), times4(dist(H, F))));
+                R i = V::adds(V::adds(dist(H, at(-1, 0)), dist(H, at(1, 2))),
+                              V::adds(V::adds(dist(F, at(2, 1)), dist(F, at(0, -1))), times4(dist(E, I))));
+
+                corner_mask[c] = V::lt(e, i);
+                R f_closer = V::andnot(V::lt(dist(E, H), dist(E, F)), V::set1(0xFF));
+                corner_color[c] = V::select(f_closer, F, H);
+            }
+
+            R E = P[2][2];
+            for (int j = 0; j < n; j++) {
+                for (int i = 0; i < n; i++) {
+                    int c = corner_of[j][i];
+                    parts[i] = c < 0 ? E : V::select(corner_mask[c], corner_color[c], E);
+                }
+                interleave<V>(parts, n, p.dst + (y * n + j) * p.dst_stride + x * n);
+            }
+        }
+    }
+}
+
+template <typename V>
+ScalerKernels make_kernels() {
+    return ScalerKernels{nearest_rows<V>, scale2x_rows<V>, scale3x_rows<V>, xbr_rows<V>};
+}
+
+}
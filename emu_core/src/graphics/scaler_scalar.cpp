@@ -0,0 +1,29 @@
+#include <algorithm>
+#include "scaler_kernels.hpp"
+
+namespace {
+
+// One pixel per "register", used on non x86 targets and as the reference for the SIMD versions
+struct ScalarVec {
+    using reg = uint8_t;
+    static constexpr int width = 1;
+
+    static reg load(const uint8_t* p) { return *p; }
+    static void store(uint8_t* p, reg v) { *p = v; }
+    static reg set1(uint8_t v) { return v; }
+    static reg eq(reg a, reg b) { return a == b ? 0xFF : 0x00; }
+    static reg and_(reg a, reg b) { return a & b; }
+    static reg or_(reg a, reg b) { return a | b; }
+    static reg andnot(reg a, reg b) { return static_cast<reg>(~a & b); }
+    static reg select(reg mask, reg a, reg b) { return mask ? a : b; }
+    static reg absdiff(reg a, reg b) { return a > b ? a - b : b - a; }
+    static reg adds(reg a, reg b) { return static_cast<reg>(std::min(a + b, 0xFF)); }
+    static reg lt(reg a, reg b) { return a < b ? 0xFF : 0x00; }
+    static void zip2(reg a, reg b, uint8_t* out) { out[0] = a; out[1] = b; }
+};
+
+}
+
+ScalerKernels scaler_kernels_scalar() {
+    return make_kernels<ScalarVec>();
+}
@@ -0,0 +1,31 @@
+#include <emmintrin.h>
+#include "scaler_kernels.hpp"
+
+namespace {
+
+struct Sse2Vec {
+    using reg = __m128i;
+    static constexpr int width = 16;
+
+    static reg load(const uint8_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static void store(uint8_t* p, reg v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+    static reg set1(uint8_t v) { return _mm_set1_epi8(static_cast<char>(v)); }
+    static reg eq(reg a, reg b) { return _mm_cmpeq_epi8(a, b); }
+    static reg and_(reg a, reg b) { return _mm_and_si128(a, b); }
+    static reg or_(reg a, reg b) { return _mm_or_si128(a, b); }
+    static reg andnot(reg a, reg b) { return _mm_andnot_si128(a, b); }
+    static reg select(reg mask, reg a, reg b) { return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b)); }
+    static reg absdiff(reg a, reg b) { return _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a)); }
+    static reg adds(reg a, reg b) { return _mm_adds_epu8(a, b); }
+    static reg lt(reg a, reg b) { return _mm_cmplt_epi8(a, b); }
+    static void zip2(reg a, reg b, uint8_t* out) {
+        store(out, _mm_unpacklo_epi8(a, b));
+        store(out + 16, _mm_unpackhi_epi8(a, b));
+    }
+};
+
+}
+
+ScalerKernels scaler_kernels_sse2() {
+    return make_kernels<Sse2Vec>();
+}
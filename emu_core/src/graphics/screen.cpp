@@ -1,46 +1,162 @@
 #include "screen.hpp"
 #include "joypad/joypad.hpp"
+#include <algorithm>
+
+// glad was generated for plain 3.3 core, so ARB_buffer_storage is loaded by hand when the driver offers it
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+using BufferStorageProc = void (APIENTRY *)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
 
 /**
- *  left -> right in an uint16_t. this draws 8 pixels to screen, each 2 bit value being a color
- * 0b 11 10 01 01 11 10 01 10
- *
+ * The frame buffer holds one shade index (0-3) per byte. We upload those bytes as they are into a GL_R8 texture and
+ * the fragment shader looks the color up in the palette, instead of expanding to RGB on the CPU every frame.
+ * With a CPU scaler the upload is the scaled index image, otherwise the plain 23 KB frame.
  */
-void Screen::render(const uint8_t* frame_buffer, const int size) {
-    glfwMakeContextCurrent(window);
-    // "summon" the PBO and it's stored pixels
-    if (pbo_id == 0) {
+void Screen::upload(const uint8_t* pixels) {
+    if (pbo_ids[0] == 0) {
         std::cerr << "Error: PBO ID is 0. Did init() run?" << std::endl;
         return;
     }
 
-    uint8_t pixels[160 * 144 * 3];
-    for (int i = 0; i < size; i++) {
-        int idx = i * 3;
-        uint8_t color = frame_buffer[i];
-        pixels[idx + 0] = rgb_palette[color][0];
-        pixels[idx + 1] = rgb_palette[color][1];
-        pixels[idx + 2] = rgb_palette[color][2];
+    int slot = pbo_index;
+    pbo_index = (pbo_index + 1) % PBO_COUNT;
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo_ids[slot]);
+    uint8_t* dst = begin_upload(slot);
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+    if (!dst) {
+        // The driver couldn't map the PBO (out of memory, lost context...), this frame goes up straight from pixels
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, texture_width, texture_height, GL_RED, GL_UNSIGNED_BYTE, pixels);
+        return;
     }
+    std::copy(pixels, pixels + texture_width * texture_height, dst);
+    if (!persistent_pbo) glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
 
-    // ===== FAST UPLOAD (NO MAPPING) =====
-    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo_id);
-    glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, 160 * 144 * 3, pixels);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, texture_width, texture_height, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+    end_upload(slot);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
 
-    // ===== REST IS SAME =====
+void Screen::draw() {
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
 
     glUseProgram(shader_program);
     glBindVertexArray(vao);
     glBindTexture(GL_TEXTURE_2D, texture_id);
-
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 160, 144, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
     glDrawArrays(GL_TRIANGLES, 0, 6);
+}
 
-    glfwSwapBuffers(window);
+/**
+ * Returns where to write the next frame for this PBO (bound to GL_PIXEL_UNPACK_BUFFER), nullptr when mapping fails.
+ * For the persistent path we first wait for the texture copy that last read from it, which with two PBOs
+ * has always finished a frame ago.
+ */
+uint8_t* Screen::begin_upload(int slot) {
+    if (persistent_pbo) {
+        if (pbo_fences[slot]) {
+            glClientWaitSync(pbo_fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+            glDeleteSync(pbo_fences[slot]);
+            pbo_fences[slot] = nullptr;
+        }
+        return pbo_mapped[slot];
+    }
+    return static_cast<uint8_t*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, texture_width * texture_height,
+                                                  GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+}
+
+// Called after glTexSubImage2D has been queued from this PBO
+void Screen::end_upload(int slot) {
+    if (persistent_pbo) {
+        pbo_fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+}
+
+void Screen::create_pbos() {
+    const GLsizeiptr size = texture_width * texture_height;
+    auto buffer_storage = glfwExtensionSupported("GL_ARB_buffer_storage")
+        ? reinterpret_cast<BufferStorageProc>(glfwGetProcAddress("glBufferStorage"))
+        : nullptr;
+    persistent_pbo = buffer_storage != nullptr;
+
+    glGenBuffers(PBO_COUNT, pbo_ids);
+    for (int i = 0; i < PBO_COUNT; i++) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo_ids[i]);
+        if (persistent_pbo) {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            buffer_storage(GL_PIXEL_UNPACK_BUFFER, size, nullptr, flags);
+            pbo_mapped[i] = static_cast<uint8_t*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, flags));
+            if (!pbo_mapped[i]) persistent_pbo = false;
+        } else {
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        }
+    }
 
-    glfwPollEvents();
+    // A failed persistent map leaves immutable storage behind, start over with plain buffers
+    if (buffer_storage && !persistent_pbo) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glDeleteBuffers(PBO_COUNT, pbo_ids);
+        std::fill(std::begin(pbo_mapped), std::end(pbo_mapped), nullptr);
+        glGenBuffers(PBO_COUNT, pbo_ids);
+        for (GLuint pbo : pbo_ids) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        }
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+void Screen::set_palette(const float palette[4][3]) {
+    glUseProgram(shader_program);
+    glUniform3fv(glGetUniformLocation(shader_program, "palette"), 4, &palette[0][0]);
+}
+
+/**
+ * Copies the finished frame into the back slot of the triple buffer and publishes it.
+ * If the presenter hasn't picked up the previous frame yet, that frame is dropped instead of waiting on it.
+ */
+void Screen::submit_frame(const uint8_t* frame_buffer, const int size) {
+    Frame& back = frames.back();
+    std::copy(frame_buffer, frame_buffer + std::min<int>(size, back.size()), back.begin());
+    if (frames.publish()) {
+        frames_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Every refresh we show the latest complete frame. Vsync blocks here in glfwSwapBuffers, never on the emulation thread.
+ */
+void Screen::present_loop(const std::atomic<bool>& running) {
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(1);
+
+    while (running.load(std::memory_order_relaxed) && !glfwWindowShouldClose(window)) {
+        glfwPollEvents();
+
+        // Only new frames get scaled and uploaded, a duplicate just redraws the texture we already have
+        if (frames.acquire()) {
+            frame_presented = true;
+            const Frame& front = frames.front();
+            if (scaler) {
+                scaler->scale(front.data(), scaled_frame.data());
+                upload(scaled_frame.data());
+            } else {
+                upload(front.data());
+            }
+        } else if (frame_presented) {
+            frames_duplicated.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        draw();
+        glfwSwapBuffers(window);
+        swaps.fetch_add(1, std::memory_order_release);
+        swaps.notify_all();
+    }
 }
 
 GLFWwindow* Screen::init() {
@@ -49,24 +165,22 @@ GLFWwindow* Screen::init() {
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
-    window = glfwCreateWindow(windowWidth, windowHeight, "Gameboy", nullptr, nullptr);
+    window = glfwCreateWindow(DMG_WIDTH * window_scale, DMG_HEIGHT * window_scale, "Gameboy", nullptr, nullptr);
     if (!window) throw std::runtime_error("Failed to create GLFW window");
 
     glfwMakeContextCurrent(window);
     if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress))) throw std::runtime_error("GLAD failed");
 
-    // 1. TEXTURE - MUST BE 160x144
+    // 1. TEXTURE - 160x144 (times the CPU scale factor), one byte (shade index) per pixel
     glGenTextures(1, &texture_id);
     glBindTexture(GL_TEXTURE_2D, texture_id);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 160, 144, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, texture_width, texture_height, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
-    // 2. PBO
-    glGenBuffers(1, &pbo_id);
-    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo_id);
-    glBufferData(GL_PIXEL_UNPACK_BUFFER, 160 * 144 * 3, nullptr, GL_DYNAMIC_DRAW);
-    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    // 2. PBOs
+    create_pbos();
 
     // 3. GEOMETRY (VAO/VBO)
     float vertices[] = {
@@ -91,11 +205,34 @@ GLFWwindow* Screen::init() {
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
     glEnableVertexAttribArray(1);
     compile_shaders();
+    float palette[4][3];
+    for (int shade = 0; shade < 4; shade++) {
+        for (int c = 0; c < 3; c++) palette[shade][c] = DMG_PALETTE[shade][c] / 255.0f;
+    }
+    set_palette(palette);
     glfwSetKeyCallback(window, Joypad::key_callback);
     return window;
 }
 
+/**
+ * Adds a CPU scaling stage in front of the upload. The window becomes exactly factor times the DMG resolution so the
+ * GPU draws the scaled image 1:1. Must be called before init().
+ */
+void Screen::set_scaler(ScaleFilter filter, int factor) {
+    int workers = std::clamp(static_cast<int>(std::thread::hardware_concurrency()) - 2, 0, 3);
+    scaler = std::make_unique<Scaler>(filter, factor, DMG_WIDTH, DMG_HEIGHT, workers);
+    window_scale = factor;
+    texture_width = scaler->out_width();
+    texture_height = scaler->out_height();
+    scaled_frame.assign(texture_width * texture_height, 0);
+}
+
 void Screen::close() {
+    Logger::log_msg(std::format("Frames dropped: {} duplicated: {}\n", dropped_frames(), duplicated_frames()));
+    for (GLsync& fence : pbo_fences) {
+        if (fence) glDeleteSync(fence);
+        fence = nullptr;
+    }
     glfwDestroyWindow(window);
     glfwTerminate();
 }
@@ -118,8 +255,11 @@ void Screen::compile_shaders() {
         out vec4 FragColor;
         in vec2 TexCoord;
         uniform sampler2D screenTexture;
+        uniform vec3 palette[4];
         void main() {
-            FragColor = texture(screenTexture, TexCoord);
+            // GL_R8 normalizes the shade index to 0-1, scale it back up to index the palette
+            int shade = int(texture(screenTexture, TexCoord).r * 255.0 + 0.5);
+            FragColor = vec4(palette[shade & 3], 1.0);
         }
     )";
 
@@ -1,11 +1,21 @@
 #pragma once
 
+#ifdef __APPLE__
 #include <OpenGL/OpenGL.h>
+#endif
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <iostream>
 #include <format>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
 #include "../log/logger.hpp"
+#include "triple_buffer.hpp"
+#include "scaler.hpp"
+#include "palette.hpp"
 
 #define DMG_WIDTH 160
 #define DMG_HEIGHT 144
@@ -15,18 +25,64 @@ class Screen {
         Screen() = default;
         GLFWwindow* init();
         void close();
-        void render(const uint8_t *frame_buffer, int size);
+        void set_scaler(ScaleFilter filter, int factor);
+
+        // Called by the PPU on the emulation thread. Never blocks on the GPU.
+        void submit_frame(const uint8_t *frame_buffer, int size);
+
+        // Presentation loop, owns the GL context. Runs on the main thread until the window closes or running is cleared.
+        void present_loop(const std::atomic<bool>& running);
+
+        // Bumped (and notified) after every buffer swap, lets emulation lock itself to vsync
+        const std::atomic<uint64_t>& swap_counter() const { return swaps; }
+        // Wakes anything waiting on swap_counter, for shutdown
+        void wake_swap_waiters() { swaps.fetch_add(1); swaps.notify_all(); }
+
+        uint64_t dropped_frames() const { return frames_dropped.load(std::memory_order_relaxed); }
+        uint64_t duplicated_frames() const { return frames_duplicated.load(std::memory_order_relaxed); }
+
+        // Shades 0-3 to RGB (0.0 - 1.0). Only a uniform upload, must be called on the presentation thread.
+        void set_palette(const float palette[4][3]);
         GLFWwindow* window;
     private:
+        using Frame = std::array<uint8_t, DMG_WIDTH * DMG_HEIGHT>;
+        TripleBuffer<Frame> frames;
+        bool frame_presented{false};
 
-        GLuint texture_id{0}; // The handle for the 160x144 image
-        GLuint pbo_id{0};     // The handle for the Pixel Buffer Object
+        // Published frames overwritten before the presenter picked them up
+        std::atomic<uint64_t> frames_dropped{0};
+        // Refreshes where no new frame was ready, so the last one was shown again
+        std::atomic<uint64_t> frames_duplicated{0};
+        std::atomic<uint64_t> swaps{0};
+
+        // Optional CPU upscaling, the texture is then the scaled size instead of 160x144
+        std::unique_ptr<Scaler> scaler;
+        std::vector<uint8_t> scaled_frame;
+        int texture_width{DMG_WIDTH};
+        int texture_height{DMG_HEIGHT};
+        int window_scale{3};
+
+        void upload(const uint8_t *pixels);
+        void draw();
+
+        GLuint texture_id{0}; // The handle for the single channel (GL_R8) shade index image
         GLuint vao;           // the handle for VAO
-        GLuint shader_program;  // shader for openGL (we don't actually use this, the library forces us to make it)
+        GLuint shader_program;  // maps shade indices to colors with the palette uniform
+
+        /**
+         * Two PBOs so we never write into the one the driver may still be copying into the texture.
+         * With ARB_buffer_storage they stay persistently mapped and a fence per PBO tells us when it is free again.
+         * Without it (e.g. macOS, capped at 4.1) we map each frame and let the invalidate flag orphan the old storage.
+         */
+        static constexpr int PBO_COUNT = 2;
+        GLuint pbo_ids[PBO_COUNT]{};
+        uint8_t* pbo_mapped[PBO_COUNT]{};
+        GLsync pbo_fences[PBO_COUNT]{};
+        int pbo_index{0};
+        bool persistent_pbo{false};
 
-        static constexpr uint8_t rgb_palette[4][3] = {{255, 255, 255}, {211, 211, 211}, {169, 169, 169}, {0, 0, 0}};
-        static constexpr int windowWidth = DMG_WIDTH * 3;
-        static constexpr int windowHeight = DMG_HEIGHT * 3;
-        void draw_pixel_to_buffer(uint8_t *curr_pixels, int idx, uint8_t pixel);
         void compile_shaders();
+        void create_pbos();
+        uint8_t* begin_upload(int slot);
+        void end_upload(int slot);
 };
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Lock-free single producer / single consumer triple buffer.
+ *
+ * The producer (emulation thread) always owns the back slot and the consumer (presentation thread) always owns
+ * the front slot. The third slot sits in the middle and is handed over with a single atomic exchange, so neither
+ * side ever waits on the other. The FRESH bit on the middle index tells the consumer a new frame was published
+ * since its last acquire.
+ */
+template <typename T>
+class TripleBuffer {
+    public:
+        // Slot the producer is allowed to write into
+        T& back() { return slots[back_idx]; }
+
+        /**
+         * Hands the back slot over to the consumer and takes the old middle slot as the new back slot.
+         * @return true if the previous published frame was never acquired (it is now lost)
+         */
+        bool publish() {
+            uint8_t prev = middle.exchange(back_idx | FRESH_BIT, std::memory_order_acq_rel);
+            back_idx = prev & INDEX_MASK;
+            return (prev & FRESH_BIT) != 0;
+        }
+
+        /**
+         * Swaps the front slot with the middle slot if a new frame was published.
+         * @return false if nothing new was published, front() still holds the last frame
+         */
+        bool acquire() {
+            if ((middle.load(std::memory_order_relaxed) & FRESH_BIT) == 0) return false;
+            uint8_t prev = middle.exchange(front_idx, std::memory_order_acq_rel);
+            front_idx = prev & INDEX_MASK;
+            return true;
+        }
+
+        // Slot the consumer is allowed to read from
+        const T& front() const { return slots[front_idx]; }
+
+    private:
+        static constexpr uint8_t FRESH_BIT = 0x04;
+        static constexpr uint8_t INDEX_MASK = 0x03;
+
+        std::array<T, 3> slots{};
+        uint8_t back_idx{0};
+        std::atomic<uint8_t> middle{1};
+        uint8_t front_idx{2};
+};
@@ -2,17 +2,19 @@
 
 using namespace std;
 
-bool Joypad::KEYS = false;
-bool Joypad::D_PAD  = false;
-bool Joypad::interrupt = false;
-bool Joypad::UP_PRESSED = false;
-bool Joypad::DOWN_PRESSED = false;
-bool Joypad::LEFT_PRESSED = false;
-bool Joypad::RIGHT_PRESSED = false;
-bool Joypad::A_PRESSED = false;
-bool Joypad::B_PRESSED = false;
-bool Joypad::START_PRESSED = false;
-bool Joypad::SELECT_PRESSED = false;
+std::atomic<bool> Joypad::KEYS{false};
+std::atomic<bool> Joypad::D_PAD{false};
+std::atomic<bool> Joypad::interrupt{false};
+std::atomic<bool> Joypad::UP_PRESSED{false};
+std::atomic<bool> Joypad::DOWN_PRESSED{false};
+std::atomic<bool> Joypad::LEFT_PRESSED{false};
+std::atomic<bool> Joypad::RIGHT_PRESSED{false};
+std::atomic<bool> Joypad::A_PRESSED{false};
+std::atomic<bool> Joypad::B_PRESSED{false};
+std::atomic<bool> Joypad::START_PRESSED{false};
+std::atomic<bool> Joypad::SELECT_PRESSED{false};
+std::atomic<bool> Joypad::SAVE_STATE_REQUESTED{false};
+std::atomic<bool> Joypad::LOAD_STATE_REQUESTED{false};
 
 void Joypad::key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
     if (action == GLFW_PRESS) {
@@ -49,6 +51,12 @@ void Joypad::key_callback(GLFWwindow* window, int key, int scancode, int action,
                 Joypad::START_PRESSED = true;
                 interrupt = true;
                 break;
+            case (GLFW_KEY_F5): // save state
+                Joypad::SAVE_STATE_REQUESTED = true;
+                break;
+            case (GLFW_KEY_F8): // load state
+                Joypad::LOAD_STATE_REQUESTED = true;
+                break;
 
         }
     } else if (action == GLFW_RELEASE) {
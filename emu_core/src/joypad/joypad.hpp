@@ -1,22 +1,27 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <GLFW/glfw3.h>
 #include <iostream>
 
+// Keys are written by the GLFW key callback on the presentation thread and read by the emulation thread
 class Joypad {
     public:
-        static bool interrupt;
-        static bool UP_PRESSED;
-        static bool DOWN_PRESSED;
-        static bool LEFT_PRESSED;
-        static bool RIGHT_PRESSED;
-        static bool A_PRESSED;
-        static bool B_PRESSED;
-        static bool START_PRESSED;
-        static bool SELECT_PRESSED;
-        static bool D_PAD;
-        static bool KEYS;
+        static std::atomic<bool> interrupt;
+        static std::atomic<bool> UP_PRESSED;
+        static std::atomic<bool> DOWN_PRESSED;
+        static std::atomic<bool> LEFT_PRESSED;
+        static std::atomic<bool> RIGHT_PRESSED;
+        static std::atomic<bool> A_PRESSED;
+        static std::atomic<bool> B_PRESSED;
+        static std::atomic<bool> START_PRESSED;
+        static std::atomic<bool> SELECT_PRESSED;
+        static std::atomic<bool> D_PAD;
+        static std::atomic<bool> KEYS;
+        // F5 / F8, the emulation thread saves or loads a state between frames (SaveState::handle_hotkeys)
+        static std::atomic<bool> SAVE_STATE_REQUESTED;
+        static std::atomic<bool> LOAD_STATE_REQUESTED;
         static void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
         static uint8_t get_joypad_reg();
 };
\ No newline at end of file
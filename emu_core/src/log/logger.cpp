@@ -1,10 +1,13 @@
 #include "logger.hpp"
 
+#include <algorithm>
+
 using namespace std;
 
 // Initialize static members
 ofstream Logger::file_stream;
-bool Logger::enabled = false;
+mutex Logger::mutex;
+atomic<bool> Logger::enabled{false};
 int Logger::lines_since_flush = 0;
 
 
@@ -12,10 +15,12 @@ int Logger::lines_since_flush = 0;
 // Yes we aren't controlling flushing outside of log_cpu_state, but functionally we don't need to 
 
 void Logger::open(const string& filename) {
+    lock_guard<std::mutex> lock(mutex);
     file_stream.open(filename);
 }
 
 void Logger::close() {
+    lock_guard<std::mutex> lock(mutex);
     if (file_stream.is_open()) {
         file_stream.flush();
         file_stream.close();
@@ -23,12 +28,16 @@ void Logger::close() {
 }
 
 void Logger::log_msg(const string& msg){
-    if (!enabled || !file_stream.is_open()) return;
+    if (!enabled) return;
+    lock_guard<std::mutex> lock(mutex);
+    if (!file_stream.is_open()) return;
     file_stream << msg;
 }
 
 void Logger::log_cpu_state(Registers& registers, uint8_t opcode) {
-    if (!enabled || !file_stream.is_open()) return;
+    if (!enabled) return;
+    lock_guard<std::mutex> lock(mutex);
+    if (!file_stream.is_open()) return;
 
     file_stream << format("A:{:02X} F:{:02X} B:{:02X} C:{:02X} D:{:02X} E:{:02X} H:{:02X} L:{:02X} PC:{:04X} SP:{:04X} | OP:{:02X} -> {}\n",
         registers.A, registers.F, registers.B, registers.C, 
@@ -43,6 +52,7 @@ void Logger::log_cpu_state(Registers& registers, uint8_t opcode) {
 }
 
 void Logger::vram_dump(const uint8_t* VRAM) {
+    lock_guard<std::mutex> lock(mutex);
     file_stream.open("vram_dump.txt");
     file_stream.clear();
     for (int i = 0; i < 8192; i++) {
@@ -55,7 +65,9 @@ void Logger::vram_dump(const uint8_t* VRAM) {
 
 void Logger::log_cart_header(Cart& cart) {
     if (!cart.cart_loaded) return;
-    if (!enabled || !file_stream.is_open()) return;
+    if (!enabled) return;
+    lock_guard<std::mutex> lock(mutex);
+    if (!file_stream.is_open()) return;
 
     string cleanTitle = cart.title;
     cleanTitle.erase(find(cleanTitle.begin(), cleanTitle.end(), '\0'), cleanTitle.end());
@@ -1,4 +1,5 @@
 #pragma once
+#include <atomic>
 #include <fstream>
 #include <vector>
 #include <cstdint>
@@ -8,9 +9,11 @@
 #include <iostream>
 #include <format>
 #include <iomanip>
+#include <mutex>
 #include "../core/registers.hpp"
 #include "../core/cart.hpp"
 
+// Every call takes one lock: the audio thread logs rate stats while the emulation thread traces the CPU
 class Logger {
     public:
         static void log_cpu_state(Registers& registers, uint8_t opcode);
@@ -26,7 +29,8 @@ class Logger {
 
     private:
         static std::ofstream file_stream;
-        static bool enabled;
+        static std::mutex mutex;
+        static std::atomic<bool> enabled;
         static std::string get_readable(uint8_t opcode);
         static int lines_since_flush;
 
@@ -4,8 +4,38 @@ Emulator::Emulator(CPU& cpu, Bus& bus, Timer& timer, PPU& ppu, Screen& screen, A
     : cpu(cpu), bus(bus), timer(timer), ppu(ppu), screen(screen), apu(apu)
 {}
 
+/**
+ * Emulation runs on its own thread so vsync and compositor stalls can't hold it up.
+ * The calling (main) thread becomes the presentation thread: GLFW needs window events and the GL context there.
+ * Exceptions from the emulation thread are rethrown here once both sides have stopped.
+ */
 void Emulator::run() {
-    while (!glfwWindowShouldClose(screen.window)) {
+    running = true;
+    pacer = std::make_unique<FramePacer>(sync_mode, &screen.swap_counter());
+    std::exception_ptr emulation_error;
+
+    std::thread emulation_thread([this, &emulation_error] {
+        try {
+            while (running.load(std::memory_order_relaxed)) {
+                tick();
+            }
+        } catch (...) {
+            emulation_error = std::current_exception();
+        }
+        running = false;
+    });
+
+    screen.present_loop(running);
+    running = false;
+    screen.wake_swap_waiters(); // in case emulation is waiting for a swap that won't come
+    emulation_thread.join();
+
+    if (emulation_error) std::rethrow_exception(emulation_error);
+}
+
+void Emulator::run_headless(uint64_t max_frames, const std::atomic<bool>& stop) {
+    headless = true;
+    while (!stop.load(std::memory_order_relaxed) && (max_frames == 0 || frames < max_frames)) {
         tick();
     }
 }
@@ -19,6 +49,20 @@ void Emulator::tick() {
     ppu.tick(m_cycles);
     apu.tick(m_cycles, apu_div_tick);
     handle_isr();
+
+    if (ppu.frame_ready) dispatch_frame();
+}
+
+void Emulator::dispatch_frame() {
+    ppu.frame_ready = false;
+    frames++;
+    const uint8_t* frame = ppu.get_frame_buffer();
+    if (!headless) screen.submit_frame(frame, PPU::FRAME_BUFFER_SIZE);
+    if (capture) capture->submit_frame(frame);
+    if (shared_memory) shared_memory->publish(frames);
+    if (save_writer) save_writer->collect();
+    if (save_state) save_state->handle_hotkeys();
+    if (pacer) pacer->wait_for_next_frame(running);
 }
 
 /**
@@ -1,10 +1,17 @@
 #pragma once
 #include "../core/bus.hpp"
 #include "../core/cpu.hpp"
+#include "../core/save_state.hpp"
 #include "../core/timer.hpp"
+#include "../graphics/frame_capture.hpp"
 #include "../graphics/ppu.hpp"
 #include "../graphics/screen.hpp"
+#include "frame_pacer.hpp"
+#include "shared_memory.hpp"
+#include <atomic>
 #include <chrono>
+#include <exception>
+#include <memory>
 #include <thread>
 
 #define M_CYCLES_PER_FRAME 2
@@ -14,8 +21,20 @@ class Emulator {
     public:
         Emulator(CPU& cpu, Bus& bus, Timer& timer, PPU& ppu, Screen& screen, APU& apu);
         void run();
+        // No window: emulate as fast as possible until max_frames (0 = no limit) or stop is set
+        void run_headless(uint64_t max_frames, const std::atomic<bool>& stop);
         void handle_isr();
 
+        // Optional, every finished frame is also handed to it
+        void set_capture(FrameCapture* capture) { this->capture = capture; }
+        void set_shared_memory(SharedMemoryExport* shared_memory) { this->shared_memory = shared_memory; }
+        void set_save_writer(SaveWriter* save_writer) { this->save_writer = save_writer; }
+        // Save state hotkeys are handled between frames
+        void set_save_state(SaveState* save_state) { this->save_state = save_state; }
+        // How run() paces emulated frames, headless runs are never paced
+        void set_sync_mode(SyncMode mode) { sync_mode = mode; }
+        uint64_t frame_count() const { return frames; }
+
     private:
         CPU& cpu;
         Bus& bus;
@@ -24,5 +43,18 @@ class Emulator {
         Screen& screen;
         APU& apu;
 
+        FrameCapture* capture{nullptr};
+        SharedMemoryExport* shared_memory{nullptr};
+        SaveWriter* save_writer{nullptr};
+        SaveState* save_state{nullptr};
+
+        SyncMode sync_mode{SyncMode::TIMER};
+        std::unique_ptr<FramePacer> pacer;
+
+        std::atomic<bool> running{false};
+        bool headless{false};
+        uint64_t frames{0};
+
         void tick();
+        void dispatch_frame();
 };
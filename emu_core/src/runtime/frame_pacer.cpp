@@ -0,0 +1,39 @@
+#include "frame_pacer.hpp"
+
+#include <thread>
+
+FramePacer::FramePacer(SyncMode mode, const std::atomic<uint64_t>* swap_counter)
+    : mode(mode), swap_counter(swap_counter), next_frame(std::chrono::steady_clock::now())
+{
+    if (swap_counter) last_swap = swap_counter->load(std::memory_order_acquire);
+}
+
+void FramePacer::wait_for_next_frame(const std::atomic<bool>& running) {
+    if (mode == SyncMode::VSYNC && swap_counter) {
+        if (!running.load()) return;
+        // Already behind the display: don't wait, the presenter repeats a frame and audio rate control catches up
+        uint64_t swap = swap_counter->load(std::memory_order_acquire);
+        if (swap == last_swap) {
+            swap_counter->wait(last_swap, std::memory_order_acquire);
+            swap = swap_counter->load(std::memory_order_acquire);
+        }
+        last_swap = swap;
+        return;
+    }
+
+    next_frame += FRAME_DURATION;
+    auto now = std::chrono::steady_clock::now();
+    if (now - next_frame > std::chrono::milliseconds(100)) {
+        // Fell far behind (debugger, window drag...), start over instead of running fast to catch up
+        next_frame = now;
+        return;
+    }
+    std::this_thread::sleep_until(next_frame);
+}
+
+bool FramePacer::parse_mode(const std::string& name, SyncMode& mode) {
+    if (name == "timer") mode = SyncMode::TIMER;
+    else if (name == "vsync") mode = SyncMode::VSYNC;
+    else return false;
+    return true;
+}
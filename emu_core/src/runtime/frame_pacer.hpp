@@ -0,0 +1,33 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+enum class SyncMode {
+    TIMER, // sleep to the DMG's own frame rate
+    VSYNC  // one emulated frame per display refresh, audio rate control absorbs the difference
+};
+
+/**
+ * Paces the emulation thread at the end of every emulated frame. Audio used to do this by blocking on the queue,
+ * now audio follows video (see RateControl) and video follows this.
+ */
+class FramePacer {
+    public:
+        // DMG: 70224 dots per frame at 4194304 Hz, ~59.73 fps
+        static constexpr std::chrono::nanoseconds FRAME_DURATION{16742706};
+
+        FramePacer(SyncMode mode, const std::atomic<uint64_t>* swap_counter);
+
+        // Blocks until the next frame may start. running is checked so shutdown can't leave us waiting on a swap.
+        void wait_for_next_frame(const std::atomic<bool>& running);
+
+        static bool parse_mode(const std::string& name, SyncMode& mode);
+
+    private:
+        SyncMode mode;
+        const std::atomic<uint64_t>* swap_counter;
+        uint64_t last_swap{0};
+        std::chrono::steady_clock::time_point next_frame;
+};
@@ -0,0 +1,176 @@
+#include "gbs_player.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace {
+
+constexpr size_t BANK_SIZE = 0x4000;
+
+uint16_t get_le16(const std::vector<uint8_t>& data, size_t offset) {
+    return data[offset] | (data[offset + 1] << 8);
+}
+
+// Header strings are 32 bytes, zero padded (not always zero terminated)
+std::string get_string(const std::vector<uint8_t>& data, size_t offset) {
+    const char* text = reinterpret_cast<const char*>(data.data() + offset);
+    return std::string(text, strnlen(text, 32));
+}
+
+}
+
+GbsHeader GbsPlayer::parse_header(const std::vector<uint8_t>& file) {
+    if (file.size() <= HEADER_SIZE || std::memcmp(file.data(), "GBS", 3) != 0) {
+        throw std::runtime_error("Not a GBS file");
+    }
+    GbsHeader header;
+    header.version = file[0x03];
+    header.song_count = file[0x04];
+    header.first_song = file[0x05];
+    header.load_addr = get_le16(file, 0x06);
+    header.init_addr = get_le16(file, 0x08);
+    header.play_addr = get_le16(file, 0x0A);
+    header.stack_pointer = get_le16(file, 0x0C);
+    header.timer_modulo = file[0x0E];
+    header.timer_control = file[0x0F];
+    header.title = get_string(file, 0x10);
+    header.author = get_string(file, 0x30);
+    header.copyright = get_string(file, 0x50);
+
+    if (header.version != 1) throw std::runtime_error(std::format("Unsupported GBS version {}", header.version));
+    if (header.song_count == 0) throw std::runtime_error("GBS file has no songs");
+    // Everything below 0x400 is ours (RST and interrupt vectors, the idle loop, the cart header)
+    if (header.load_addr < 0x400 || header.load_addr >= 0x8000) {
+        throw std::runtime_error(std::format("GBS load address 0x{:04X} is outside 0x0400 - 0x7FFF", header.load_addr));
+    }
+    return header;
+}
+
+std::vector<uint8_t> GbsPlayer::read_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("File not found");
+    return std::vector<uint8_t>((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+bool GbsPlayer::is_gbs_path(const std::string& path) {
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos) return false;
+    std::string extension = path.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension == "gbs";
+}
+
+/**
+ * Lays the GBS data out at the load address of an MBC1 (+RAM) image, banks following on linearly like GBS drivers
+ * expect. Bank 0 below the load address gets:
+ *   0x00 - 0x38  RST n, which GBS redirects to load + n
+ *   0x40 - 0x60  RETI, interrupts are ours to deliver (as play calls), a stray one just returns
+ *   IDLE_ADDR    JR -2
+ */
+std::vector<uint8_t> GbsPlayer::build_rom(const GbsHeader& header, const std::vector<uint8_t>& file) {
+    size_t end = header.load_addr + (file.size() - HEADER_SIZE);
+    size_t banks = std::max<size_t>(2, (end + BANK_SIZE - 1) / BANK_SIZE);
+    // The 5 bit MBC1 bank register reaches 32 banks, the upper bits need mode 1 which no driver sets up
+    if (banks > 32) throw std::runtime_error(std::format("GBS image needs {} banks, only 32 are supported", banks));
+    uint8_t rom_code = 0;
+    while ((2u << rom_code) < banks) rom_code++;
+
+    std::vector<uint8_t> rom((2u << rom_code) * BANK_SIZE, 0x00);
+    for (uint16_t rst = 0x00; rst <= 0x38; rst += 8) {
+        uint16_t target = header.load_addr + rst;
+        rom[rst] = 0xC3; // JP a16
+        rom[rst + 1] = target & 0xFF;
+        rom[rst + 2] = target >> 8;
+    }
+    for (uint16_t vector = Interrupt::ADDR_VBLANK; vector <= Interrupt::ADDR_JOYPAD; vector += 8) rom[vector] = 0xD9;
+    rom[IDLE_ADDR] = 0x18;
+    rom[IDLE_ADDR + 1] = 0xFE;
+
+    rom[0x0147] = 0x02; // MBC1 + RAM, no battery so no save file
+    rom[0x0148] = rom_code;
+    rom[0x0149] = 0x02; // 8 KB, drivers may keep state at 0xA000
+    std::copy(file.begin() + HEADER_SIZE, file.end(), rom.begin() + header.load_addr);
+    return rom;
+}
+
+GbsPlayer::GbsPlayer(const std::vector<uint8_t>& file, int song, APU& apu)
+    : header(parse_header(file)), apu(apu), bus(cart, ppu, timer, apu), cpu(bus, registers)
+{
+    if (song < 0 || song >= header.song_count) {
+        throw std::runtime_error(std::format("GBS file has songs 1 - {}", header.song_count));
+    }
+    cart.loadFromData(build_rom(header, file));
+    bus.write(0x0000, 0x0A); // cart RAM on
+    bus.write(0x2000, 0x01); // bank 1 at 0x4000
+    bus.write(0xFF06, header.timer_modulo);
+    bus.write(0xFF07, header.timer_control & 0x07); // bit 7 asks for CGB double speed, we're a DMG
+
+    registers.SP = header.stack_pointer;
+    registers.A = static_cast<uint8_t>(song);
+    call(header.init_addr);
+    finish_routine("init");
+
+    // The first play is one period after init returns
+    play_due = false;
+    frame_phase = 0;
+    late = 0;
+}
+
+void GbsPlayer::run(uint64_t m_cycles) {
+    uint64_t end = cycles + m_cycles;
+    while (cycles < end) {
+        if (registers.PC != IDLE_ADDR) {
+            finish_routine("play");
+        } else if (play_due) {
+            play_due = false;
+            plays++;
+            call(header.play_addr);
+        } else {
+            // Nothing for the CPU to do but spin on the JR, let time pass in bigger steps
+            advance(static_cast<int>(std::min<uint64_t>(IDLE_STEP, end - cycles)));
+        }
+    }
+}
+
+// Same as the CPU's CALL: return address pushed high byte first
+void GbsPlayer::call(uint16_t addr) {
+    registers.SP -= 2;
+    bus.write(registers.SP, IDLE_ADDR & 0xFF);
+    bus.write(registers.SP + 1, IDLE_ADDR >> 8);
+    registers.PC = addr;
+}
+
+void GbsPlayer::finish_routine(const char* name) {
+    uint64_t start = cycles;
+    while (registers.PC != IDLE_ADDR) {
+        advance(cpu.step());
+        if (cycles - start > MAX_ROUTINE_CYCLES) {
+            throw std::runtime_error(std::format("GBS {} routine didn't return (PC 0x{:04X})", name, registers.PC));
+        }
+    }
+}
+
+void GbsPlayer::advance(int m_cycles) {
+    cycles += m_cycles;
+    bool apu_div_tick = timer.tick(m_cycles);
+    apu.tick(m_cycles, apu_div_tick);
+
+    bool play_tick;
+    if (header.uses_timer()) {
+        play_tick = timer.interrupt;
+        timer.interrupt = false;
+    } else {
+        frame_phase += m_cycles;
+        play_tick = frame_phase >= CYCLES_PER_FRAME;
+        if (play_tick) frame_phase -= CYCLES_PER_FRAME;
+    }
+    if (play_tick) {
+        if (play_due || registers.PC != IDLE_ADDR) late++;
+        play_due = true;
+    }
+}
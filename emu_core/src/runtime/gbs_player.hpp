@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../core/bus.hpp"
+#include "../core/cart.hpp"
+#include "../core/cpu.hpp"
+#include "../core/registers.hpp"
+#include "../core/timer.hpp"
+#include "../graphics/ppu.hpp"
+#include "../audio/apu.hpp"
+
+// https://gbdev.gg8.se/wiki/articles/GBS_Format
+struct GbsHeader {
+    uint8_t version;
+    uint8_t song_count;
+    uint8_t first_song; // 1 based
+    uint16_t load_addr;
+    uint16_t init_addr;
+    uint16_t play_addr;
+    uint16_t stack_pointer;
+    uint8_t timer_modulo;
+    uint8_t timer_control;
+    std::string title;
+    std::string author;
+    std::string copyright;
+
+    // Bit 2 of TAC: play runs on the timer interrupt (TMA/TAC from the header), otherwise at the VBlank rate
+    bool uses_timer() const { return timer_control & 0x04; }
+};
+
+/**
+ * Plays GBS sound files (music ripped out of a game: the driver code plus a header saying where to call it).
+ * Only the CPU, timer and APU run. The code is placed in a ROM image for an MBC1 cart, which Bus and Cart handle as
+ * they are, and the PPU exists only because Bus wants one; it never ticks.
+ *
+ * Routines are called by pushing IDLE_ADDR as the return address and jumping. IDLE_ADDR holds a JR to itself, so
+ * once PC is back there the routine returned and we only advance time until play is due again.
+ */
+class GbsPlayer {
+    public:
+        static constexpr int HEADER_SIZE = 0x70;
+        // 70224 dots per frame
+        static constexpr int CYCLES_PER_FRAME = 17556;
+        static constexpr uint64_t M_CYCLES_PER_SECOND = 1048576;
+
+        // Throws std::runtime_error for anything that isn't a GBS we can load
+        static GbsHeader parse_header(const std::vector<uint8_t>& file);
+        static std::vector<uint8_t> read_file(const std::string& path);
+        static bool is_gbs_path(const std::string& path);
+
+        // song is 0 based. Loads the image and runs init, the APU should be init()ed already.
+        GbsPlayer(const std::vector<uint8_t>& file, int song, APU& apu);
+
+        // Emulates m_cycles more, calling play every time the timer or VBlank says so
+        void run(uint64_t m_cycles);
+
+        const GbsHeader& get_header() const { return header; }
+        uint64_t cycle_count() const { return cycles; }
+        uint64_t play_count() const { return plays; }
+        // Play was due again before the previous call returned
+        uint64_t late_plays() const { return late; }
+
+        // Sentinel return address, holds JR -2
+        static constexpr uint16_t IDLE_ADDR = 0x0070;
+        // A routine that runs longer than this (10 s) isn't coming back
+        static constexpr uint64_t MAX_ROUTINE_CYCLES = 10 * M_CYCLES_PER_SECOND;
+        // Time advances in steps this big (M cycles) while the CPU would only spin on IDLE_ADDR
+        static constexpr int IDLE_STEP = 16;
+
+    private:
+        GbsHeader header;
+        Cart cart;
+        PPU ppu;
+        Timer timer;
+        APU& apu;
+        Bus bus;
+        Registers registers;
+        CPU cpu;
+
+        uint64_t cycles{0};
+        uint64_t plays{0};
+        uint64_t late{0};
+        int frame_phase{0};
+        bool play_due{false};
+
+        static std::vector<uint8_t> build_rom(const GbsHeader& header, const std::vector<uint8_t>& file);
+        void call(uint16_t addr);
+        // Runs the CPU until the routine called last returns
+        void finish_routine(const char* name);
+        void advance(int m_cycles);
+};
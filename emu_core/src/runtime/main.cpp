@@ -3,10 +3,19 @@
 #include "../core/cart.hpp"
 #include "../core/cpu.hpp"
 #include "../core/registers.hpp"
+#include "../core/rom_index.hpp"
+#include "../core/save_state.hpp"
 #include <GLFW/glfw3.h>
 #include "emulator.hpp"
+#include "gbs_player.hpp"
 #include "audio/apu.hpp"
 #include "audio/speaker.hpp"
+#include "audio/vgm_writer.hpp"
+#include "audio/wav_writer.hpp"
+#include <chrono>
+#include <csignal>
+#include <filesystem>
+#include <memory>
 
 Cart loadCart(std::string romPath) {
     Cart cart;
@@ -18,13 +27,107 @@ Cart loadCart(std::string romPath) {
     return cart;
 }
 
+// Returns the value following `flag` (e.g. --filter xbr), or nullptr when the flag isn't given
+const char* get_option(int argc, char* argv[], std::string_view flag) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (flag == argv[i]) return argv[i + 1];
+    }
+    return nullptr;
+}
+
+bool has_flag(int argc, char* argv[], std::string_view flag) {
+    return std::find(argv, argv + argc, flag) != (argv + argc);
+}
+
+// Ctrl+C in headless mode stops emulation cleanly so capture files get finished
+std::atomic<bool> stop_requested{false};
+void request_stop(int) { stop_requested = true; }
+
+/**
+ * GBS files only need the CPU and APU: no window, the PPU never runs. Plays until Ctrl+C or --seconds, in real time
+ * unless headless (then as fast as it goes, e.g. to render a track with --audio-dump).
+ */
+int play_gbs(int argc, char* argv[], const std::string& path, APU& apu, bool headless) {
+    std::vector<uint8_t> file = GbsPlayer::read_file(path);
+    GbsHeader header = GbsPlayer::parse_header(file);
+    const char* track = get_option(argc, argv, "--track");
+    int song = track ? std::atoi(track) : header.first_song;
+    if (song < 1 || song > header.song_count) {
+        std::cerr << "No track " << song << " (1 - " << static_cast<int>(header.song_count) << ")" << std::endl;
+        return 1;
+    }
+    std::cout << header.title << " - " << header.author << " (" << header.copyright << "), track " << song
+              << " of " << static_cast<int>(header.song_count) << std::endl;
+
+    GbsPlayer player(file, song - 1, apu);
+    const char* seconds = get_option(argc, argv, "--seconds");
+    uint64_t end = seconds ? static_cast<uint64_t>(std::atof(seconds) * GbsPlayer::M_CYCLES_PER_SECOND) : 0;
+    std::unique_ptr<FramePacer> pacer;
+    if (!headless) pacer = std::make_unique<FramePacer>(SyncMode::TIMER, nullptr);
+    std::atomic<bool> running{true};
+
+    std::signal(SIGINT, request_stop);
+    auto start = std::chrono::steady_clock::now();
+    while (!stop_requested && (end == 0 || player.cycle_count() < end)) {
+        uint64_t frame = GbsPlayer::CYCLES_PER_FRAME;
+        player.run(end ? std::min(frame, end - player.cycle_count()) : frame);
+        if (pacer) pacer->wait_for_next_frame(running);
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double played = static_cast<double>(player.cycle_count()) / GbsPlayer::M_CYCLES_PER_SECOND;
+    std::cout << "Played " << played << " s (" << player.play_count() << " play calls, " << player.late_plays()
+              << " late) in " << elapsed << " s" << std::endl;
+    return 0;
+}
+
+/**
+ * Indexes every ROM under dir for the launcher, then exits. The index (--index, default dir/rom_index.tsv) is
+ * reused, so only new and changed files get read.
+ */
+int scan_library(int argc, char* argv[], const std::string& dir) {
+    const char* index_option = get_option(argc, argv, "--index");
+    std::string index_path = index_option ? index_option : (std::filesystem::path(dir) / "rom_index.tsv").string();
+    // Mostly waiting on the disk, so more threads than cores doesn't hurt. The calling thread is one of them.
+    int workers = std::clamp(static_cast<int>(std::thread::hardware_concurrency()), 1, 16) - 1;
+    ThreadPool pool(workers);
+
+    auto start = std::chrono::steady_clock::now();
+    RomIndex index;
+    index.load(index_path);
+    RomIndex::ScanStats stats = index.scan(dir, pool);
+    index.save(index_path);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Indexed " << index.get_entries().size() << " ROMs in " << elapsed << " s (" << stats.read
+              << " read, " << stats.unchanged << " unchanged, " << stats.removed << " removed, " << stats.failed
+              << " unreadable) to " << index_path << std::endl;
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
     if (argc < 2) {
-        std::cerr << "Usage: ./emulator <rom_path>" << std::endl;
+        std::cerr << "Usage: ./emulator <rom_path> [--log] [--filter nearest|scalex|xbr] [--scale 1|2|3|4]"
+                     " [--headless] [--frames N] [--capture out.y4m] [--capture-png dir]"
+                     " [--capture-queue N] [--capture-drop newest|oldest] [--shm /name]"
+                     " [--sync timer|vsync] [--audio-stats] [--mute] [--audio-dump out.wav|out.raw]"
+                     " [--sample-rate HZ] [--resampler fast|medium|high] [--audio-thread]"
+                     " [--vgm out.vgm] [--save-interval S] [--load-state file.state]\n"
+                     "       ./emulator <file.gbs> [--track N] [--seconds S] [--headless] (and the audio options)\n"
+                     "       ./emulator --scan <dir> [--index index.tsv]"
+                     << std::endl;
         return 1; 
     }
+    if (const char* scan_dir = get_option(argc, argv, "--scan")) {
+        try {
+            return scan_library(argc, argv, scan_dir);
+        } catch (const std::runtime_error& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    }
     std::string romPath = argv[1];
-    bool enable_logging = std::find(argv, argv + argc, std::string_view("--log")) != (argv + argc);
+    bool enable_logging = has_flag(argc, argv, "--log");
+    bool headless = has_flag(argc, argv, "--headless");
+    bool gbs = GbsPlayer::is_gbs_path(romPath);
 
     if (enable_logging) {
         Logger::open("cpu_trace.log");
@@ -32,16 +135,102 @@ int main(int argc, char* argv[]) {
     }
 
     // Load game
-    Cart cart = loadCart(romPath);
-    Logger::log_cart_header(cart);
+    Cart cart;
+    if (!gbs) {
+        cart = loadCart(romPath);
+        Logger::log_cart_header(cart);
+    }
 
     //Setup classes
     Screen screen;
-    screen.init();
-    PPU ppu (screen);
-    Speaker speaker;
-    APU apu(speaker);
+    const char* filter_name = get_option(argc, argv, "--filter");
+    const char* scale = get_option(argc, argv, "--scale");
+    if (filter_name || scale) {
+        // --scale on its own upscales with nearest
+        ScaleFilter filter = ScaleFilter::NEAREST;
+        if (filter_name && !Scaler::parse_filter(filter_name, filter)) {
+            std::cerr << "Unknown filter " << filter_name << " (nearest, scalex, xbr)" << std::endl;
+            return 1;
+        }
+        int factor = scale ? std::atoi(scale) : 3;
+        if (factor < Scaler::min_factor(filter) || factor > SCALER_MAX_FACTOR) {
+            std::cerr << "Unsupported scale " << scale << " for " << Scaler::filter_name(filter)
+                      << " (" << Scaler::min_factor(filter) << " - " << SCALER_MAX_FACTOR << ")" << std::endl;
+            return 1;
+        }
+        screen.set_scaler(filter, factor);
+    }
+    // Checked before the window and audio start, a typo has nothing to shut down
+    CaptureDropPolicy drop_policy = CaptureDropPolicy::DROP_NEWEST;
+    const char* drop = get_option(argc, argv, "--capture-drop");
+    if (drop && !FrameCapture::parse_drop_policy(drop, drop_policy)) {
+        std::cerr << "Unknown capture drop policy " << drop << " (newest, oldest)" << std::endl;
+        return 1;
+    }
+    SyncMode sync_mode = SyncMode::TIMER;
+    const char* sync = get_option(argc, argv, "--sync");
+    if (sync && !FramePacer::parse_mode(sync, sync_mode)) {
+        std::cerr << "Unknown sync mode " << sync << " (timer, vsync)" << std::endl;
+        return 1;
+    }
+    const char* sample_rate = get_option(argc, argv, "--sample-rate");
+    int rate = sample_rate ? std::atoi(sample_rate) : AudioSink::DEFAULT_SAMPLE_RATE;
+    if (rate < 8000 || rate > 192000) {
+        std::cerr << "Unsupported sample rate " << rate << " (8000 - 192000)" << std::endl;
+        return 1;
+    }
+    ResamplerQuality quality = ResamplerQuality::MEDIUM;
+    const char* quality_name = get_option(argc, argv, "--resampler");
+    if (quality_name && !Resampler::parse_quality(quality_name, quality)) {
+        std::cerr << "Unknown resampler quality " << quality_name << " (fast, medium, high)" << std::endl;
+        return 1;
+    }
+    if (!headless && !gbs) screen.init();
+    PPU ppu;
+    // Headless runs don't play audio unless it's dumped, and without a listener the APU skips mixing
+    std::unique_ptr<AudioSink> audio_sink;
+    if (const char* dump = get_option(argc, argv, "--audio-dump")) {
+        try {
+            audio_sink = std::make_unique<WavWriter>(dump, rate);
+        } catch (const std::runtime_error& e) {
+            std::cerr << e.what() << std::endl;
+            if (!headless && !gbs) screen.close();
+            return 1;
+        }
+    } else if (headless || has_flag(argc, argv, "--mute")) {
+        audio_sink = std::make_unique<NullAudioSink>();
+    } else {
+        audio_sink = std::make_unique<Speaker>(rate);
+    }
+    APU apu(*audio_sink);
+    if (quality_name) apu.set_resampler_quality(quality);
+    apu.set_print_audio_stats(has_flag(argc, argv, "--audio-stats"));
+    apu.set_threaded(has_flag(argc, argv, "--audio-thread"));
     apu.init();
+    std::unique_ptr<VgmWriter> vgm_log;
+    if (const char* vgm_path = get_option(argc, argv, "--vgm")) {
+        try {
+            vgm_log = std::make_unique<VgmWriter>(vgm_path);
+        } catch (const std::runtime_error& e) {
+            std::cerr << e.what() << std::endl;
+            if (!headless && !gbs) screen.close();
+            apu.close();
+            audio_sink->close();
+            return 1;
+        }
+        apu.set_register_log(vgm_log.get()); // apu.close() finishes the file
+    }
+    if (gbs) {
+        int result = 1;
+        try {
+            result = play_gbs(argc, argv, romPath, apu, headless);
+        } catch (const std::runtime_error& e) {
+            std::cout << e.what() << std::endl;
+        }
+        apu.close();
+        audio_sink->close();
+        return result;
+    }
 
     Timer timer;
     Bus bus(cart, ppu, timer, apu);
@@ -50,13 +239,82 @@ int main(int argc, char* argv[]) {
     CPU cpu(bus, registers);
 
     Emulator emulator(cpu, bus, timer, ppu, screen, apu);
+    emulator.set_sync_mode(sync_mode);
+
+    std::unique_ptr<FrameCapture> capture;
+    const char* y4m_path = get_option(argc, argv, "--capture");
+    const char* png_dir = get_option(argc, argv, "--capture-png");
+    if (y4m_path || png_dir) {
+        const char* queue = get_option(argc, argv, "--capture-queue");
+        try {
+            capture = std::make_unique<FrameCapture>(y4m_path ? y4m_path : "", png_dir ? png_dir : "",
+                                                     queue ? std::atoi(queue) : 64, drop_policy);
+        } catch (const std::runtime_error& e) {
+            // Also a png directory that can't be created (filesystem_error)
+            std::cerr << e.what() << std::endl;
+            if (!headless) screen.close();
+            apu.close();
+            audio_sink->close();
+            return 1;
+        }
+        emulator.set_capture(capture.get());
+    }
+
+    std::unique_ptr<SharedMemoryExport> shared_memory;
+    if (const char* shm_name = get_option(argc, argv, "--shm")) {
+        try {
+            shared_memory = std::make_unique<SharedMemoryExport>(shm_name, bus, ppu, cart);
+        } catch (const std::runtime_error& e) {
+            std::cerr << e.what() << std::endl;
+            if (capture) capture->stop();
+            if (!headless) screen.close();
+            apu.close();
+            audio_sink->close();
+            return 1;
+        }
+        emulator.set_shared_memory(shared_memory.get());
+    }
+
+    // Battery saves are written in the background every S seconds (0: only at exit)
+    const char* save_interval = get_option(argc, argv, "--save-interval");
+    double save_seconds = save_interval ? std::atof(save_interval) : 1.0;
+    if (save_seconds > 0) {
+        auto interval = std::chrono::milliseconds(static_cast<int64_t>(save_seconds * 1000));
+        emulator.set_save_writer(cart.start_autosave(interval));
+    }
+
+    // F5 saves a state next to the ROM and F8 loads it. --load-state boots from a state, F5 / F8 then use that file.
+    const char* load_state = get_option(argc, argv, "--load-state");
+    std::string state_path = load_state ? load_state
+                                        : std::filesystem::path(romPath).replace_extension(".state").string();
+    SaveState save_state(cpu, bus, cart, ppu, timer, apu, state_path);
+    emulator.set_save_state(&save_state);
 
     try {
-        emulator.run();
+        // A state that doesn't load shuts down like any other error
+        if (load_state) save_state.load_file(load_state);
+        if (headless) {
+            std::signal(SIGINT, request_stop);
+            const char* frames = get_option(argc, argv, "--frames");
+            emulator.run_headless(frames ? std::strtoull(frames, nullptr, 10) : 0, stop_requested);
+        } else {
+            emulator.run();
+            screen.close();
+        }
+        apu.close();
+        audio_sink->close();
+        if (capture) {
+            capture->stop();
+            std::cout << "Captured " << capture->frames_written() << " of " << emulator.frame_count()
+                      << " frames (" << capture->frames_dropped() << " dropped)" << std::endl;
+        }
         cart.create_save_file(); // Always save file after app is closed
     } catch (const std::runtime_error& e) {
         Logger::close();
-        screen.close();
+        if (capture) capture->stop();
+        if (!headless) screen.close();
+        apu.close();
+        audio_sink->close();
         cart.create_save_file(); //try to save even if there was a crash
         std::cout << e.what() << std::endl;
     }
@@ -0,0 +1,94 @@
+#include "shared_memory.hpp"
+#include "../core/bus.hpp"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <new>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+
+SharedMemoryExport::SharedMemoryExport(const std::string& name, const Bus& bus, const PPU& ppu, const Cart& cart)
+    : name(name), bus(bus), ppu(ppu), cart(cart)
+{
+    const uint64_t sizes[SHM_REGION_COUNT] = {
+        PPU::FRAME_BUFFER_SIZE,
+        Bus::WRAM_SIZE,
+        Bus::HRAM_SIZE,
+        PPU::OAM_SIZE,
+        cart.get_ram().size()
+    };
+
+    // Region data is 64 byte aligned so readers can use whatever loads they like
+    auto align = [](uint64_t v) { return (v + 63) & ~uint64_t(63); };
+    uint64_t offset = align(sizeof(ShmHeader) + SHM_REGION_COUNT * sizeof(ShmRegion));
+    uint64_t offsets[SHM_REGION_COUNT];
+    for (uint32_t i = 0; i < SHM_REGION_COUNT; i++) {
+        offsets[i] = offset;
+        offset = align(offset + sizes[i]);
+    }
+    segment_size = offset;
+
+    // Never unlinked up front: the name may belong to another running emulator whose readers would be cut off
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0 && errno == EEXIST) {
+        throw std::runtime_error("Shared memory " + name + " already exists, another emulator is using it or a crashed "
+                                 "one left it behind (remove /dev/shm" + name + ")");
+    }
+    if (fd < 0) throw std::runtime_error("Couldn't create shared memory " + name);
+    if (ftruncate(fd, static_cast<off_t>(segment_size)) != 0) {
+        ::close(fd);
+        shm_unlink(name.c_str());
+        throw std::runtime_error("Couldn't size shared memory " + name);
+    }
+    void* mapped = mmap(nullptr, segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        throw std::runtime_error("Couldn't map shared memory " + name);
+    }
+    segment = static_cast<uint8_t*>(mapped);
+
+    regions = reinterpret_cast<ShmRegion*>(segment + sizeof(ShmHeader));
+    for (uint32_t i = 0; i < SHM_REGION_COUNT; i++) {
+        ShmRegion* region = new (&regions[i]) ShmRegion;
+        region->sequence.store(0, std::memory_order_relaxed);
+        region->id = i;
+        region->frame = 0;
+        region->offset = offsets[i];
+        region->size = sizes[i];
+    }
+
+    // Header goes last, a reader that sees the magic sees a complete layout
+    ShmHeader* header = reinterpret_cast<ShmHeader*>(segment);
+    header->version = SHM_VERSION;
+    header->region_count = SHM_REGION_COUNT;
+    header->header_size = sizeof(ShmHeader);
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = SHM_MAGIC;
+}
+
+SharedMemoryExport::~SharedMemoryExport() {
+    if (segment) munmap(segment, segment_size);
+    shm_unlink(name.c_str());
+}
+
+void SharedMemoryExport::publish(uint64_t frame) {
+    write_region(SHM_FRAMEBUFFER, ppu.get_frame_buffer(), frame);
+    write_region(SHM_WRAM, bus.get_wram(), frame);
+    write_region(SHM_HRAM, bus.get_hram(), frame);
+    write_region(SHM_OAM, ppu.get_oam(), frame);
+    write_region(SHM_CART_RAM, cart.get_ram().data(), frame);
+}
+
+void SharedMemoryExport::write_region(ShmRegionId id, const uint8_t* src, uint64_t frame) {
+    ShmRegion& region = regions[id];
+    if (region.size == 0) return;
+
+    uint32_t sequence = region.sequence.load(std::memory_order_relaxed);
+    region.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(segment + region.offset, src, region.size);
+    region.frame = frame;
+    region.sequence.store(sequence + 2, std::memory_order_release);
+}
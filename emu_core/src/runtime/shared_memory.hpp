@@ -0,0 +1,94 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+/**
+ * Layout of the shared memory segment written by SharedMemoryExport (--shm /name).
+ * External tools (bots, overlays...) shm_open + mmap the segment read only and read regions in place.
+ *
+ *  ShmHeader | ShmRegion[region_count] | region data...
+ *
+ * Every region has its own seqlock: the sequence is odd while the emulator is writing it. A reader loads the
+ * sequence, reads the data, then checks the sequence again; if it was odd or changed the read has to be retried.
+ * shm_read_region below does exactly that. Regions are updated once per frame, at the end of VBlank.
+ */
+static constexpr uint32_t SHM_MAGIC = 0x4742534D; // "GBSM"
+static constexpr uint32_t SHM_VERSION = 1;
+
+enum ShmRegionId : uint32_t {
+    SHM_FRAMEBUFFER = 0, // 160x144 shade indices (0-3)
+    SHM_WRAM,
+    SHM_HRAM,
+    SHM_OAM,
+    SHM_CART_RAM,        // size 0 when the cart has none
+    SHM_REGION_COUNT
+};
+
+struct ShmRegion {
+    std::atomic<uint32_t> sequence;
+    uint32_t id;
+    uint64_t frame;  // emulated frame number of the data
+    uint64_t offset; // from the start of the segment
+    uint64_t size;
+};
+
+struct ShmHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t region_count;
+    uint32_t header_size; // offset of the first ShmRegion
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "Seqlock needs an address free atomic");
+
+/**
+ * Reader side. Copies a consistent snapshot of a region into out (at least region.size bytes).
+ * Returns false if the writer kept it busy for all attempts.
+ */
+inline bool shm_read_region(const void* segment, const ShmRegion& region, void* out, uint64_t* frame = nullptr,
+                            int attempts = 100) {
+    const uint8_t* data = static_cast<const uint8_t*>(segment) + region.offset;
+    for (int i = 0; i < attempts; i++) {
+        uint32_t before = region.sequence.load(std::memory_order_acquire);
+        if (before & 1) continue;
+        std::memcpy(out, data, region.size);
+        if (frame) *frame = region.frame;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (region.sequence.load(std::memory_order_relaxed) == before) return true;
+    }
+    return false;
+}
+
+class Bus;
+class Cart;
+class PPU;
+
+/**
+ * Writer side, owned by the emulator. Creates the segment, throwing if the name is already taken, and unlinks it
+ * again on destruction.
+ */
+class SharedMemoryExport {
+    public:
+        SharedMemoryExport(const std::string& name, const Bus& bus, const PPU& ppu, const Cart& cart);
+        ~SharedMemoryExport();
+        SharedMemoryExport(const SharedMemoryExport&) = delete;
+        SharedMemoryExport& operator=(const SharedMemoryExport&) = delete;
+
+        // Emulation thread, once per finished frame
+        void publish(uint64_t frame);
+
+    private:
+        std::string name;
+        const Bus& bus;
+        const PPU& ppu;
+        const Cart& cart;
+
+        uint8_t* segment{nullptr};
+        size_t segment_size{0};
+        ShmRegion* regions{nullptr};
+
+        void write_region(ShmRegionId id, const uint8_t* src, uint64_t frame);
+};
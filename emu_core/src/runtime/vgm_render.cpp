@@ -0,0 +1,63 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <string_view>
+#include "audio/apu.hpp"
+#include "audio/vgm_player.hpp"
+#include "audio/wav_writer.hpp"
+
+// Options come after the two paths
+const char* get_option(int argc, char* argv[], std::string_view flag) {
+    for (int i = 3; i + 1 < argc; i++) {
+        if (flag == argv[i]) return argv[i + 1];
+    }
+    return nullptr;
+}
+
+/**
+ * Renders a VGM log (from --vgm, or any VGM with a Game Boy stream) to WAV with our APU, as fast as it goes.
+ * Handy for checking audio changes against a recording without running the game again.
+ */
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: ./VgmRender <in.vgm> <out.wav|out.raw> [--sample-rate HZ] [--resampler fast|medium|high]"
+                  << std::endl;
+        return 1;
+    }
+    const char* sample_rate = get_option(argc, argv, "--sample-rate");
+    int rate = sample_rate ? std::atoi(sample_rate) : AudioSink::DEFAULT_SAMPLE_RATE;
+    if (rate < 8000 || rate > 192000) {
+        std::cerr << "Unsupported sample rate " << rate << " (8000 - 192000)" << std::endl;
+        return 1;
+    }
+    ResamplerQuality quality = ResamplerQuality::MEDIUM;
+    if (const char* quality_name = get_option(argc, argv, "--resampler")) {
+        if (!Resampler::parse_quality(quality_name, quality)) {
+            std::cerr << "Unknown resampler quality " << quality_name << " (fast, medium, high)" << std::endl;
+            return 1;
+        }
+    }
+
+    try {
+        VgmPlayer player = VgmPlayer::load(argv[1]);
+        WavWriter wav(argv[2], rate);
+        APU apu(wav);
+        apu.set_resampler_quality(quality);
+        apu.init();
+
+        auto start = std::chrono::steady_clock::now();
+        player.render(apu);
+        apu.close();
+        wav.close();
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << std::format("{} writes, {:.1f} s of audio rendered in {:.0f} ms ({:.0f}x real time)",
+                                 player.writes().size(), player.seconds(), elapsed * 1000,
+                                 player.seconds() / elapsed) << std::endl;
+    } catch (const std::runtime_error& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -1 +1,2 @@
-./build/test/RunTests
\ No newline at end of file
+./build/test/RunTests
+ctest --test-dir build --output-on-failure
\ No newline at end of file
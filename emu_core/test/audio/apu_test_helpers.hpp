@@ -0,0 +1,82 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "audio/apu.hpp"
+
+// Keeps everything it gets. Only the audio thread writes while it runs, read after APU::close.
+class CaptureSink : public AudioSink {
+    public:
+        void play_samples(const int16_t* samples, int frames) override {
+            this->samples.insert(this->samples.end(), samples, samples + frames * 2);
+        }
+        std::vector<int16_t> samples;
+};
+
+/**
+ * Ticks an APU the way the CPU loop does, a few M cycles per instruction and DIV-APU every 2048. Never steps past
+ * the target, so a register write after run_until lands on exactly that cycle (what VgmPlayer does too).
+ */
+class ApuClock {
+    public:
+        static constexpr int DIV_APU_CYCLES = 2048;
+
+        explicit ApuClock(APU& apu) : apu(apu) {}
+
+        void run_until(uint64_t target) {
+            static constexpr uint64_t INSTRUCTION_CYCLES[8] = {1, 2, 1, 3, 2, 4, 1, 2};
+            while (cycle < target) {
+                int step = static_cast<int>(std::min({INSTRUCTION_CYCLES[instruction++ & 7], target - cycle,
+                                                      static_cast<uint64_t>(DIV_APU_CYCLES - div_phase)}));
+                apu.tick(step, false);
+                cycle += step;
+                div_phase += step;
+                if (div_phase == DIV_APU_CYCLES) {
+                    div_phase = 0;
+                    apu.tick(0, true);
+                }
+            }
+        }
+
+        uint64_t now() const { return cycle; }
+
+    private:
+        APU& apu;
+        uint64_t cycle{0};
+        int div_phase{0};
+        unsigned instruction{0};
+};
+
+/**
+ * The n-th set of notes of the test song: all four channels with length timers, sweep on two of three, new wave
+ * RAM each time. n = 0 sets up the mixer first, note 10 then powers the APU off and note 12 back on.
+ */
+inline void play_notes(APU& apu, int n) {
+    auto write = [&](uint16_t addr, uint8_t value) { apu.apu_io_write(addr, value); };
+    if (n == 0) {
+        write(0xFF24, 0x77);
+        write(0xFF25, 0xFF);
+    }
+    write(0xFF11, 0x80 | (n & 0x3F));
+    write(0xFF12, 0xF3);
+    write(0xFF10, (n % 3) ? 0x15 : 0x00);
+    write(0xFF13, static_cast<uint8_t>(0x40 + n * 13));
+    write(0xFF14, 0xC6);
+    write(0xFF16, 0x40);
+    write(0xFF17, 0xA1);
+    write(0xFF18, static_cast<uint8_t>(n * 29));
+    write(0xFF19, 0x87);
+    write(0xFF21, 0xF2);
+    write(0xFF22, static_cast<uint8_t>(n & 0x0F) | ((n & 1) << 3));
+    write(0xFF23, 0x80);
+    for (uint16_t addr = 0xFF30; addr <= 0xFF3F; addr++) write(addr, static_cast<uint8_t>(addr * n));
+    write(0xFF1A, 0x80);
+    write(0xFF1C, 0x20);
+    write(0xFF1E, 0x87);
+    if (n == 10) write(0xFF26, 0x00);
+    if (n == 12) {
+        write(0xFF26, 0x80);
+        write(0xFF24, 0x77);
+        write(0xFF25, 0xFF);
+    }
+}
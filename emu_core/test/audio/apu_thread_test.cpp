@@ -0,0 +1,86 @@
+#include <iostream>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+#include "audio/apu.hpp"
+#include "apu_test_helpers.hpp"
+
+/**
+ * Same register writes at the same cycles on both APUs, about a second of them. Returns the NR52 reads taken along
+ * the way, those come from the emulation side's own registers in threaded mode.
+ */
+std::vector<uint8_t> play_script(APU& apu) {
+    std::vector<uint8_t> status;
+    ApuClock clock(apu);
+    for (int n = 0; n < 20; n++) {
+        play_notes(apu, n);
+        for (int i = 0; i < 50; i++) {
+            status.push_back(apu.apu_io_read(0xFF26));
+            clock.run_until(clock.now() + 1000);
+        }
+    }
+    return status;
+}
+
+void test_threaded_matches_inline() {
+    CaptureSink inline_sink;
+    APU inline_apu(inline_sink);
+    inline_apu.init();
+    std::vector<uint8_t> inline_status = play_script(inline_apu);
+    inline_apu.close();
+
+    CaptureSink threaded_sink;
+    APU threaded_apu(threaded_sink);
+    threaded_apu.set_threaded(true);
+    threaded_apu.init();
+    std::vector<uint8_t> threaded_status = play_script(threaded_apu);
+    threaded_apu.close();
+
+    assert(inline_status == threaded_status);
+    // Blocks get cut in different places, the samples don't change
+    assert(!inline_sink.samples.empty());
+    assert(inline_sink.samples == threaded_sink.samples);
+}
+
+// A save state loaded mid song: the audio thread has to switch to it at the same cycle the inline APU does
+void test_load_state() {
+    NullAudioSink null_sink;
+    APU source(null_sink);
+    source.init();
+    play_script(source);
+    StateWriter state;
+    source.serialize(state);
+
+    auto play_and_load = [&](APU& apu) {
+        apu.init();
+        apu.apu_io_write(0xFF12, 0xF0);
+        apu.apu_io_write(0xFF14, 0x80);
+        for (int i = 0; i < 3000; i++) apu.tick(7, false);
+        StateReader reader(state.data());
+        apu.deserialize(reader);
+        for (int i = 0; i < 30000; i++) apu.tick(7, i % 290 == 0);
+        apu.close();
+    };
+    CaptureSink inline_sink;
+    APU inline_apu(inline_sink);
+    play_and_load(inline_apu);
+    CaptureSink threaded_sink;
+    APU threaded_apu(threaded_sink);
+    threaded_apu.set_threaded(true);
+    play_and_load(threaded_apu);
+
+    assert(!inline_sink.samples.empty());
+    assert(inline_sink.samples == threaded_sink.samples);
+}
+
+int main() {
+    std::cout << "----------------Running APU Thread Tests----------------" << std::endl;
+
+    std::cout << "* test_threaded_matches_inline" << std::endl;
+    test_threaded_matches_inline();
+
+    std::cout << "* test_load_state" << std::endl;
+    test_load_state();
+
+    return 0;
+}
@@ -0,0 +1,61 @@
+#include <iostream>
+#include <cassert>
+#include <cstdlib>
+#include <vector>
+#include "blip_buffer.hpp"
+
+static constexpr double CLOCK_RATE = 1048576.0;
+static constexpr double SAMPLE_RATE = 48000.0;
+
+void test_sample_count_matches_time() {
+    BlipBuffer blip(CLOCK_RATE, SAMPLE_RATE, 1024);
+    std::vector<int16_t> out(1024);
+    int total = 0;
+    long long clocks = 0;
+    // About one emulated second in frames that don't line up with samples
+    while (clocks < CLOCK_RATE) {
+        blip.end_frame(1500);
+        clocks += 1500;
+        total += blip.read_samples(out.data(), 1024);
+    }
+    int expected = static_cast<int>(clocks * SAMPLE_RATE / CLOCK_RATE);
+    assert(std::abs(total - expected) <= 1);
+}
+
+void test_step_reaches_delta() {
+    BlipBuffer blip(CLOCK_RATE, SAMPLE_RATE, 1024);
+    blip.add_delta(100, 10000);
+    blip.end_frame(2000);
+    std::vector<int16_t> out(1024);
+    int count = blip.read_samples(out.data(), 1024);
+    assert(count == 91);
+
+    // Silent before the step (100 clocks is ~4.6 samples), then it settles near the delta and the DC blocker
+    // slowly pulls it back
+    assert(out[0] == 0 && out[1] == 0);
+    int peak = 0;
+    for (int i = 0; i < count; i++) peak = std::max(peak, static_cast<int>(out[i]));
+    assert(peak > 9500 && peak < 12000); // band limited steps ring a little (Gibbs)
+    assert(out[40] > 8000 && out[40] < 10500);
+}
+
+void test_stereo_stride() {
+    BlipBuffer blip(CLOCK_RATE, SAMPLE_RATE, 1024);
+    blip.add_delta(0, 5000);
+    blip.end_frame(1000);
+    std::vector<int16_t> out(200, -1);
+    int count = blip.read_samples(out.data(), 100, 2);
+    for (int i = 0; i < count; i++) assert(out[i * 2 + 1] == -1);
+    assert(out[(count - 1) * 2] > 4000);
+}
+
+int main() {
+    std::cout << "----------------Running Blip Buffer Tests----------------" << std::endl;
+    std::cout << "* test_sample_count_matches_time" << std::endl;
+    test_sample_count_matches_time();
+    std::cout << "* test_step_reaches_delta" << std::endl;
+    test_step_reaches_delta();
+    std::cout << "* test_stereo_stride" << std::endl;
+    test_stereo_stride();
+    return 0;
+}
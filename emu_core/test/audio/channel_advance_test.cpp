@@ -0,0 +1,152 @@
+#include <iostream>
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "audio/noise_channel.hpp"
+#include "audio/square_channel.hpp"
+#include "audio/wave_channel.hpp"
+
+/**
+ * The channels run their period dividers a span at a time (advance(n)), the APU skips ahead by cycles_to_step().
+ * Both have to match the hardware's one M cycle at a time: every test keeps a copy that only ever gets advance(1)
+ * and compares the whole channel state (its save state bytes) after each span.
+ */
+template <typename Channel>
+std::vector<uint8_t> state_of(const Channel& channel) {
+    StateWriter out;
+    channel.serialize(out);
+    return out.data();
+}
+
+template <typename Channel>
+void advance_both(Channel& bulk, Channel& single, int cycles) {
+    bulk.advance(cycles);
+    for (int i = 0; i < cycles; i++) single.advance(1);
+    assert(state_of(bulk) == state_of(single));
+    assert(bulk.sample() == single.sample());
+}
+
+// The output can't change before cycles_to_step() single cycles have gone by (slow noise skips millions, the
+// first few thousand are enough)
+template <typename Channel>
+void check_cycles_to_step(Channel channel) {
+    int until = channel.cycles_to_step();
+    assert(until >= 1);
+    int16_t before = channel.sample();
+    for (int i = 1; i < std::min(until, 5000); i++) {
+        channel.advance(1);
+        assert(channel.sample() == before);
+    }
+}
+
+// The divider on its own against the loop it replaces, including periods below 1 and counters past the period
+void test_divider() {
+    std::mt19937 rng(1);
+    for (int i = 0; i < 20000; i++) {
+        int period = static_cast<int>(rng() % 2100) - 8;
+        uint16_t div = static_cast<uint16_t>(rng() % 2200);
+        int cycles = static_cast<int>(rng() % 5000);
+
+        uint16_t expected_div = div;
+        int expected_steps = 0;
+        int to_overflow = 0;
+        for (int c = 0; c < cycles; c++) {
+            expected_div++;
+            if (expected_div >= period) {
+                expected_div = 0;
+                expected_steps++;
+                if (to_overflow == 0) to_overflow = c + 1;
+            }
+        }
+        if (to_overflow != 0) assert(cycles_to_overflow(div, period) == to_overflow);
+        assert(advance_divider(div, period, cycles) == expected_steps);
+        assert(div == expected_div);
+    }
+}
+
+void test_square() {
+    std::mt19937 rng(2);
+    for (int note = 0; note < 300; note++) {
+        SquareChannel bulk;
+        bulk.write_nrx1(static_cast<uint8_t>(rng()));            // duty and length
+        bulk.write_nrx2(0xF0 | (rng() & 0x0F));
+        bulk.write_nrx3(static_cast<uint8_t>(rng()));
+        bulk.write_nrx4(0x80 | (rng() & 0x07));
+        SquareChannel single = bulk;
+        for (int span = 0; span < 40; span++) {
+            check_cycles_to_step(bulk);
+            advance_both(bulk, single, static_cast<int>(rng() % 3000));
+            // A new period mid note, it can end up below the running counter
+            if (rng() % 4 == 0) {
+                uint8_t low = static_cast<uint8_t>(rng());
+                bulk.write_nrx3(low);
+                single.write_nrx3(low);
+            }
+        }
+    }
+}
+
+void test_wave() {
+    std::mt19937 rng(3);
+    for (int note = 0; note < 300; note++) {
+        WaveChannel bulk;
+        for (uint16_t addr = 0xFF30; addr <= 0xFF3F; addr++) bulk.write_WRAM(addr, static_cast<uint8_t>(rng()));
+        bulk.write_nr30(0x80);
+        bulk.write_nr32(0x20);
+        bulk.write_nr33(static_cast<uint8_t>(rng()));
+        bulk.write_nr34(0x80 | (rng() & 0x07));
+        WaveChannel single = bulk;
+        for (int span = 0; span < 40; span++) {
+            check_cycles_to_step(bulk);
+            advance_both(bulk, single, static_cast<int>(rng() % 3000));
+            if (rng() % 4 == 0) {
+                uint8_t low = static_cast<uint8_t>(rng());
+                bulk.write_nr33(low);
+                single.write_nr33(low);
+            }
+        }
+    }
+}
+
+void test_noise() {
+    std::mt19937 rng(4);
+    for (int note = 0; note < 300; note++) {
+        NoiseChannel bulk;
+        bulk.write_nr42(0xF0);
+        // Clock shifts past 13 stop the LFSR, keep most notes below that
+        uint8_t nr43 = static_cast<uint8_t>(rng() % 4 == 0 ? rng() : (rng() & 0x9F));
+        bulk.write_nr43(nr43);
+        bulk.write_nr44(0x80);
+        NoiseChannel single = bulk;
+        for (int span = 0; span < 40; span++) {
+            check_cycles_to_step(bulk);
+            advance_both(bulk, single, static_cast<int>(rng() % 3000));
+            // Width and rate switches mid sequence
+            if (rng() % 4 == 0) {
+                nr43 = static_cast<uint8_t>(rng() & 0x9F);
+                bulk.write_nr43(nr43);
+                single.write_nr43(nr43);
+            }
+        }
+    }
+}
+
+int main() {
+    std::cout << "----------------Running Channel Advance Tests----------------" << std::endl;
+
+    std::cout << "* test_divider" << std::endl;
+    test_divider();
+
+    std::cout << "* test_square" << std::endl;
+    test_square();
+
+    std::cout << "* test_wave" << std::endl;
+    test_wave();
+
+    std::cout << "* test_noise" << std::endl;
+    test_noise();
+
+    return 0;
+}
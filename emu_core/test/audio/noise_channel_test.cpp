@@ -0,0 +1,79 @@
+#include <iostream>
+#include <cassert>
+#include <cstdint>
+#include "noise_channel.hpp"
+
+// Full volume, DAC on, then trigger
+void start(NoiseChannel& channel, uint8_t nr43) {
+    channel.write_nr42(0xF0);
+    channel.write_nr43(nr43);
+    channel.write_nr44(0x80);
+}
+
+void test_bulk_matches_single_steps(uint8_t nr43) {
+    NoiseChannel single;
+    NoiseChannel bulk;
+    start(single, nr43);
+    start(bulk, nr43);
+
+    // Chunks that don't line up with the divider, big enough to wrap the 7 bit sequence many times
+    for (int chunk = 1; chunk < 400; chunk++) {
+        int cycles = chunk * 37;
+        for (int i = 0; i < cycles; i++) single.advance(1);
+        bulk.advance(cycles);
+        assert(single.sample() == bulk.sample());
+    }
+}
+
+void test_width_switch_mid_sequence() {
+    NoiseChannel single;
+    NoiseChannel bulk;
+    start(single, 0x00);
+    start(bulk, 0x00);
+
+    uint8_t widths[] = {0x08, 0x00, 0x08, 0x08, 0x00};
+    for (uint8_t nr43 : widths) {
+        single.write_nr43(nr43);
+        bulk.write_nr43(nr43);
+        for (int i = 0; i < 5000; i++) single.advance(1);
+        bulk.advance(5000);
+        assert(single.sample() == bulk.sample());
+    }
+}
+
+void test_output_holds_until_next_step() {
+    NoiseChannel channel;
+    NoiseChannel reference;
+    start(channel, 0x01);
+    start(reference, 0x01);
+
+    for (int event = 0; event < 2000; event++) {
+        int span = channel.cycles_to_step();
+        int16_t level = channel.sample();
+        for (int i = 0; i < span - 1; i++) {
+            reference.advance(1);
+            assert(reference.sample() == level);
+        }
+        reference.advance(1);
+        channel.advance(span);
+        assert(reference.sample() == channel.sample());
+    }
+}
+
+int main() {
+    std::cout << "----------------Running Noise Channel Tests----------------" << std::endl;
+
+    std::cout << "* test_bulk_matches_single_steps (15 bit)" << std::endl;
+    test_bulk_matches_single_steps(0x00);
+
+    std::cout << "* test_bulk_matches_single_steps (7 bit)" << std::endl;
+    test_bulk_matches_single_steps(0x08);
+
+    std::cout << "* test_width_switch_mid_sequence" << std::endl;
+    test_width_switch_mid_sequence();
+
+    std::cout << "* test_output_holds_until_next_step" << std::endl;
+    test_output_holds_until_next_step();
+
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include "audio/rate_control.hpp"
+
+static constexpr double NOMINAL = 48000.0;
+static constexpr int TARGET = 4096;
+
+bool near(double a, double b) {
+    return std::abs(a - b) < 1e-9;
+}
+
+void test_ratio_follows_fill() {
+    RateControl control(NOMINAL);
+    // At the target the rate is left alone
+    assert(near(control.update(512, TARGET, TARGET, 0), NOMINAL));
+    assert(near(control.ratio(), 1.0));
+
+    // Empty ring: as many samples as allowed, twice the target: as few
+    assert(near(control.update(512, 0, TARGET, 0), NOMINAL * (1.0 + RateControl::MAX_DELTA)));
+    assert(near(control.update(512, 2 * TARGET, TARGET, 0), NOMINAL * (1.0 - RateControl::MAX_DELTA)));
+
+    // Linear in between, and the fuller the ring the lower the rate
+    assert(near(control.update(512, TARGET / 2, TARGET, 0), NOMINAL * (1.0 + RateControl::MAX_DELTA / 2)));
+    double last = 2.0;
+    for (int fill = 0; fill <= 2 * TARGET; fill += 64) {
+        control.update(512, fill, TARGET, 0);
+        assert(control.ratio() < last);
+        last = control.ratio();
+    }
+}
+
+void test_ratio_is_clamped() {
+    RateControl control(NOMINAL);
+    control.update(512, 100 * TARGET, TARGET, 0);
+    assert(near(control.ratio(), 1.0 - RateControl::MAX_DELTA));
+    control.update(512, -TARGET, TARGET, 0);
+    assert(near(control.ratio(), 1.0 + RateControl::MAX_DELTA));
+}
+
+void test_nominal_rate_change() {
+    RateControl control(NOMINAL);
+    control.set_nominal_rate(44100.0);
+    assert(near(control.update(512, TARGET, TARGET, 0), 44100.0));
+    assert(near(control.update(512, 0, TARGET, 0), 44100.0 * (1.0 + RateControl::MAX_DELTA)));
+}
+
+// Stats windows roll over every second of output, the ratio keeps going through them
+void test_many_windows() {
+    RateControl control(NOMINAL);
+    for (int block = 0; block < 1000; block++) {
+        int fill = TARGET + (block % 50 - 25) * 16;
+        double rate = control.update(512, fill, TARGET, block / 100);
+        assert(rate >= NOMINAL * (1.0 - RateControl::MAX_DELTA) && rate <= NOMINAL * (1.0 + RateControl::MAX_DELTA));
+    }
+}
+
+int main() {
+    std::cout << "----------------Running Rate Control Tests----------------" << std::endl;
+
+    std::cout << "* test_ratio_follows_fill" << std::endl;
+    test_ratio_follows_fill();
+
+    std::cout << "* test_ratio_is_clamped" << std::endl;
+    test_ratio_is_clamped();
+
+    std::cout << "* test_nominal_rate_change" << std::endl;
+    test_nominal_rate_change();
+
+    std::cout << "* test_many_windows" << std::endl;
+    test_many_windows();
+
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <numbers>
+#include <vector>
+#include "audio/resampler.hpp"
+
+static constexpr double INPUT_RATE = 65536.0;
+static constexpr int BLOCK_FRAMES = 128;
+
+// RMS of the left output for a full scale-ish sine, skipping the start while the filter fills up
+double resampled_rms(ResamplerQuality quality, ResamplerIsa isa, double freq, double output_rate) {
+    Resampler resampler(INPUT_RATE, output_rate, quality, isa);
+    std::vector<int16_t> in(BLOCK_FRAMES * 2);
+    std::vector<int16_t> out;
+    double sum = 0;
+    long count = 0;
+    long t = 0;
+    for (int block = 0; block < 512; block++) {
+        for (int i = 0; i < BLOCK_FRAMES; i++, t++) {
+            auto v = static_cast<int16_t>(std::lround(10000 * std::sin(2 * std::numbers::pi * freq * t / INPUT_RATE)));
+            in[i * 2] = v;
+            in[i * 2 + 1] = v;
+        }
+        int frames = resampler.process(in.data(), BLOCK_FRAMES, out);
+        if (block < 8) continue;
+        for (int i = 0; i < frames; i++) sum += static_cast<double>(out[i * 2]) * out[i * 2];
+        count += frames;
+    }
+    return std::sqrt(sum / count);
+}
+
+void test_output_count_follows_ratio() {
+    for (double rate : {44100.0, 48000.0, 96000.0}) {
+        Resampler resampler(INPUT_RATE, rate);
+        std::vector<int16_t> in(BLOCK_FRAMES * 2, 0);
+        std::vector<int16_t> out;
+        long total = 0;
+        for (int block = 0; block < INPUT_RATE / BLOCK_FRAMES; block++) {
+            total += resampler.process(in.data(), BLOCK_FRAMES, out);
+        }
+        // One second in, one second out, minus the filter's delay
+        assert(std::abs(total - static_cast<long>(rate)) <= resampler.taps() * rate / INPUT_RATE + 1);
+    }
+}
+
+void test_passband_keeps_level() {
+    for (ResamplerQuality quality : {ResamplerQuality::FAST, ResamplerQuality::MEDIUM, ResamplerQuality::HIGH}) {
+        double rms = resampled_rms(quality, Resampler::best_isa(), 1000, 44100);
+        assert(std::abs(rms - 10000 / std::numbers::sqrt2) < 70); // within 1%
+    }
+}
+
+void test_stopband_rejects_aliases() {
+    // 30 kHz is above 44.1 kHz's Nyquist, whatever comes through folds back as an alias
+    assert(resampled_rms(ResamplerQuality::HIGH, Resampler::best_isa(), 30000, 44100) < 10);
+    assert(resampled_rms(ResamplerQuality::MEDIUM, Resampler::best_isa(), 30000, 44100) < 100);
+}
+
+void test_isas_agree() {
+    std::vector<int16_t> in(BLOCK_FRAMES * 2);
+    for (int i = 0; i < BLOCK_FRAMES * 2; i++) in[i] = static_cast<int16_t>((i * 7919) % 20000 - 10000);
+
+    for (ResamplerQuality quality : {ResamplerQuality::FAST, ResamplerQuality::MEDIUM, ResamplerQuality::HIGH}) {
+        Resampler reference(INPUT_RATE, 44100, quality, ResamplerIsa::SCALAR);
+        std::vector<int16_t> expected;
+        for (ResamplerIsa isa : Resampler::supported_isas()) {
+            Resampler resampler(INPUT_RATE, 44100, quality, isa);
+            reference.clear();
+            std::vector<int16_t> out;
+            for (int block = 0; block < 20; block++) {
+                int frames = reference.process(in.data(), BLOCK_FRAMES, expected);
+                assert(resampler.process(in.data(), BLOCK_FRAMES, out) == frames);
+                // Sums run in a different order, allow a rounding step
+                for (int i = 0; i < frames * 2; i++) assert(std::abs(out[i] - expected[i]) <= 1);
+            }
+        }
+    }
+}
+
+int main() {
+    std::cout << "----------------Running Resampler Tests----------------" << std::endl;
+
+    std::cout << "* test_output_count_follows_ratio" << std::endl;
+    test_output_count_follows_ratio();
+
+    std::cout << "* test_passband_keeps_level" << std::endl;
+    test_passband_keeps_level();
+
+    std::cout << "* test_stopband_rejects_aliases" << std::endl;
+    test_stopband_rejects_aliases();
+
+    std::cout << "* test_isas_agree" << std::endl;
+    test_isas_agree();
+
+    return 0;
+}
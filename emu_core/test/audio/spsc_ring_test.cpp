@@ -0,0 +1,64 @@
+#include <iostream>
+#include <cassert>
+#include <thread>
+#include <vector>
+#include "spsc_ring.hpp"
+
+void test_capacity_rounds_up() {
+    SpscRing<int> ring(1000);
+    assert(ring.capacity() == 1024);
+}
+
+void test_write_read_wraps() {
+    SpscRing<int> ring(8);
+    int in[6] = {1, 2, 3, 4, 5, 6};
+    int out[8] = {};
+    assert(ring.write(in, 6) == 6);
+    assert(ring.read(out, 4) == 4);
+    assert(out[0] == 1 && out[3] == 4);
+
+    // Wraps around the end of storage
+    assert(ring.write(in, 6) == 6);
+    assert(ring.size() == 8);
+    assert(ring.write(in, 1) == 0); // full
+    assert(ring.read(out, 8) == 8);
+    assert(out[0] == 5 && out[1] == 6 && out[2] == 1 && out[7] == 6);
+    assert(ring.read(out, 1) == 0); // empty
+}
+
+void test_threaded_blocks_in_order() {
+    SpscRing<int> ring(256);
+    constexpr int ITEMS = 1000000;
+
+    std::thread producer([&] {
+        std::vector<int> block(37);
+        int next = 0;
+        while (next < ITEMS) {
+            int count = std::min<int>(block.size(), ITEMS - next);
+            for (int i = 0; i < count; i++) block[i] = next + i;
+            int written = 0;
+            while (written < count) written += ring.write(block.data() + written, count - written);
+            next += count;
+        }
+    });
+
+    // Everything arrives exactly once and in order
+    std::vector<int> block(53);
+    int expected = 0;
+    while (expected < ITEMS) {
+        int read = ring.read(block.data(), block.size());
+        for (int i = 0; i < read; i++) assert(block[i] == expected++);
+    }
+    producer.join();
+}
+
+int main() {
+    std::cout << "----------------Running SPSC Ring Tests----------------" << std::endl;
+    std::cout << "* test_capacity_rounds_up" << std::endl;
+    test_capacity_rounds_up();
+    std::cout << "* test_write_read_wraps" << std::endl;
+    test_write_read_wraps();
+    std::cout << "* test_threaded_blocks_in_order" << std::endl;
+    test_threaded_blocks_in_order();
+    return 0;
+}
@@ -0,0 +1,149 @@
+#include <iostream>
+#include <cassert>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "audio/apu.hpp"
+#include "audio/vgm_player.hpp"
+#include "audio/vgm_writer.hpp"
+#include "apu_test_helpers.hpp"
+#include "../core/file_test_helpers.hpp"
+
+// One second of M cycles is exactly 44100 samples
+uint64_t samples_to_cycles(uint64_t samples) {
+    return (samples * vgm::M_CYCLES_PER_SECOND + vgm::SAMPLE_RATE - 1) / vgm::SAMPLE_RATE;
+}
+
+void test_header_and_waits() {
+    const std::string path = "vgm_writer_test_header.vgm";
+    {
+        VgmWriter writer(path);
+        writer.write(0, 0xFF26, 0x80);
+        writer.write(samples_to_cycles(5), 0xFF12, 0xF0);   // 0x74
+        writer.write(samples_to_cycles(740), 0xFF30, 0x12); // 0x62
+        writer.write(samples_to_cycles(740), 0xFF04, 0x00); // not a sound register, dropped
+        writer.write(samples_to_cycles(71000), 0xFF14, 0x87); // 0x61
+        writer.close(vgm::M_CYCLES_PER_SECOND * 2);
+        assert(writer.writes() == 4);
+        assert(writer.samples() == 88200);
+    }
+
+    std::vector<uint8_t> file = read_file(path);
+    assert(file.size() > vgm::HEADER_SIZE);
+    assert(std::string(file.begin(), file.begin() + 4) == "Vgm ");
+    assert(get_le32(file, vgm::OFFSET_EOF) == file.size() - vgm::OFFSET_EOF);
+    assert(get_le32(file, vgm::OFFSET_VERSION) == vgm::VERSION);
+    assert(get_le32(file, vgm::OFFSET_TOTAL_SAMPLES) == 88200);
+    assert(get_le32(file, vgm::OFFSET_DMG_CLOCK) == vgm::DMG_CLOCK);
+    assert(vgm::OFFSET_DATA + get_le32(file, vgm::OFFSET_DATA) == vgm::HEADER_SIZE);
+
+    const std::vector<uint8_t> expected = {
+        0xB3, 0x16, 0x80,
+        0x74, 0xB3, 0x02, 0xF0,                   // 5 samples
+        0x62, 0xB3, 0x20, 0x12,                   // 735
+        0x61, 0xFF, 0xFF, 0x61, 0x75, 0x12,       // 70260, longer than one wait
+        0xB3, 0x04, 0x87,
+        0x61, 0x30, 0x43,                         // 17200
+        0x66,
+    };
+    assert(std::vector<uint8_t>(file.begin() + vgm::HEADER_SIZE, file.end()) == expected);
+
+    VgmPlayer player(file);
+    assert(player.total_samples() == 88200);
+    assert(player.writes().size() == 4);
+    assert(player.writes()[1].sample == 5 && player.writes()[1].addr == 0xFF12 && player.writes()[1].value == 0xF0);
+    assert(player.writes()[3].sample == 71000 && player.writes()[3].addr == 0xFF14);
+    std::remove(path.c_str());
+}
+
+void test_rejects_other_files() {
+    std::vector<uint8_t> not_vgm(0x100, 0);
+    bool threw = false;
+    try { VgmPlayer player(not_vgm); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+}
+
+// Logs from other chips carry PCM RAM writes and DAC stream commands, they're skipped by their operand sizes
+void test_skips_other_chips() {
+    const std::string path = "vgm_writer_test_skips.vgm";
+    {
+        VgmWriter writer(path);
+        writer.write(0, 0xFF26, 0x80);
+        writer.close(0);
+    }
+    std::vector<uint8_t> file = read_file(path);
+    std::remove(path.c_str());
+
+    const std::vector<uint8_t> other_chips = {
+        0x68, 0x66, 0x00, 0, 0, 0, 0, 0, 0, 0x04, 0, 0, // PCM RAM write
+        0x90, 0x00, 0x02, 0x00, 0x2A,                   // DAC stream setup
+        0x91, 0x00, 0x00, 0x01, 0x00,                   // set data
+        0x92, 0x00, 0x44, 0xAC, 0x00, 0x00,             // set frequency
+        0x93, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x10, 0x00, 0x00, 0x00, // start
+        0x94, 0x00,                                     // stop
+        0x95, 0x00, 0x00, 0x00, 0x00,                   // start fast
+        0x63,
+        0xB3, 0x02, 0xF0,
+    };
+    file.insert(file.begin() + vgm::HEADER_SIZE + 3, other_chips.begin(), other_chips.end());
+
+    VgmPlayer player(file);
+    assert(player.writes().size() == 2);
+    assert(player.writes()[1].sample == 882 && player.writes()[1].addr == 0xFF12 && player.writes()[1].value == 0xF0);
+}
+
+// Notes on the first cycle of a sample, VgmPlayer has to put them on the same cycles
+void record(APU& apu) {
+    ApuClock clock(apu);
+    for (int n = 0; n < 20; n++) {
+        clock.run_until(samples_to_cycles(n * 2205 + (n * 37) % 100));
+        play_notes(apu, n);
+    }
+    clock.run_until(vgm::M_CYCLES_PER_SECOND);
+}
+
+void test_round_trip() {
+    const std::string path = "vgm_writer_test_round_trip.vgm";
+    CaptureSink recorded;
+    {
+        VgmWriter writer(path);
+        APU apu(recorded);
+        apu.init();
+        apu.set_register_log(&writer);
+        record(apu);
+        apu.close();
+    }
+
+    VgmPlayer player = VgmPlayer::load(path);
+    assert(player.total_samples() == vgm::SAMPLE_RATE);
+    CaptureSink rendered;
+    APU apu(rendered);
+    apu.init();
+    player.render(apu);
+    apu.close();
+
+    assert(std::any_of(recorded.samples.begin(), recorded.samples.end(), [](int16_t s) { return s != 0; }));
+    assert(recorded.samples.size() == rendered.samples.size());
+    for (size_t i = 0; i < recorded.samples.size(); i++) assert(recorded.samples[i] == rendered.samples[i]);
+    std::remove(path.c_str());
+}
+
+int main() {
+    std::cout << "----------------Running VGM Tests----------------" << std::endl;
+
+    std::cout << "* test_header_and_waits" << std::endl;
+    test_header_and_waits();
+
+    std::cout << "* test_rejects_other_files" << std::endl;
+    test_rejects_other_files();
+
+    std::cout << "* test_skips_other_chips" << std::endl;
+    test_skips_other_chips();
+
+    std::cout << "* test_round_trip" << std::endl;
+    test_round_trip();
+
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include <iostream>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "audio/wav_writer.hpp"
+#include "../core/file_test_helpers.hpp"
+
+static constexpr size_t HEADER_SIZE = 44;
+
+uint16_t get_le16(const std::vector<uint8_t>& data, size_t offset) {
+    return static_cast<uint16_t>(data[offset] | (data[offset + 1] << 8));
+}
+
+// A block of stereo frames with both channels different, written a few times so the writer thread gets several
+std::vector<int16_t> make_block(int frames) {
+    std::vector<int16_t> samples(frames * 2);
+    for (int i = 0; i < frames; i++) {
+        samples[i * 2] = static_cast<int16_t>(i * 37 - 9000);
+        samples[i * 2 + 1] = static_cast<int16_t>(-i * 53 + 7000);
+    }
+    return samples;
+}
+
+std::vector<int16_t> write_blocks(const std::string& path, int rate, const std::vector<int16_t>& block, int count) {
+    std::vector<int16_t> expected;
+    WavWriter writer(path, rate);
+    for (int i = 0; i < count; i++) {
+        writer.play_samples(block.data(), static_cast<int>(block.size() / 2));
+        expected.insert(expected.end(), block.begin(), block.end());
+    }
+    writer.close();
+    assert(writer.frames_written() == expected.size() / 2);
+    return expected;
+}
+
+std::vector<int16_t> samples_at(const std::vector<uint8_t>& file, size_t offset) {
+    std::vector<int16_t> samples((file.size() - offset) / 2);
+    for (size_t i = 0; i < samples.size(); i++) samples[i] = static_cast<int16_t>(get_le16(file, offset + i * 2));
+    return samples;
+}
+
+// The sizes are 0 until close() patches them
+void test_wav_header() {
+    const std::string path = "wav_writer_test.wav";
+    std::vector<int16_t> expected = write_blocks(path, 44100, make_block(735), 10);
+    const uint32_t data_bytes = static_cast<uint32_t>(expected.size() * 2);
+
+    std::vector<uint8_t> file = read_file(path);
+    assert(file.size() == HEADER_SIZE + data_bytes);
+    assert(std::string(file.begin(), file.begin() + 4) == "RIFF");
+    assert(get_le32(file, 4) == 36 + data_bytes);
+    assert(std::string(file.begin() + 8, file.begin() + 16) == "WAVEfmt ");
+    assert(get_le32(file, 16) == 16);
+    assert(get_le16(file, 20) == 1);          // PCM
+    assert(get_le16(file, 22) == 2);          // stereo
+    assert(get_le32(file, 24) == 44100);
+    assert(get_le32(file, 28) == 44100 * 4);  // byte rate
+    assert(get_le16(file, 32) == 4);          // block align
+    assert(get_le16(file, 34) == 16);
+    assert(std::string(file.begin() + 36, file.begin() + 40) == "data");
+    assert(get_le32(file, 40) == data_bytes);
+    assert(samples_at(file, HEADER_SIZE) == expected);
+    std::remove(path.c_str());
+}
+
+void test_raw_has_no_header() {
+    const std::string path = "wav_writer_test.raw";
+    std::vector<int16_t> expected = write_blocks(path, 48000, make_block(800), 10);
+    std::vector<uint8_t> file = read_file(path);
+    assert(file.size() == expected.size() * 2);
+    assert(samples_at(file, 0) == expected);
+    std::remove(path.c_str());
+}
+
+// Nothing played: a valid WAV with an empty data chunk
+void test_empty() {
+    const std::string path = "wav_writer_test_empty.wav";
+    write_blocks(path, 48000, {}, 0);
+    std::vector<uint8_t> file = read_file(path);
+    assert(file.size() == HEADER_SIZE);
+    assert(get_le32(file, 4) == 36);
+    assert(get_le32(file, 40) == 0);
+    std::remove(path.c_str());
+}
+
+void test_unwritable_path() {
+    bool threw = false;
+    try {
+        WavWriter writer("no_such_directory/out.wav", 48000);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+int main() {
+    std::cout << "----------------Running WAV Writer Tests----------------" << std::endl;
+
+    std::cout << "* test_wav_header" << std::endl;
+    test_wav_header();
+
+    std::cout << "* test_raw_has_no_header" << std::endl;
+    test_raw_has_no_header();
+
+    std::cout << "* test_empty" << std::endl;
+    test_empty();
+
+    std::cout << "* test_unwritable_path" << std::endl;
+    test_unwritable_path();
+
+    return 0;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+// Files the tests write fixtures to and read results back from
+inline void write_file(const std::filesystem::path& path, const std::vector<uint8_t>& data) {
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+}
+
+inline std::vector<uint8_t> read_file(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::vector<uint8_t>((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+inline uint32_t get_le32(const std::vector<uint8_t>& data, size_t offset) {
+    return data[offset] | (data[offset + 1] << 8) | (data[offset + 2] << 16) |
+           (static_cast<uint32_t>(data[offset + 3]) << 24);
+}
@@ -0,0 +1,80 @@
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "mapped_file.hpp"
+#include "cart.hpp"
+#include "file_test_helpers.hpp"
+
+void test_maps_file() {
+    const std::string path = "mapped_file_test.bin";
+    std::vector<uint8_t> data(10000);
+    for (size_t i = 0; i < data.size(); i++) data[i] = static_cast<uint8_t>(i * 7);
+    write_file(path, data);
+
+    MappedFile file(path);
+    assert(file.size() == data.size());
+    assert(std::equal(data.begin(), data.end(), file.bytes().begin()));
+
+    MappedFile moved(std::move(file));
+    assert(file.size() == 0 && file.bytes().empty());
+    assert(moved.bytes()[9999] == data[9999]);
+
+    MappedFile assigned;
+    assigned = std::move(moved);
+    assert(moved.size() == 0);
+    assert(assigned.bytes()[1234] == data[1234]);
+    std::remove(path.c_str());
+}
+
+void test_errors() {
+    bool threw = false;
+    try { MappedFile missing("does_not_exist.gb"); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+
+    const std::string path = "mapped_file_test_empty.bin";
+    write_file(path, {});
+    threw = false;
+    try { MappedFile empty(path); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+    std::remove(path.c_str());
+}
+
+// 64 KB MBC1 ROM, every bank starts with its number
+void test_cart_reads_mapped_rom() {
+    const std::string path = "mapped_file_test.gb";
+    std::vector<uint8_t> rom(0x10000, 0);
+    for (int bank = 0; bank < 4; bank++) rom[bank * 0x4000] = static_cast<uint8_t>(0xB0 + bank);
+    rom[0x0147] = 0x01; // MBC1
+    rom[0x0148] = 0x01; // 64 KB
+    write_file(path, rom);
+
+    Cart cart;
+    cart.loadFromFile(path);
+    assert(cart.cart_loaded);
+    assert(cart.read(0x0000) == 0xB0);
+    cart.write(0x2000, 0x03);
+    assert(cart.read(0x4000) == 0xB3);
+
+    Cart moved = std::move(cart); // the mapping moves with it
+    moved.write(0x2000, 0x02);
+    assert(moved.read(0x4000) == 0xB2);
+    std::remove(path.c_str());
+}
+
+int main() {
+    std::cout << "----------------Running Mapped File Tests----------------" << std::endl;
+
+    std::cout << "* test_maps_file" << std::endl;
+    test_maps_file();
+
+    std::cout << "* test_errors" << std::endl;
+    test_errors();
+
+    std::cout << "* test_cart_reads_mapped_rom" << std::endl;
+    test_cart_reads_mapped_rom();
+
+    return 0;
+}
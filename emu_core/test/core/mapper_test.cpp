@@ -0,0 +1,284 @@
+#include <iostream>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+#include "mapper.hpp"
+
+// Every ROM bank starts with its number (low byte) and ends with its high byte
+std::vector<uint8_t> make_rom(size_t banks) {
+    std::vector<uint8_t> rom(banks * Mapper::ROM_BANK_SIZE, 0);
+    for (size_t bank = 0; bank < banks; bank++) {
+        rom[bank * Mapper::ROM_BANK_SIZE] = static_cast<uint8_t>(bank);
+        rom[(bank + 1) * Mapper::ROM_BANK_SIZE - 1] = static_cast<uint8_t>(bank >> 8);
+    }
+    return rom;
+}
+
+void test_rom_only() {
+    std::vector<uint8_t> rom = make_rom(2);
+    std::vector<uint8_t> ram(Mapper::RAM_BANK_SIZE, 0);
+    auto mapper = make_mapper(0x09, rom, ram);
+    assert(mapper->read_rom(0x0000) == 0 && mapper->read_rom(0x4000) == 1);
+    mapper->write_register(0x2000, 0x05); // no MBC, nothing happens
+    assert(mapper->read_rom(0x4000) == 1);
+    mapper->write_ram(0xA123, 0x42);
+    assert(mapper->read_ram(0xA123) == 0x42 && ram[0x123] == 0x42);
+
+    auto no_ram = make_mapper(0x00, rom, {});
+    assert(no_ram->read_ram(0xA000) == 0xFF);
+}
+
+void test_mbc1() {
+    std::vector<uint8_t> rom = make_rom(128); // 2 MB, needs the upper bank bits
+    std::vector<uint8_t> ram(4 * Mapper::RAM_BANK_SIZE, 0);
+    auto mapper = make_mapper(0x03, rom, ram);
+    assert(mapper->read_rom(0x4000) == 1);
+    mapper->write_register(0x2000, 0x00); // 0 reads as 1
+    assert(mapper->read_rom(0x4000) == 1);
+    mapper->write_register(0x2000, 0x1F);
+    mapper->write_register(0x4000, 0x02);
+    assert(mapper->read_rom(0x4000) == 0x5F);
+    assert(mapper->read_rom(0x0000) == 0); // mode 0: bank 0 fixed
+    mapper->write_register(0x6000, 0x01);
+    assert(mapper->read_rom(0x0000) == 0x40);
+
+    // RAM off until 0x0A, mode 1 banks it with bank2
+    assert(mapper->read_ram(0xA000) == 0xFF);
+    mapper->write_register(0x0000, 0x0A);
+    mapper->write_ram(0xA000, 0x77);
+    assert(ram[2 * Mapper::RAM_BANK_SIZE] == 0x77);
+    mapper->write_register(0x0000, 0x00);
+    mapper->write_ram(0xA001, 0x55);
+    assert(ram[2 * Mapper::RAM_BANK_SIZE + 1] == 0);
+
+    // Bank numbers wrap on smaller ROMs
+    std::vector<uint8_t> small = make_rom(4);
+    auto wrapped = make_mapper(0x01, small, {});
+    wrapped->write_register(0x2000, 0x06);
+    assert(wrapped->read_rom(0x4000) == 2);
+}
+
+void test_mbc2() {
+    std::vector<uint8_t> rom = make_rom(16);
+    std::vector<uint8_t> ram(0x200, 0);
+    auto mapper = make_mapper(0x06, rom, ram);
+    mapper->write_register(0x2100, 0x0B); // bit 8 set: ROM bank
+    assert(mapper->read_rom(0x4000) == 0x0B);
+    mapper->write_register(0x0000, 0x0A); // bit 8 clear: RAM enable
+    assert(mapper->read_rom(0x4000) == 0x0B);
+    mapper->write_ram(0xA005, 0x3C);
+    assert(ram[5] == 0x0C);
+    assert(mapper->read_ram(0xA005) == 0xFC);
+    assert(mapper->read_ram(0xA205) == 0xFC); // mirrored
+}
+
+void test_mbc3() {
+    std::vector<uint8_t> rom = make_rom(128);
+    std::vector<uint8_t> ram(4 * Mapper::RAM_BANK_SIZE, 0);
+    auto mapper = make_mapper(0x13, rom, ram);
+    mapper->write_register(0x2000, 0x7F);
+    assert(mapper->read_rom(0x4000) == 0x7F);
+    mapper->write_register(0x2000, 0x00);
+    assert(mapper->read_rom(0x4000) == 1);
+
+    mapper->write_register(0x0000, 0x0A);
+    mapper->write_register(0x4000, 0x03);
+    mapper->write_ram(0xA010, 0x99);
+    assert(ram[3 * Mapper::RAM_BANK_SIZE + 0x10] == 0x99);
+
+    // Clock registers aren't RAM, and 0x13 has no clock
+    mapper->write_register(0x4000, 0x08);
+    mapper->write_ram(0xA000, 0x21);
+    assert(mapper->read_ram(0xA000) == 0xFF);
+    assert(ram[3 * Mapper::RAM_BANK_SIZE] == 0);
+    mapper->write_register(0x4000, 0x03);
+    assert(mapper->read_ram(0xA010) == 0x99);
+}
+
+void test_mbc5() {
+    std::vector<uint8_t> rom = make_rom(512); // 8 MB, all 9 bank bits
+    std::vector<uint8_t> ram(16 * Mapper::RAM_BANK_SIZE, 0);
+    auto mapper = make_mapper(0x1B, rom, ram);
+    assert(mapper->read_rom(0x4000) == 1);
+    mapper->write_register(0x2000, 0x00); // bank 0 is allowed
+    assert(mapper->read_rom(0x4000) == 0);
+    mapper->write_register(0x2FFF, 0x34);
+    mapper->write_register(0x3000, 0x01);
+    assert(mapper->read_rom(0x4000) == 0x34 && mapper->read_rom(0x7FFF) == 0x01);
+    mapper->write_register(0x2000, 0xFF); // the high bit stays
+    assert(mapper->read_rom(0x4000) == 0xFF && mapper->read_rom(0x7FFF) == 0x01);
+    mapper->write_register(0x3000, 0x00);
+    assert(mapper->read_rom(0x7FFF) == 0x00);
+    assert(mapper->read_rom(0x0000) == 0);
+
+    // 16 RAM banks, enabled by 0x0A only
+    mapper->write_register(0x0000, 0x1A);
+    mapper->write_ram(0xA000, 0x11);
+    assert(mapper->read_ram(0xA000) == 0xFF && ram[0] == 0);
+    mapper->write_register(0x0000, 0x0A);
+    mapper->write_register(0x4000, 0x0F);
+    mapper->write_ram(0xA002, 0x22);
+    assert(ram[15 * Mapper::RAM_BANK_SIZE + 2] == 0x22);
+
+    // Rumble: bit 3 is the motor, not a bank bit
+    std::vector<uint8_t> rumble_ram(4 * Mapper::RAM_BANK_SIZE, 0);
+    auto rumble = make_mapper(0x1E, rom, rumble_ram);
+    rumble->write_register(0x0000, 0x0A);
+    rumble->write_register(0x4000, 0x09);
+    rumble->write_ram(0xA000, 0x33);
+    assert(rumble_ram[Mapper::RAM_BANK_SIZE] == 0x33);
+}
+
+int64_t fake_time = 1000000;
+int64_t fake_now() { return fake_time; }
+
+uint8_t read_clock(Mapper& mapper, uint8_t reg) {
+    mapper.write_register(0x4000, reg);
+    return mapper.read_ram(0xA000);
+}
+
+void test_mbc3_clock() {
+    std::vector<uint8_t> rom = make_rom(4);
+    std::vector<uint8_t> ram(Mapper::RAM_BANK_SIZE, 0);
+    Mbc3 mapper(rom, ram, true);
+    mapper.set_time_source(fake_now);
+    mapper.write_register(0x0000, 0x0A);
+
+    // Registers only change on a latch (0x00 then 0x01)
+    fake_time += 3 * 86400 + 2 * 3600 + 5 * 60 + 7;
+    assert(read_clock(mapper, 0x08) == 0);
+    mapper.write_register(0x6000, 0x00);
+    mapper.write_register(0x6000, 0x01);
+    assert(read_clock(mapper, 0x08) == 7);
+    assert(read_clock(mapper, 0x09) == 5);
+    assert(read_clock(mapper, 0x0A) == 2);
+    assert(read_clock(mapper, 0x0B) == 3);
+    assert(read_clock(mapper, 0x0C) == 0);
+    mapper.write_register(0x6000, 0x01); // no 0x00 first, no latch
+    fake_time += 10;
+    assert(read_clock(mapper, 0x08) == 7);
+
+    // Halted, time doesn't count. Writes set the running clock.
+    mapper.write_register(0x4000, 0x0C);
+    mapper.write_ram(0xA000, 0x40);
+    mapper.write_register(0x4000, 0x08);
+    mapper.write_ram(0xA000, 0x00);
+    mapper.write_register(0x4000, 0x0B);
+    mapper.write_ram(0xA000, 0xFF);
+    fake_time += 1000;
+    mapper.write_register(0x6000, 0x00);
+    mapper.write_register(0x6000, 0x01);
+    assert(read_clock(mapper, 0x08) == 0);
+    assert(read_clock(mapper, 0x0B) == 0xFF);
+    assert(read_clock(mapper, 0x0C) == 0x40);
+
+    // Running again, day 511 rolls over into carry
+    mapper.write_register(0x4000, 0x0C);
+    mapper.write_ram(0xA000, 0x01);
+    fake_time += 86400;
+    mapper.write_register(0x6000, 0x00);
+    mapper.write_register(0x6000, 0x01);
+    assert(read_clock(mapper, 0x0B) == 0);
+    assert(read_clock(mapper, 0x0C) == 0x80);
+
+    // The host clock steps back past the clock's zero: it restarts from 0 instead of going negative
+    mapper.write_register(0x4000, 0x0C);
+    mapper.write_ram(0xA000, 0x00);
+    fake_time -= 10 * 86400;
+    mapper.write_register(0x6000, 0x00);
+    mapper.write_register(0x6000, 0x01);
+    for (uint8_t reg = 0x08; reg <= 0x0C; reg++) assert(read_clock(mapper, reg) == 0);
+    fake_time += 65;
+    mapper.write_register(0x6000, 0x00);
+    mapper.write_register(0x6000, 0x01);
+    assert(read_clock(mapper, 0x08) == 5);
+    assert(read_clock(mapper, 0x09) == 1);
+
+    // Same for a save whose timestamp is ahead of the host: 10 s on the clock, saved an hour from now
+    std::vector<uint8_t> trailer(Mbc3::RTC_TRAILER_SIZE, 0);
+    trailer[0] = 10;
+    int64_t saved_at = fake_time + 3600;
+    for (int i = 0; i < 8; i++) trailer[40 + i] = static_cast<uint8_t>(saved_at >> (8 * i));
+    Mbc3 future(rom, ram, true);
+    future.set_time_source(fake_now);
+    future.read_save_trailer(trailer);
+    future.write_register(0x0000, 0x0A);
+    future.write_register(0x6000, 0x00);
+    future.write_register(0x6000, 0x01);
+    for (uint8_t reg = 0x08; reg <= 0x0C; reg++) assert(read_clock(future, reg) == 0);
+    fake_time += 3;
+    future.write_register(0x6000, 0x00);
+    future.write_register(0x6000, 0x01);
+    assert(read_clock(future, 0x08) == 3);
+
+    // Without TIMER there's no clock
+    Mbc3 no_clock(rom, ram, false);
+    no_clock.write_register(0x0000, 0x0A);
+    assert(read_clock(no_clock, 0x08) == 0xFF);
+    assert(no_clock.dirty_pages().size() == ram.size() / Mapper::SAVE_PAGE_SIZE);
+}
+
+// Bank registers come back from a save state, and the clock with the value it had when saved
+void test_serialize() {
+    std::vector<uint8_t> rom = make_rom(16);
+    std::vector<uint8_t> ram(0x200, 0);
+    auto mbc2 = make_mapper(0x06, rom, ram);
+    mbc2->write_register(0x2100, 0x0B);
+    mbc2->write_register(0x0000, 0x0A);
+    StateWriter out;
+    mbc2->serialize(out);
+    mbc2->write_register(0x2100, 0x03);
+    mbc2->write_register(0x0000, 0x00);
+    StateReader in(out.data());
+    mbc2->deserialize(in);
+    assert(mbc2->read_rom(0x4000) == 0x0B);
+    mbc2->write_ram(0xA001, 0x05);
+    assert(ram[1] == 0x05);
+
+    std::vector<uint8_t> clock_rom = make_rom(4);
+    std::vector<uint8_t> clock_ram(Mapper::RAM_BANK_SIZE, 0);
+    Mbc3 mbc3(clock_rom, clock_ram, true);
+    mbc3.set_time_source(fake_now);
+    mbc3.write_register(0x0000, 0x0A);
+    mbc3.write_register(0x2000, 0x02);
+    fake_time += 100;
+    StateWriter clock_out;
+    mbc3.serialize(clock_out);
+    fake_time += 5000;
+    mbc3.write_register(0x2000, 0x03);
+    StateReader clock_in(clock_out.data());
+    mbc3.deserialize(clock_in);
+    assert(mbc3.read_rom(0x4000) == 0x02);
+    fake_time += 25;
+    mbc3.write_register(0x6000, 0x00);
+    mbc3.write_register(0x6000, 0x01);
+    assert(read_clock(mbc3, 0x08) == 5);
+    assert(read_clock(mbc3, 0x09) == 2);
+}
+
+int main() {
+    std::cout << "----------------Running Mapper Tests----------------" << std::endl;
+
+    std::cout << "* test_rom_only" << std::endl;
+    test_rom_only();
+
+    std::cout << "* test_mbc1" << std::endl;
+    test_mbc1();
+
+    std::cout << "* test_mbc2" << std::endl;
+    test_mbc2();
+
+    std::cout << "* test_mbc3" << std::endl;
+    test_mbc3();
+
+    std::cout << "* test_mbc3_clock" << std::endl;
+    test_mbc3_clock();
+
+    std::cout << "* test_mbc5" << std::endl;
+    test_mbc5();
+
+    std::cout << "* test_serialize" << std::endl;
+    test_serialize();
+
+    return 0;
+}
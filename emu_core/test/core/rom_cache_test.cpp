@@ -0,0 +1,92 @@
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "rom_cache.hpp"
+#include "cart.hpp"
+#include "file_test_helpers.hpp"
+
+// 64 KB MBC1 ROM, every bank starts with its number plus `tag`
+std::vector<uint8_t> make_rom(uint8_t tag) {
+    std::vector<uint8_t> rom(0x10000, 0);
+    for (int bank = 0; bank < 4; bank++) rom[bank * 0x4000] = static_cast<uint8_t>(tag + bank);
+    rom[0x0147] = 0x01;
+    rom[0x0148] = 0x01;
+    return rom;
+}
+
+void test_shared_by_file_and_content() {
+    RomCache& cache = RomCache::shared();
+    write_file("rom_cache_a.gb", make_rom(0x10));
+    write_file("rom_cache_copy.gb", make_rom(0x10));
+    write_file("rom_cache_b.gb", make_rom(0x20));
+    {
+        auto a = cache.load_file("rom_cache_a.gb");
+        auto a_again = cache.load_file("rom_cache_a.gb");
+        auto copy = cache.load_file("rom_cache_copy.gb"); // another file, same bytes
+        auto b = cache.load_file("rom_cache_b.gb");
+        assert(a == a_again && a == copy);
+        assert(a != b && a->content_hash() != b->content_hash());
+        assert(cache.live_images() == 2);
+        assert(a->bytes()[0x4000] == 0x11 && b->bytes()[0x4000] == 0x21);
+    }
+    // The cache doesn't keep anything alive
+    assert(cache.live_images() == 0);
+    std::remove("rom_cache_a.gb");
+    std::remove("rom_cache_copy.gb");
+    std::remove("rom_cache_b.gb");
+}
+
+void test_data_and_padding() {
+    RomCache& cache = RomCache::shared();
+    std::vector<uint8_t> small(0x6000, 0x42);
+    auto image = cache.load_data(small);
+    auto same = cache.load_data(small);
+    assert(image == same);
+    assert(image->original_size() == 0x6000);
+    assert(image->bytes().size() == 0x8000);
+    assert(image->bytes()[0x5FFF] == 0x42 && image->bytes()[0x6000] == 0xFF);
+
+    // A file with the same bytes is the same image
+    write_file("rom_cache_small.gb", small);
+    assert(cache.load_file("rom_cache_small.gb") == image);
+    std::remove("rom_cache_small.gb");
+}
+
+// Each cart banks on its own, the ROM is shared
+void test_carts_share_rom() {
+    write_file("rom_cache_cart.gb", make_rom(0xB0));
+    Cart first;
+    Cart second;
+    first.loadFromFile("rom_cache_cart.gb");
+    second.loadFromFile("rom_cache_cart.gb");
+    assert(RomCache::shared().live_images() == 1);
+    first.write(0x2000, 0x03);
+    second.write(0x2000, 0x02);
+    assert(first.read(0x4000) == 0xB3);
+    assert(second.read(0x4000) == 0xB2);
+    std::remove("rom_cache_cart.gb");
+
+    bool threw = false;
+    write_file("rom_cache_tiny.gb", std::vector<uint8_t>(0x100, 0));
+    Cart tiny;
+    try { tiny.loadFromFile("rom_cache_tiny.gb"); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+    std::remove("rom_cache_tiny.gb");
+}
+
+int main() {
+    std::cout << "----------------Running ROM Cache Tests----------------" << std::endl;
+
+    std::cout << "* test_shared_by_file_and_content" << std::endl;
+    test_shared_by_file_and_content();
+
+    std::cout << "* test_data_and_padding" << std::endl;
+    test_data_and_padding();
+
+    std::cout << "* test_carts_share_rom" << std::endl;
+    test_carts_share_rom();
+
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include <iostream>
+#include <cassert>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "rom_index.hpp"
+#include "file_test_helpers.hpp"
+
+namespace fs = std::filesystem;
+
+// 32 KB with a valid header checksum, the fill byte makes the content differ
+std::vector<uint8_t> make_rom(const std::string& title, uint8_t fill) {
+    std::vector<uint8_t> rom(0x8000, fill);
+    for (size_t i = 0; i < 0x10; i++) rom[0x0134 + i] = i < title.size() ? title[i] : 0;
+    rom[0x0147] = 0x13;
+    rom[0x0148] = 0x00;
+    rom[0x0149] = 0x03;
+    uint8_t checksum = 0;
+    for (uint16_t addr = 0x0134; addr <= 0x014C; addr++) checksum = checksum - rom[addr] - 1;
+    rom[0x014D] = checksum;
+    rom[0x014E] = 0x12;
+    rom[0x014F] = 0x34;
+    return rom;
+}
+
+void test_hash() {
+    std::vector<uint8_t> data(1000);
+    for (size_t i = 0; i < data.size(); i++) data[i] = static_cast<uint8_t>(i * 13);
+    uint64_t hash = rom_hash(data);
+    assert(hash == rom_hash(data));
+    // Every length takes a different path through the tail loops, one flipped bit anywhere has to show
+    for (size_t size : {0, 1, 7, 8, 31, 32, 33, 100, 1000}) {
+        std::span<const uint8_t> prefix(data.data(), size);
+        std::vector<uint8_t> flipped(prefix.begin(), prefix.end());
+        for (size_t i = 0; i < size; i++) {
+            flipped[i] ^= 0x10;
+            assert(rom_hash(flipped) != rom_hash(prefix));
+            flipped[i] ^= 0x10;
+        }
+    }
+    assert(rom_hash(std::span<const uint8_t>(data.data(), 10)) != rom_hash(std::span<const uint8_t>(data.data(), 11)));
+}
+
+void test_header() {
+    RomEntry entry;
+    std::vector<uint8_t> rom = make_rom("POKEMON", 0);
+    assert(RomIndex::parse_header(rom, entry));
+    assert(entry.title == "POKEMON");
+    assert(entry.cart_type == 0x13 && entry.ram_size == 0x03 && entry.global_checksum == 0x1234);
+    assert(entry.header_ok);
+    rom[0x0140] ^= 1;
+    assert(RomIndex::parse_header(rom, entry) && !entry.header_ok);
+    assert(!RomIndex::parse_header(std::span<const uint8_t>(rom.data(), 0x100), entry));
+
+    assert(RomIndex::is_rom_path("a/b/Tetris.GB") && RomIndex::is_rom_path("x.gbc"));
+    assert(!RomIndex::is_rom_path("x.sav") && !RomIndex::is_rom_path("gb"));
+}
+
+void test_incremental_scan() {
+    fs::path root = fs::temp_directory_path() / "rom_index_test";
+    fs::remove_all(root);
+    fs::create_directories(root / "nested");
+    write_file(root / "a.gb", make_rom("ALPHA", 1));
+    write_file(root / "nested" / "b.gbc", make_rom("BETA", 2));
+    write_file(root / "c.sav", std::vector<uint8_t>(0x2000, 0));
+    write_file(root / "tiny.gb", std::vector<uint8_t>(0x40, 0));
+    std::string index_path = (root / "rom_index.tsv").string();
+
+    ThreadPool pool(3);
+    RomIndex index;
+    RomIndex::ScanStats stats = index.scan(root.string(), pool);
+    assert(stats.read == 2 && stats.unchanged == 0 && stats.failed == 1);
+    assert(index.get_entries().size() == 2);
+    assert(index.get_entries()[0].title == "ALPHA" && index.get_entries()[1].title == "BETA");
+    assert(index.get_entries()[0].hash == rom_hash(make_rom("ALPHA", 1)));
+    index.save(index_path);
+
+    // Loaded back, nothing changed so nothing gets read
+    RomIndex loaded;
+    loaded.load(index_path);
+    assert(loaded.get_entries().size() == 2);
+    assert(loaded.get_entries()[1].path == index.get_entries()[1].path);
+    assert(loaded.get_entries()[1].hash == index.get_entries()[1].hash);
+    assert(loaded.get_entries()[1].global_checksum == 0x1234);
+    stats = loaded.scan(root.string(), pool);
+    assert(stats.read == 0 && stats.unchanged == 2 && stats.removed == 0);
+
+    // Changed size, new file, deleted file
+    std::vector<uint8_t> bigger = make_rom("ALPHA2", 3);
+    bigger.resize(0x10000, 3);
+    write_file(root / "a.gb", bigger);
+    write_file(root / "nested" / "d.gb", make_rom("DELTA", 4));
+    fs::remove(root / "nested" / "b.gbc");
+    stats = loaded.scan(root.string(), pool);
+    assert(stats.read == 2 && stats.unchanged == 0 && stats.removed == 1);
+    assert(loaded.get_entries().size() == 2);
+    assert(loaded.get_entries()[0].title == "ALPHA2" && loaded.get_entries()[0].size == 0x10000);
+    assert(loaded.get_entries()[1].title == "DELTA");
+
+    fs::remove_all(root);
+}
+
+int main() {
+    std::cout << "----------------Running ROM Index Tests----------------" << std::endl;
+
+    std::cout << "* test_hash" << std::endl;
+    test_hash();
+
+    std::cout << "* test_header" << std::endl;
+    test_header();
+
+    std::cout << "* test_incremental_scan" << std::endl;
+    test_incremental_scan();
+
+    return 0;
+}
@@ -0,0 +1,153 @@
+#include <iostream>
+#include <cassert>
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+#include <vector>
+#include "save_state.hpp"
+
+/**
+ * MBC1 + RAM + battery. Turns the timer and cart RAM on, then loops: counts at 0xC000, copies the count to cart RAM,
+ * NR12 and the ROM bank register, so memory, banks, timer, PPU and APU all keep changing.
+ */
+std::vector<uint8_t> make_rom(uint8_t title) {
+    std::vector<uint8_t> rom(0x10000, 0);
+    const std::vector<uint8_t> program = {
+        0x3E, 0x05, 0xE0, 0x07,       // TAC = 0x05
+        0x3E, 0x0A, 0xEA, 0x00, 0x00, // RAM enable
+        0x21, 0x00, 0xC0,             // loop: LD HL, 0xC000
+        0x34,                         // INC (HL)
+        0x7E,                         // LD A, (HL)
+        0xEA, 0x00, 0xA0,             // LD (0xA000), A
+        0xE0, 0x12,                   // LDH (0x12), A
+        0xEA, 0x00, 0x20,             // LD (0x2000), A
+        0x18, 0xF1,                   // JR loop
+    };
+    std::copy(program.begin(), program.end(), rom.begin() + 0x100);
+    rom[0x0134] = title;
+    rom[0x0147] = 0x03;
+    rom[0x0149] = 0x02; // 8 KB
+    return rom;
+}
+
+struct Machine {
+    Cart cart;
+    PPU ppu;
+    NullAudioSink sink;
+    APU apu{sink};
+    Timer timer;
+    Bus bus{cart, ppu, timer, apu};
+    Registers registers;
+    CPU cpu{bus, registers};
+    SaveState state{cpu, bus, cart, ppu, timer, apu};
+
+    explicit Machine(uint8_t title = 'A') {
+        cart.loadFromData(make_rom(title));
+        apu.init();
+    }
+
+    void run(int instructions) {
+        for (int i = 0; i < instructions; i++) {
+            int cycles = cpu.step();
+            bool apu_div_tick = timer.tick(cycles);
+            ppu.tick(cycles);
+            apu.tick(cycles, apu_div_tick);
+        }
+    }
+};
+
+void test_round_trip() {
+    Machine machine;
+    machine.run(50000);
+    std::vector<uint8_t> saved = machine.state.save();
+    assert(saved.size() > SaveState::HEADER_SIZE + Bus::WRAM_SIZE + PPU::FRAME_BUFFER_SIZE + 0x2000);
+    machine.run(100000);
+    std::vector<uint8_t> later = machine.state.save();
+    assert(later != saved);
+
+    // Back to the saved state, the same instructions have to end up in the same place
+    machine.state.load(saved);
+    assert(machine.state.save() == saved);
+    machine.run(100000);
+    assert(machine.state.save() == later);
+
+    // And into a machine that never ran
+    Machine other;
+    other.state.load(saved);
+    other.run(100000);
+    assert(other.state.save() == later);
+    assert(other.cart.get_ram() == machine.cart.get_ram());
+}
+
+void test_rejected() {
+    Machine machine;
+    machine.run(20000);
+    std::vector<uint8_t> saved = machine.state.save();
+    Machine different('B');
+    different.run(20000);
+    std::vector<uint8_t> before = different.state.save();
+
+    auto rejected = [&](const std::vector<uint8_t>& state) {
+        try {
+            different.state.load(state);
+        } catch (const std::runtime_error&) {
+            // Nothing may have changed
+            assert(different.state.save() == before);
+            return true;
+        }
+        return false;
+    };
+    assert(rejected(saved)); // other ROM
+
+    machine.run(1000);
+    std::vector<uint8_t> state = machine.state.save();
+    std::vector<uint8_t> truncated(state.begin(), state.end() - 100);
+    std::vector<uint8_t> corrupted = state;
+    corrupted[corrupted.size() / 2] ^= 0x01;
+    std::vector<uint8_t> newer = state;
+    newer[4] = SaveState::VERSION + 1;
+    std::vector<uint8_t> not_a_state(100, 0);
+    // machine is the one loading these, its own state was fine
+    before = machine.state.save();
+    auto rejected_by_machine = [&](const std::vector<uint8_t>& bad) {
+        try {
+            machine.state.load(bad);
+        } catch (const std::runtime_error&) {
+            assert(machine.state.save() == before);
+            return true;
+        }
+        return false;
+    };
+    assert(rejected_by_machine(truncated));
+    assert(rejected_by_machine(corrupted));
+    assert(rejected_by_machine(newer));
+    assert(rejected_by_machine(not_a_state));
+    assert(rejected_by_machine({}));
+}
+
+void test_file() {
+    std::string path = (std::filesystem::temp_directory_path() / "save_state_test.state").string();
+    Machine machine;
+    machine.run(30000);
+    machine.state.save_file(path);
+    std::vector<uint8_t> saved = machine.state.save();
+    machine.run(30000);
+    machine.state.load_file(path);
+    assert(machine.state.save() == saved);
+    std::filesystem::remove(path);
+}
+
+int main() {
+    std::cout << "----------------Running Save State Tests----------------" << std::endl;
+
+    std::cout << "* test_round_trip" << std::endl;
+    test_round_trip();
+
+    std::cout << "* test_rejected" << std::endl;
+    test_rejected();
+
+    std::cout << "* test_file" << std::endl;
+    test_file();
+
+    return 0;
+}
@@ -0,0 +1,150 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "mapper.hpp"
+#include "save_writer.hpp"
+#include "file_test_helpers.hpp"
+
+// Plays the emulation thread: collect() once a "frame" until the writer has flushed `flushes` times
+void run_until_flushed(SaveWriter& writer, uint64_t flushes) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (writer.flush_count() < flushes) {
+        assert(std::chrono::steady_clock::now() < deadline);
+        writer.collect();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void test_dirty_pages() {
+    std::vector<uint8_t> rom(2 * Mapper::ROM_BANK_SIZE, 0);
+    std::vector<uint8_t> ram(4 * Mapper::RAM_BANK_SIZE, 0);
+    auto mapper = make_mapper(0x1B, rom, ram);
+    std::span<uint8_t> dirty = mapper->dirty_pages();
+    assert(dirty.size() == ram.size() / Mapper::SAVE_PAGE_SIZE);
+
+    mapper->write_register(0x0000, 0x0A);
+    mapper->write_register(0x4000, 0x02);
+    mapper->write_ram(0xA345, 0x12);
+    size_t page = (2 * Mapper::RAM_BANK_SIZE + 0x345) / Mapper::SAVE_PAGE_SIZE;
+    for (size_t i = 0; i < dirty.size(); i++) assert(dirty[i] == (i == page));
+
+    // Disabled RAM doesn't change, so nothing gets dirty
+    dirty[page] = 0;
+    mapper->write_register(0x0000, 0x00);
+    mapper->write_ram(0xA000, 0x34);
+    for (uint8_t flag : dirty) assert(flag == 0);
+}
+
+void test_background_flush() {
+    const std::string path = "save_writer_test.sav";
+    std::remove(path.c_str());
+    std::vector<uint8_t> rom(2 * Mapper::ROM_BANK_SIZE, 0);
+    std::vector<uint8_t> ram(Mapper::RAM_BANK_SIZE, 0);
+    auto mapper = make_mapper(0x03, rom, ram);
+    mapper->write_register(0x0000, 0x0A);
+
+    SaveWriter writer(path, ram, *mapper, std::chrono::milliseconds(5));
+    mapper->write_ram(0xA010, 0x11);
+    mapper->write_ram(0xBFFF, 0x22);
+    run_until_flushed(writer, 1);
+    assert(read_file(path) == ram);
+
+    // Later flushes reuse the previous save as the new .tmp, it has to catch up on what it missed
+    for (uint64_t flush = 2; flush <= 5; flush++) {
+        mapper->write_ram(0xA000 + flush * 0x300, static_cast<uint8_t>(flush));
+        run_until_flushed(writer, flush);
+        assert(read_file(path) == ram);
+    }
+
+    // Whatever is dirty at close gets written, even without a handoff
+    mapper->write_ram(0xA800, 0x99);
+    writer.close();
+    assert(read_file(path) == ram);
+    std::remove(path.c_str());
+    std::remove((path + ".tmp").c_str());
+}
+
+void test_nothing_dirty() {
+    const std::string path = "save_writer_clean_test.sav";
+    std::remove(path.c_str());
+    std::vector<uint8_t> rom(2 * Mapper::ROM_BANK_SIZE, 0);
+    std::vector<uint8_t> ram(Mapper::RAM_BANK_SIZE, 0);
+    auto mapper = make_mapper(0x03, rom, ram);
+    {
+        SaveWriter writer(path, ram, *mapper, std::chrono::milliseconds(1));
+        for (int i = 0; i < 20; i++) {
+            writer.collect();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        assert(writer.flush_count() == 0);
+    }
+    // An unchanged save isn't rewritten, there wasn't one so there still isn't
+    assert(!std::ifstream(path).good());
+}
+
+int64_t fake_time = 1700000000;
+int64_t fake_now() { return fake_time; }
+
+// MBC3 + TIMER: the clock goes after the RAM and changes to it get saved like RAM does
+void test_clock_trailer() {
+    const std::string path = "save_writer_clock_test.sav";
+    std::remove(path.c_str());
+    std::vector<uint8_t> rom(2 * Mapper::ROM_BANK_SIZE, 0);
+    std::vector<uint8_t> ram(Mapper::RAM_BANK_SIZE, 0);
+    Mbc3 mapper(rom, ram, true);
+    mapper.set_time_source(fake_now);
+    assert(mapper.dirty_pages().size() == ram.size() / Mapper::SAVE_PAGE_SIZE + 1);
+
+    SaveWriter writer(path, ram, mapper, std::chrono::milliseconds(5));
+    mapper.write_register(0x0000, 0x0A);
+    mapper.write_register(0x4000, 0x0A); // hours
+    mapper.write_ram(0xA000, 5);
+    fake_time += 30;
+    run_until_flushed(writer, 1);
+    writer.close();
+
+    std::vector<uint8_t> file = read_file(path);
+    assert(file.size() == ram.size() + Mbc3::RTC_TRAILER_SIZE);
+    const uint8_t* trailer = file.data() + ram.size();
+    assert(trailer[0] == 30 && trailer[8] == 5);
+    assert(trailer[40] == (fake_time & 0xFF));
+
+    // Loaded an hour later, the clock has kept going
+    std::vector<uint8_t> loaded_ram(Mapper::RAM_BANK_SIZE, 0);
+    Mbc3 loaded(rom, loaded_ram, true);
+    loaded.set_time_source(fake_now);
+    fake_time += 3600;
+    loaded.read_save_trailer(std::span<const uint8_t>(file).subspan(ram.size()));
+    loaded.write_register(0x0000, 0x0A);
+    loaded.write_register(0x6000, 0x00);
+    loaded.write_register(0x6000, 0x01);
+    loaded.write_register(0x4000, 0x0A);
+    assert(loaded.read_ram(0xA000) == 6);
+    loaded.write_register(0x4000, 0x08);
+    assert(loaded.read_ram(0xA000) == 30);
+    std::remove(path.c_str());
+    std::remove((path + ".tmp").c_str());
+}
+
+int main() {
+    std::cout << "----------------Running Save Writer Tests----------------" << std::endl;
+
+    std::cout << "* test_dirty_pages" << std::endl;
+    test_dirty_pages();
+
+    std::cout << "* test_background_flush" << std::endl;
+    test_background_flush();
+
+    std::cout << "* test_nothing_dirty" << std::endl;
+    test_nothing_dirty();
+
+    std::cout << "* test_clock_trailer" << std::endl;
+    test_clock_trailer();
+
+    return 0;
+}
@@ -0,0 +1,145 @@
+#include <iostream>
+#include <cassert>
+#include <cstdint>
+#include <random>
+#include "timer.hpp"
+
+/**
+ * The timer the slow way: a counter stepped one M cycle at a time, TIMA clocked on every falling edge of
+ * (TAC enable AND selected bit). Timer has to read back the same at every point.
+ */
+class ReferenceTimer {
+    public:
+        uint16_t counter = 0x18 << 6;
+        uint8_t tima = 0, tma = 0, tac = 0;
+        bool reloading = false;
+        bool interrupt = false;
+
+        bool input() const {
+            static constexpr int BITS[4] = {7, 1, 3, 5};
+            return (tac & 0x04) && ((counter >> BITS[tac & 0x03]) & 1);
+        }
+        void increment() {
+            if (tima == 0xFF) { tima = 0; reloading = true; } else tima++;
+        }
+        // Returns true when DIV bit 4 fell
+        bool cycle() {
+            if (reloading) { tima = tma; interrupt = true; reloading = false; }
+            bool input_before = input();
+            bool div_bit4 = counter & (1 << 10);
+            counter = (counter + 1) & 0x3FFF;
+            if (input_before && !input()) increment();
+            return div_bit4 && !(counter & (1 << 10));
+        }
+        bool write(uint16_t addr, uint8_t data) {
+            bool input_before = input();
+            bool apu_div_tick = false;
+            if (addr == 0xFF04) {
+                apu_div_tick = counter & (1 << 10);
+                counter = 0;
+            } else if (addr == 0xFF05) {
+                reloading = false;
+                tima = data;
+            } else if (addr == 0xFF06) {
+                tma = data;
+            } else if (addr == 0xFF07) {
+                tac = data & 0x0F;
+            }
+            if (input_before && !input()) increment();
+            return apu_div_tick;
+        }
+        uint8_t read(uint16_t addr) const {
+            if (addr == 0xFF04) return counter >> 6;
+            if (addr == 0xFF05) return tima;
+            if (addr == 0xFF06) return tma;
+            return tac;
+        }
+};
+
+void test_div() {
+    Timer timer;
+    assert(timer.read_timer(0xFF04) == 0x18);
+    timer.write_timer(0xFF04, 0x55);
+    assert(timer.read_timer(0xFF04) == 0x00);
+    timer.tick(63);
+    assert(timer.read_timer(0xFF04) == 0x00);
+    timer.tick(1);
+    assert(timer.read_timer(0xFF04) == 0x01);
+
+    // Frame sequencer clock: once every 2048 M cycles, whatever the tick sizes
+    int apu_ticks = 0;
+    for (int i = 0; i < 2048 * 10; i += 4) apu_ticks += timer.tick(4);
+    assert(apu_ticks == 10);
+}
+
+void test_overflow() {
+    Timer timer;
+    timer.write_timer(0xFF04, 0);
+    timer.write_timer(0xFF06, 0xF0);
+    timer.write_timer(0xFF05, 0xFE);
+    timer.write_timer(0xFF07, 0x05); // every 4 M cycles
+    timer.tick(4);
+    assert(timer.read_timer(0xFF05) == 0xFF);
+    timer.tick(4);
+    // Wrapped, TMA comes one cycle later
+    assert(timer.read_timer(0xFF05) == 0x00);
+    assert(!timer.interrupt);
+    timer.tick(1);
+    assert(timer.read_timer(0xFF05) == 0xF0);
+    assert(timer.interrupt);
+}
+
+void test_write_glitches() {
+    Timer timer;
+    timer.write_timer(0xFF04, 0);
+    timer.write_timer(0xFF07, 0x05); // counter bit 1
+    timer.tick(2);
+    // DIV reset while the selected bit is high is a falling edge
+    timer.write_timer(0xFF04, 0);
+    assert(timer.read_timer(0xFF05) == 1);
+    timer.tick(2);
+    // So is turning the timer off
+    timer.write_timer(0xFF07, 0x01);
+    assert(timer.read_timer(0xFF05) == 2);
+}
+
+void test_matches_reference() {
+    std::mt19937 rng(42);
+    Timer timer;
+    ReferenceTimer reference;
+    static constexpr uint16_t REGISTERS[4] = {0xFF04, 0xFF05, 0xFF06, 0xFF07};
+
+    for (int step = 0; step < 2000000; step++) {
+        if (rng() % 64 == 0) {
+            uint16_t addr = REGISTERS[rng() % 4];
+            uint8_t data = (addr == 0xFF05 || addr == 0xFF06) ? 0xF0 | (rng() & 0x0F) : rng() & 0xFF;
+            assert(timer.write_timer(addr, data) == reference.write(addr, data));
+        }
+        int cycles = 1 + rng() % 6;
+        bool apu_div_tick = timer.tick(cycles);
+        bool reference_tick = false;
+        for (int i = 0; i < cycles; i++) reference_tick |= reference.cycle();
+        assert(apu_div_tick == reference_tick);
+        assert(timer.interrupt == reference.interrupt);
+        timer.interrupt = reference.interrupt = false;
+        for (uint16_t addr : REGISTERS) assert(timer.read_timer(addr) == reference.read(addr));
+    }
+}
+
+int main() {
+    std::cout << "----------------Running Timer Tests----------------" << std::endl;
+
+    std::cout << "* test_div" << std::endl;
+    test_div();
+
+    std::cout << "* test_overflow" << std::endl;
+    test_overflow();
+
+    std::cout << "* test_write_glitches" << std::endl;
+    test_write_glitches();
+
+    std::cout << "* test_matches_reference" << std::endl;
+    test_matches_reference();
+
+    return 0;
+}
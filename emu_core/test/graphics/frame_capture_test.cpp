@@ -0,0 +1,235 @@
+#include <iostream>
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "graphics/frame_capture.hpp"
+#include "graphics/palette.hpp"
+#include "../core/file_test_helpers.hpp"
+
+namespace fs = std::filesystem;
+
+static constexpr int PIXELS = FrameCapture::WIDTH * FrameCapture::HEIGHT;
+static constexpr size_t CHROMA_SIZE = 2 * (FrameCapture::WIDTH / 2) * (FrameCapture::HEIGHT / 2);
+static const std::string Y4M_HEADER = "YUV4MPEG2 W160 H144 F4194304:70224 Ip A1:1 C420jpeg\n";
+
+uint32_t get_be32(const std::vector<uint8_t>& data, size_t offset) {
+    return (static_cast<uint32_t>(data[offset]) << 24) | (data[offset + 1] << 16) | (data[offset + 2] << 8) |
+           data[offset + 3];
+}
+
+// Bit at a time, not the table the capture uses
+uint32_t reference_crc32(const uint8_t* data, size_t size) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+    return ~crc;
+}
+
+uint32_t reference_adler32(const std::vector<uint8_t>& data) {
+    uint64_t a = 1, b = 0;
+    for (uint8_t byte : data) {
+        a += byte;
+        b += a;
+    }
+    return static_cast<uint32_t>(((b % 65521) << 16) | (a % 65521));
+}
+
+uint8_t luma(int shade) {
+    return static_cast<uint8_t>(16 + DMG_PALETTE[shade][0] * 219 / 255);
+}
+
+// The frame number goes in the first 8 pixels so no two frames look the same, the rest is a pattern
+std::vector<uint8_t> make_frame(uint16_t number) {
+    std::vector<uint8_t> frame(PIXELS);
+    for (int i = 0; i < PIXELS; i++) frame[i] = static_cast<uint8_t>((i / 7 + i / FrameCapture::WIDTH) % 4);
+    for (int i = 0; i < 8; i++) frame[i] = (number >> (2 * i)) & 3;
+    return frame;
+}
+
+// Y4M frames as shade indices
+std::vector<std::vector<uint8_t>> read_y4m(const fs::path& path) {
+    std::vector<uint8_t> file = read_file(path);
+    assert(std::string(file.begin(), file.begin() + Y4M_HEADER.size()) == Y4M_HEADER);
+    const size_t frame_size = 6 + PIXELS + CHROMA_SIZE;
+    assert((file.size() - Y4M_HEADER.size()) % frame_size == 0);
+
+    std::vector<std::vector<uint8_t>> frames;
+    for (size_t at = Y4M_HEADER.size(); at < file.size(); at += frame_size) {
+        assert(std::string(file.begin() + at, file.begin() + at + 6) == "FRAME\n");
+        std::vector<uint8_t> shades(PIXELS);
+        for (int i = 0; i < PIXELS; i++) {
+            uint8_t y = file[at + 6 + i];
+            int shade = 0;
+            while (shade < 4 && luma(shade) != y) shade++;
+            assert(shade < 4);
+            shades[i] = static_cast<uint8_t>(shade);
+        }
+        auto chroma = file.begin() + at + 6 + PIXELS;
+        assert(std::all_of(chroma, chroma + CHROMA_SIZE, [](uint8_t c) { return c == 128; }));
+        frames.push_back(shades);
+    }
+    return frames;
+}
+
+/**
+ * Checks the signature, every chunk CRC, IHDR and the zlib stream (header, stored blocks, adler32), then returns
+ * the shade indices.
+ */
+std::vector<uint8_t> read_png(const fs::path& path) {
+    std::vector<uint8_t> file = read_file(path);
+    const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    assert(file.size() > 8 && std::equal(signature, signature + 8, file.begin()));
+
+    std::vector<std::string> types;
+    std::vector<uint8_t> ihdr, idat;
+    for (size_t at = 8; at < file.size();) {
+        uint32_t length = get_be32(file, at);
+        assert(at + 12 + length <= file.size());
+        std::string type(file.begin() + at + 4, file.begin() + at + 8);
+        assert(get_be32(file, at + 8 + length) == reference_crc32(file.data() + at + 4, 4 + length));
+        std::vector<uint8_t> data(file.begin() + at + 8, file.begin() + at + 8 + length);
+        if (type == "IHDR") ihdr = data;
+        if (type == "IDAT") idat.insert(idat.end(), data.begin(), data.end());
+        types.push_back(type);
+        at += 12 + length;
+    }
+    assert((types == std::vector<std::string>{"IHDR", "PLTE", "IDAT", "IEND"}));
+    assert(get_be32(ihdr, 0) == FrameCapture::WIDTH && get_be32(ihdr, 4) == FrameCapture::HEIGHT);
+    assert(ihdr[8] == 2 && ihdr[9] == 3);
+
+    // CMF / FLG have to be a multiple of 31, no preset dictionary
+    assert((idat[0] << 8 | idat[1]) % 31 == 0 && (idat[1] & 0x20) == 0);
+    std::vector<uint8_t> raw;
+    size_t at = 2;
+    bool final_block = false;
+    while (!final_block) {
+        final_block = idat[at] & 1;
+        assert((idat[at] >> 1) == 0); // stored
+        uint16_t len = idat[at + 1] | (idat[at + 2] << 8);
+        uint16_t nlen = idat[at + 3] | (idat[at + 4] << 8);
+        assert(static_cast<uint16_t>(~len) == nlen);
+        raw.insert(raw.end(), idat.begin() + at + 5, idat.begin() + at + 5 + len);
+        at += 5 + len;
+    }
+    assert(at + 4 == idat.size());
+    assert(get_be32(idat, at) == reference_adler32(raw));
+
+    constexpr int ROW_BYTES = 1 + FrameCapture::WIDTH / 4;
+    assert(raw.size() == ROW_BYTES * FrameCapture::HEIGHT);
+    std::vector<uint8_t> shades(PIXELS);
+    for (int y = 0; y < FrameCapture::HEIGHT; y++) {
+        assert(raw[y * ROW_BYTES] == 0);
+        for (int x = 0; x < FrameCapture::WIDTH; x++) {
+            shades[y * FrameCapture::WIDTH + x] = (raw[y * ROW_BYTES + 1 + x / 4] >> (6 - 2 * (x % 4))) & 3;
+        }
+    }
+    return shades;
+}
+
+fs::path png_path(const fs::path& dir, int frame) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "frame_%06d.png", frame);
+    return dir / name;
+}
+
+fs::path test_dir() {
+    fs::path dir = fs::temp_directory_path() / "frame_capture_test";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    return dir;
+}
+
+// Few frames and plenty of slots, nothing is dropped
+void test_y4m_and_png() {
+    fs::path dir = test_dir();
+    std::vector<std::vector<uint8_t>> frames = {make_frame(0), make_frame(1), make_frame(2)};
+    {
+        FrameCapture capture((dir / "out.y4m").string(), (dir / "png").string(), 8, CaptureDropPolicy::DROP_NEWEST);
+        for (const auto& frame : frames) capture.submit_frame(frame.data());
+        capture.stop();
+        assert(capture.frames_written() == 3);
+        assert(capture.frames_dropped() == 0);
+    }
+
+    assert(read_y4m(dir / "out.y4m") == frames);
+    for (int i = 0; i < 3; i++) assert(read_png(png_path(dir / "png", i)) == frames[i]);
+    fs::remove_all(dir);
+}
+
+/**
+ * Two slots and frames coming in faster than they're written. Every frame is either written or dropped, the Y4M
+ * stands in the last written frame for dropped ones, and DROP_OLDEST always keeps the newest frame.
+ */
+void test_drops(CaptureDropPolicy policy) {
+    static constexpr int FRAMES = 300;
+    fs::path dir = test_dir();
+    FrameCapture capture((dir / "out.y4m").string(), (dir / "png").string(), 2, policy);
+    for (int i = 0; i < FRAMES; i++) capture.submit_frame(make_frame(static_cast<uint16_t>(i)).data());
+    capture.stop();
+
+    assert(capture.frames_dropped() > 0);
+    assert(capture.frames_written() + capture.frames_dropped() == FRAMES);
+    auto pngs = std::distance(fs::directory_iterator(dir / "png"), fs::directory_iterator());
+    assert(static_cast<uint64_t>(pngs) == capture.frames_written());
+
+    std::vector<std::vector<uint8_t>> y4m = read_y4m(dir / "out.y4m");
+    assert(!y4m.empty() && y4m.size() <= FRAMES);
+    if (policy == CaptureDropPolicy::DROP_OLDEST) assert(y4m.size() == FRAMES);
+    if (policy == CaptureDropPolicy::DROP_NEWEST) assert(fs::exists(png_path(dir / "png", 0)));
+    // Written frames show themselves, dropped ones the frame before (blank before the first one)
+    std::vector<uint8_t> shown(PIXELS, 0);
+    for (size_t i = 0; i < y4m.size(); i++) {
+        if (fs::exists(png_path(dir / "png", static_cast<int>(i)))) shown = make_frame(static_cast<uint16_t>(i));
+        assert(y4m[i] == shown);
+    }
+    fs::remove_all(dir);
+}
+
+void test_parse_drop_policy() {
+    CaptureDropPolicy policy = CaptureDropPolicy::DROP_NEWEST;
+    assert(FrameCapture::parse_drop_policy("oldest", policy) && policy == CaptureDropPolicy::DROP_OLDEST);
+    assert(FrameCapture::parse_drop_policy("newest", policy) && policy == CaptureDropPolicy::DROP_NEWEST);
+    assert(!FrameCapture::parse_drop_policy("latest", policy));
+}
+
+// A capture file that can't be opened throws, main reports it
+void test_unwritable_path() {
+    fs::path dir = test_dir();
+    bool threw = false;
+    try {
+        FrameCapture capture((dir / "missing" / "out.y4m").string(), "", 2, CaptureDropPolicy::DROP_NEWEST);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    fs::remove_all(dir);
+}
+
+int main() {
+    std::cout << "----------------Running Frame Capture Tests----------------" << std::endl;
+
+    std::cout << "* test_y4m_and_png" << std::endl;
+    test_y4m_and_png();
+
+    std::cout << "* test_drops (newest)" << std::endl;
+    test_drops(CaptureDropPolicy::DROP_NEWEST);
+
+    std::cout << "* test_drops (oldest)" << std::endl;
+    test_drops(CaptureDropPolicy::DROP_OLDEST);
+
+    std::cout << "* test_parse_drop_policy" << std::endl;
+    test_parse_drop_policy();
+
+    std::cout << "* test_unwritable_path" << std::endl;
+    test_unwritable_path();
+
+    return 0;
+}
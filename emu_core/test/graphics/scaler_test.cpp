@@ -0,0 +1,96 @@
+#include <iostream>
+#include <cassert>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "graphics/scaler.hpp"
+
+static constexpr int WIDTH = 160;
+static constexpr int HEIGHT = 144;
+
+/**
+ * Shade indices with runs, diagonals and single pixels mixed in, so every edge rule of Scale2x / Scale3x / xBR gets
+ * hit somewhere. Noise alone has almost no edges the filters act on.
+ */
+std::vector<uint8_t> make_frame() {
+    std::vector<uint8_t> frame(WIDTH * HEIGHT);
+    uint32_t seed = 12345;
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            seed = seed * 1664525 + 1013904223;
+            uint8_t shade = static_cast<uint8_t>((x / 8 + y / 8) % 4);
+            if (x == y || x + y == WIDTH) shade = 3 - shade;
+            if ((seed >> 28) == 0) shade = static_cast<uint8_t>((seed >> 24) & 3);
+            frame[y * WIDTH + x] = shade;
+        }
+    }
+    return frame;
+}
+
+std::vector<uint8_t> scale(ScaleFilter filter, int factor, ScalerIsa isa, const std::vector<uint8_t>& frame) {
+    Scaler scaler(filter, factor, WIDTH, HEIGHT, 2, isa);
+    std::vector<uint8_t> out(scaler.out_width() * scaler.out_height(), 0xFF);
+    scaler.scale(frame.data(), out.data());
+    return out;
+}
+
+void test_nearest_replicates() {
+    std::vector<uint8_t> frame = make_frame();
+    for (int factor = 1; factor <= SCALER_MAX_FACTOR; factor++) {
+        std::vector<uint8_t> out = scale(ScaleFilter::NEAREST, factor, ScalerIsa::SCALAR, frame);
+        for (int y = 0; y < HEIGHT * factor; y++) {
+            for (int x = 0; x < WIDTH * factor; x++) {
+                assert(out[y * WIDTH * factor + x] == frame[(y / factor) * WIDTH + x / factor]);
+            }
+        }
+    }
+}
+
+void test_unsupported_factors() {
+    auto rejected = [](ScaleFilter filter, int factor) {
+        try {
+            Scaler scaler(filter, factor, WIDTH, HEIGHT, 0);
+        } catch (const std::runtime_error&) {
+            return true;
+        }
+        return false;
+    };
+    for (ScaleFilter filter : {ScaleFilter::NEAREST, ScaleFilter::SCALEX, ScaleFilter::XBR}) {
+        for (int factor = -1; factor <= SCALER_MAX_FACTOR + 1; factor++) {
+            bool supported = factor >= Scaler::min_factor(filter) && factor <= SCALER_MAX_FACTOR;
+            assert(rejected(filter, factor) != supported);
+        }
+    }
+}
+
+// Every kernel has to give exactly what the scalar one gives, shades don't round
+void test_isas_agree() {
+    std::vector<uint8_t> frame = make_frame();
+    for (ScaleFilter filter : {ScaleFilter::NEAREST, ScaleFilter::SCALEX, ScaleFilter::XBR}) {
+        for (int factor = Scaler::min_factor(filter); factor <= SCALER_MAX_FACTOR; factor++) {
+            std::vector<uint8_t> expected = scale(filter, factor, ScalerIsa::SCALAR, frame);
+            for (ScalerIsa isa : Scaler::supported_isas()) {
+                if (scale(filter, factor, isa, frame) != expected) {
+                    std::cout << Scaler::filter_name(filter) << " " << factor << "x differs on "
+                              << Scaler::isa_name(isa) << std::endl;
+                    assert(false);
+                }
+            }
+        }
+    }
+}
+
+int main() {
+    std::cout << "----------------Running Scaler Tests----------------" << std::endl;
+
+    std::cout << "* test_nearest_replicates" << std::endl;
+    test_nearest_replicates();
+
+    std::cout << "* test_unsupported_factors" << std::endl;
+    test_unsupported_factors();
+
+    std::cout << "* test_isas_agree" << std::endl;
+    test_isas_agree();
+
+    return 0;
+}
@@ -0,0 +1,61 @@
+#include <iostream>
+#include <cassert>
+#include <thread>
+#include "triple_buffer.hpp"
+
+void test_publish_acquire() {
+    TripleBuffer<int> buffer;
+    assert(!buffer.acquire());
+
+    buffer.back() = 1;
+    assert(!buffer.publish());
+    assert(buffer.acquire());
+    assert(buffer.front() == 1);
+
+    // Nothing new published, the front slot keeps the last frame
+    assert(!buffer.acquire());
+    assert(buffer.front() == 1);
+}
+
+void test_drop_unconsumed() {
+    TripleBuffer<int> buffer;
+    buffer.back() = 1;
+    buffer.publish();
+    buffer.back() = 2;
+    assert(buffer.publish()); // frame 1 was never acquired
+    assert(buffer.acquire());
+    assert(buffer.front() == 2);
+}
+
+void test_threaded_frames_in_order() {
+    TripleBuffer<int> buffer;
+    constexpr int FRAMES = 100000;
+
+    std::thread producer([&] {
+        for (int i = 1; i <= FRAMES; i++) {
+            buffer.back() = i;
+            buffer.publish();
+        }
+    });
+
+    // Frames may be dropped, but never torn or seen out of order
+    int last = 0;
+    while (last != FRAMES) {
+        if (buffer.acquire()) {
+            assert(buffer.front() > last);
+            last = buffer.front();
+        }
+    }
+    producer.join();
+}
+
+int main() {
+    std::cout << "----------------Running Triple Buffer Tests----------------" << std::endl;
+    std::cout << "* test_publish_acquire" << std::endl;
+    test_publish_acquire();
+    std::cout << "* test_drop_unconsumed" << std::endl;
+    test_drop_unconsumed();
+    std::cout << "* test_threaded_frames_in_order" << std::endl;
+    test_threaded_frames_in_order();
+    return 0;
+}
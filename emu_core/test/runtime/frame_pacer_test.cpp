@@ -0,0 +1,90 @@
+#include <iostream>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include "runtime/frame_pacer.hpp"
+
+using namespace std::chrono;
+
+// Sleeps only ever run long, so pacing is checked from below and loosely from above
+static constexpr auto SLACK = milliseconds(2);
+
+void test_parse_mode() {
+    SyncMode mode = SyncMode::VSYNC;
+    assert(FramePacer::parse_mode("timer", mode) && mode == SyncMode::TIMER);
+    assert(FramePacer::parse_mode("vsync", mode) && mode == SyncMode::VSYNC);
+    assert(!FramePacer::parse_mode("adaptive", mode));
+}
+
+void test_timer_pacing() {
+    std::atomic<bool> running{true};
+    FramePacer pacer(SyncMode::TIMER, nullptr);
+    auto start = steady_clock::now();
+    for (int i = 0; i < 10; i++) pacer.wait_for_next_frame(running);
+    auto elapsed = steady_clock::now() - start;
+    assert(elapsed >= 10 * FramePacer::FRAME_DURATION - SLACK);
+    assert(elapsed < 10 * FramePacer::FRAME_DURATION + seconds(1));
+}
+
+// Far behind (over 100 ms) the pacer starts over from now instead of running frames back to back to catch up
+void test_timer_falls_behind() {
+    std::atomic<bool> running{true};
+    FramePacer pacer(SyncMode::TIMER, nullptr);
+    std::this_thread::sleep_for(milliseconds(300));
+    auto start = steady_clock::now();
+    pacer.wait_for_next_frame(running);
+    assert(steady_clock::now() - start < FramePacer::FRAME_DURATION);
+
+    start = steady_clock::now();
+    for (int i = 0; i < 3; i++) pacer.wait_for_next_frame(running);
+    assert(steady_clock::now() - start >= 3 * FramePacer::FRAME_DURATION - SLACK);
+}
+
+void test_vsync_waits_for_swap() {
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> swaps{0};
+    FramePacer pacer(SyncMode::VSYNC, &swaps);
+
+    // A swap already happened: no wait
+    swaps = 1;
+    swaps.notify_all();
+    auto start = steady_clock::now();
+    pacer.wait_for_next_frame(running);
+    assert(steady_clock::now() - start < milliseconds(50));
+
+    // Otherwise until the presenter swaps
+    std::thread presenter([&] {
+        std::this_thread::sleep_for(milliseconds(50));
+        swaps = 2;
+        swaps.notify_all();
+    });
+    start = steady_clock::now();
+    pacer.wait_for_next_frame(running);
+    assert(steady_clock::now() - start >= milliseconds(50) - SLACK);
+    assert(swaps == 2);
+    presenter.join();
+
+    // Shutting down never waits on a swap that won't come
+    running = false;
+    pacer.wait_for_next_frame(running);
+}
+
+int main() {
+    std::cout << "----------------Running Frame Pacer Tests----------------" << std::endl;
+
+    std::cout << "* test_parse_mode" << std::endl;
+    test_parse_mode();
+
+    std::cout << "* test_timer_pacing" << std::endl;
+    test_timer_pacing();
+
+    std::cout << "* test_timer_falls_behind" << std::endl;
+    test_timer_falls_behind();
+
+    std::cout << "* test_vsync_waits_for_swap" << std::endl;
+    test_vsync_waits_for_swap();
+
+    return 0;
+}
@@ -0,0 +1,117 @@
+#include <iostream>
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+#include "runtime/gbs_player.hpp"
+#include "../audio/apu_test_helpers.hpp"
+
+/**
+ * A tiny GBS loaded at 0x0400. init powers the APU on, reads NR51 from the first byte of bank 2 (so banking and
+ * the linear layout are checked too) and starts a tone. play counts its calls at 0xC000 and puts the count in NR50.
+ */
+std::vector<uint8_t> make_gbs(uint8_t timer_modulo, uint8_t timer_control) {
+    std::vector<uint8_t> file(GbsPlayer::HEADER_SIZE, 0);
+    const char magic[] = "GBS";
+    std::copy(magic, magic + 3, file.begin());
+    file[0x03] = 1;    // version
+    file[0x04] = 3;    // songs
+    file[0x05] = 1;    // first song
+    file[0x06] = 0x00; file[0x07] = 0x04; // load
+    file[0x08] = 0x00; file[0x09] = 0x04; // init
+    file[0x0A] = 0x30; file[0x0B] = 0x04; // play
+    file[0x0C] = 0xFE; file[0x0D] = 0xFF; // stack pointer
+    file[0x0E] = timer_modulo;
+    file[0x0F] = timer_control;
+    const char title[] = "Test Tune";
+    std::copy(title, title + sizeof(title) - 1, file.begin() + 0x10);
+
+    const std::vector<uint8_t> init = {
+        0x3E, 0x80, 0xE0, 0x26,       // NR52 = 0x80
+        0x3E, 0x77, 0xE0, 0x24,       // NR50 = 0x77
+        0x3E, 0x02, 0xEA, 0x00, 0x20, // bank 2
+        0xFA, 0x00, 0x40,             // LD A, (0x4000)
+        0xE0, 0x25,                   // NR51 = A
+        0x3E, 0x01, 0xEA, 0x00, 0x20, // bank 1
+        0x3E, 0xF0, 0xE0, 0x12,       // NR12
+        0x3E, 0x80, 0xE0, 0x11,       // NR11
+        0x3E, 0x00, 0xE0, 0x13,       // NR13
+        0x3E, 0x87, 0xE0, 0x14,       // NR14, trigger
+        0xAF, 0xEA, 0x00, 0xC0,       // (0xC000) = 0
+        0xC9,
+    };
+    const std::vector<uint8_t> play = {
+        0x21, 0x00, 0xC0,             // LD HL, 0xC000
+        0x34,                         // INC (HL)
+        0x7E,                         // LD A, (HL)
+        0xE6, 0x77,                   // AND 0x77
+        0xE0, 0x24,                   // NR50 = A
+        0xC9,
+    };
+    std::vector<uint8_t> code(0x8001 - 0x0400, 0x00);
+    std::copy(init.begin(), init.end(), code.begin());
+    std::copy(play.begin(), play.end(), code.begin() + 0x30);
+    code[0x8000 - 0x0400] = 0xAB; // bank 2, 0x4000
+    file.insert(file.end(), code.begin(), code.end());
+    return file;
+}
+
+void test_header() {
+    GbsHeader header = GbsPlayer::parse_header(make_gbs(0, 0));
+    assert(header.song_count == 3);
+    assert(header.load_addr == 0x0400 && header.play_addr == 0x0430);
+    assert(header.title == "Test Tune");
+    assert(header.author.empty());
+    assert(!header.uses_timer());
+
+    std::vector<uint8_t> bad = make_gbs(0, 0);
+    bad[0x06] = 0x00; bad[0x07] = 0x01; // load inside our stub area
+    bool threw = false;
+    try { GbsPlayer::parse_header(bad); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+
+    assert(GbsPlayer::is_gbs_path("music/Tune.GBS"));
+    assert(!GbsPlayer::is_gbs_path("roms/tetris.gb"));
+}
+
+void test_vblank_rate() {
+    CaptureSink sink;
+    APU apu(sink);
+    apu.init();
+    GbsPlayer player(make_gbs(0, 0), 0, apu);
+    assert(apu.apu_io_read(0xFF25) == 0xAB);
+
+    player.run(GbsPlayer::M_CYCLES_PER_SECOND);
+    apu.close();
+    assert(player.play_count() == GbsPlayer::M_CYCLES_PER_SECOND / GbsPlayer::CYCLES_PER_FRAME);
+    assert(player.late_plays() == 0);
+    assert(apu.apu_io_read(0xFF24) == (player.play_count() & 0x77));
+    assert(std::any_of(sink.samples.begin(), sink.samples.end(), [](int16_t s) { return s != 0; }));
+}
+
+void test_timer_rate() {
+    CaptureSink sink;
+    APU apu(sink);
+    apu.init();
+    // 4096 Hz timer, overflows every 64 ticks: 64 Hz after the first overflow from TIMA = 0
+    GbsPlayer player(make_gbs(0xC0, 0x04), 2, apu);
+    player.run(GbsPlayer::M_CYCLES_PER_SECOND);
+    apu.close();
+    assert(player.play_count() >= 60 && player.play_count() <= 62);
+    assert(apu.apu_io_read(0xFF24) == (player.play_count() & 0x77));
+}
+
+int main() {
+    std::cout << "----------------Running GBS Player Tests----------------" << std::endl;
+
+    std::cout << "* test_header" << std::endl;
+    test_header();
+
+    std::cout << "* test_vblank_rate" << std::endl;
+    test_vblank_rate();
+
+    std::cout << "* test_timer_rate" << std::endl;
+    test_timer_rate();
+
+    return 0;
+}
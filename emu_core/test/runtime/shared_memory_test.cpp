@@ -0,0 +1,181 @@
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "core/bus.hpp"
+#include "runtime/shared_memory.hpp"
+
+static const char* SHM_NAME = "/gbs_shared_memory_test";
+
+struct Machine {
+    Cart cart;
+    PPU ppu;
+    NullAudioSink sink;
+    APU apu{sink};
+    Timer timer;
+    Bus bus{cart, ppu, timer, apu};
+
+    Machine() {
+        std::vector<uint8_t> rom(0x8000, 0);
+        rom[0x0147] = 0x03; // MBC1 + RAM + battery
+        rom[0x0149] = 0x02; // 8 KB
+        cart.loadFromData(rom);
+    }
+
+    void fill_wram(uint8_t value) {
+        for (uint16_t addr = 0xC000; addr < 0xE000; addr++) bus.write(addr, value);
+    }
+};
+
+// Maps the segment read only, like an external tool would
+struct Reader {
+    const uint8_t* segment{nullptr};
+    size_t size{0};
+
+    Reader() {
+        int fd = shm_open(SHM_NAME, O_RDONLY, 0);
+        assert(fd >= 0);
+        struct stat info;
+        assert(fstat(fd, &info) == 0);
+        size = static_cast<size_t>(info.st_size);
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        assert(mapped != MAP_FAILED);
+        segment = static_cast<const uint8_t*>(mapped);
+    }
+    ~Reader() { munmap(const_cast<uint8_t*>(segment), size); }
+
+    const ShmHeader& header() const { return *reinterpret_cast<const ShmHeader*>(segment); }
+    const ShmRegion& region(ShmRegionId id) const {
+        return reinterpret_cast<const ShmRegion*>(segment + header().header_size)[id];
+    }
+};
+
+void test_layout_and_publish() {
+    Machine machine;
+    {
+        SharedMemoryExport shm(SHM_NAME, machine.bus, machine.ppu, machine.cart);
+        Reader reader;
+        assert(reader.header().magic == SHM_MAGIC);
+        assert(reader.header().version == SHM_VERSION);
+        assert(reader.header().region_count == SHM_REGION_COUNT);
+
+        const uint64_t sizes[SHM_REGION_COUNT] = {PPU::FRAME_BUFFER_SIZE, Bus::WRAM_SIZE, Bus::HRAM_SIZE, PPU::OAM_SIZE,
+                                                  0x2000};
+        for (uint32_t i = 0; i < SHM_REGION_COUNT; i++) {
+            const ShmRegion& region = reader.region(static_cast<ShmRegionId>(i));
+            assert(region.id == i);
+            assert(region.size == sizes[i]);
+            assert(region.offset % 64 == 0);
+            assert(region.offset + region.size <= reader.size);
+            assert(region.sequence.load() == 0);
+        }
+
+        machine.fill_wram(0x5A);
+        shm.publish(7);
+        const ShmRegion& wram = reader.region(SHM_WRAM);
+        assert(wram.sequence.load() == 2);
+        std::vector<uint8_t> out(wram.size);
+        uint64_t frame = 0;
+        assert(shm_read_region(reader.segment, wram, out.data(), &frame));
+        assert(frame == 7);
+        assert(std::equal(out.begin(), out.end(), machine.bus.get_wram()));
+    }
+    // Gone once the emulator is
+    assert(shm_open(SHM_NAME, O_RDONLY, 0) < 0);
+}
+
+// A second export under the same name fails and leaves the first one's segment alone
+void test_name_in_use() {
+    Machine machine;
+    SharedMemoryExport shm(SHM_NAME, machine.bus, machine.ppu, machine.cart);
+    Machine other;
+    bool threw = false;
+    try {
+        SharedMemoryExport second(SHM_NAME, other.bus, other.ppu, other.cart);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+
+    Reader reader;
+    assert(reader.header().magic == SHM_MAGIC);
+    machine.fill_wram(0x5A);
+    shm.publish(1);
+    std::vector<uint8_t> out(Bus::WRAM_SIZE);
+    uint64_t frame = 0;
+    assert(shm_read_region(reader.segment, reader.region(SHM_WRAM), out.data(), &frame));
+    assert(frame == 1 && out[0] == 0x5A);
+}
+
+void test_busy_region() {
+    uint8_t segment[64] = {};
+    ShmRegion region;
+    region.sequence.store(3);
+    region.offset = 0;
+    region.size = sizeof(segment);
+    uint8_t out[64];
+    assert(!shm_read_region(segment, region, out, nullptr, 5));
+    region.sequence.store(4);
+    assert(shm_read_region(segment, region, out, nullptr, 5));
+}
+
+// Frame n fills WRAM with n, a read that succeeds has to see one frame's bytes and that frame's number
+void test_no_torn_reads() {
+    Machine machine;
+    SharedMemoryExport shm(SHM_NAME, machine.bus, machine.ppu, machine.cart);
+    Reader reader;
+    const ShmRegion& wram = reader.region(SHM_WRAM);
+
+    static constexpr uint64_t FRAMES = 2000;
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+        for (uint64_t frame = 1; frame <= FRAMES; frame++) {
+            machine.fill_wram(static_cast<uint8_t>(frame));
+            shm.publish(frame);
+        }
+        done = true;
+    });
+
+    std::vector<uint8_t> out(wram.size);
+    uint64_t reads = 0, last_frame = 0;
+    while (!done) {
+        uint64_t frame;
+        if (!shm_read_region(reader.segment, wram, out.data(), &frame)) continue;
+        assert(frame >= last_frame);
+        uint8_t expected = static_cast<uint8_t>(frame);
+        assert(std::all_of(out.begin(), out.end(), [&](uint8_t b) { return b == expected; }));
+        last_frame = frame;
+        reads++;
+    }
+    writer.join();
+    assert(shm_read_region(reader.segment, wram, out.data(), &last_frame));
+    assert(last_frame == FRAMES);
+    assert(reads > 0);
+}
+
+int main() {
+    std::cout << "----------------Running Shared Memory Tests----------------" << std::endl;
+
+    std::cout << "* test_layout_and_publish" << std::endl;
+    test_layout_and_publish();
+
+    std::cout << "* test_name_in_use" << std::endl;
+    test_name_in_use();
+
+    std::cout << "* test_busy_region" << std::endl;
+    test_busy_region();
+
+    std::cout << "* test_no_torn_reads" << std::endl;
+    test_no_torn_reads();
+
+    return 0;
+}